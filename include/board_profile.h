@@ -0,0 +1,89 @@
+#ifndef BOARD_PROFILE_H
+#define BOARD_PROFILE_H
+
+#include <stdint.h>
+
+// Board wiring, fixed at compile time.
+// - One constexpr BoardProfile per hardware variant; the build picks one with
+//   -DVITRINE_BOARD=<BoardVariant> (see platformio.ini) and the firmware only reads kBoard.
+// - The controllers construct their drivers from kBoard as plain members of the global
+//   controller objects: static storage, sizes known at link time, nothing on the heap at boot.
+// - Every field is a constant expression: array sizes come from it and branches on optional
+//   pins (tftBlk < 0) fold away.
+
+// Addressable LED strip chipsets (byte order and white channel)
+enum class LedStripType : uint8_t {
+    Sk6812Grbw,  // RGBW, GRB order + white
+    Ws2812bGrb,  // RGB, GRB order; white is drawn on r, g and b (color_utils::stripColor)
+};
+
+struct BoardProfile {
+    // LED strip
+    uint8_t ledPin;
+    uint16_t numLeds;
+    LedStripType ledType;
+
+    // TFT (ST7789, hardware SPI; we manage CS)
+    int8_t tftCs;
+    int8_t tftDc;
+    int8_t tftRst;
+    int8_t tftSclk;
+    int8_t tftMosi;
+    int8_t tftBlk;  // Backlight, PWM capable; -1 when hard-wired on
+    uint16_t tftWidth;
+    uint16_t tftHeight;
+    uint8_t tftRotation;  // 0-3
+
+    // Rotary encoder and mode button (active LOW, internal pull-ups)
+    uint8_t encoderPinA;
+    uint8_t encoderPinB;
+    uint8_t encoderButton;
+    uint8_t btnMode;
+
+    // NFC (PN532, I2C)
+    uint8_t nfcSda;
+    uint8_t nfcScl;
+    uint8_t nfcI2cBus;  // 0: Wire, 1: Wire1
+
+    constexpr bool hasBacklight() const { return tftBlk >= 0; }
+};
+
+enum class BoardVariant : uint8_t {
+    Gen4R8N16,         // 4D Systems gen4-ESP32-S3 R8N16 + SK6812 RGBW strip
+    Gen4R8N16Ws2812b,  // Same board and wiring, WS2812B RGB strip
+};
+
+namespace boards {
+constexpr BoardProfile kGen4R8N16 = {
+    5, 26, LedStripType::Sk6812Grbw,  // LED: pin, count, chipset
+    10, 14, 18, 12, 11, 19,           // TFT: CS, DC, RST, SCLK, MOSI, BLK
+    240, 320, 3,                      // TFT: 1.9" panel width, height, rotation
+    15, 16, 17, 9,                    // Encoder A, B, switch; mode button
+    8, 7, 1,                          // NFC: SDA, SCL, I2C bus
+};
+
+constexpr BoardProfile kGen4R8N16Ws2812b = {
+    5, 26, LedStripType::Ws2812bGrb,
+    10, 14, 18, 12, 11, 19,
+    240, 320, 3,
+    15, 16, 17, 9,
+    8, 7, 1,
+};
+
+constexpr BoardProfile forVariant(BoardVariant variant) {
+    return variant == BoardVariant::Gen4R8N16Ws2812b ? kGen4R8N16Ws2812b : kGen4R8N16;
+}
+} // namespace boards
+
+#ifndef VITRINE_BOARD
+#define VITRINE_BOARD Gen4R8N16
+#endif
+
+// The board this firmware is built for
+constexpr BoardProfile kBoard = boards::forVariant(BoardVariant::VITRINE_BOARD);
+
+static_assert(kBoard.numLeds > 0, "The board needs an LED strip");
+static_assert(kBoard.tftRotation < 4, "TFT rotation is 0-3");
+static_assert(kBoard.nfcI2cBus < 2, "The ESP32-S3 has two I2C buses");
+
+#endif // BOARD_PROFILE_H
@@ -1,44 +1,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// Pin definitions
-// NeoPixel LED strip - Using GPIO48 (compatible with LED output)
-#define LED_PIN 5
-#define LED_INTERNAL_PIN 48
-#define NUM_LEDS 26
-
-// // OLED Display (I2C)
-// #define OLED_SDA 8
-// #define OLED_SCL 9
-// #define OLED_ADDR 0x3C  // Common address for SSD1306/SSD1315 OLED displays (might be 0x3D)
-// #define SCREEN_WIDTH 128
-// #define SCREEN_HEIGHT 32
-
-// TFT Display (ST7789 1.9inch IPS)
-// Using hardware SPI pins for best performance
-#define TFT_CS   10  // CS pin (Chip Select)
-#define TFT_DC   14  // DC pin (Data/Command)
-#define TFT_RST  18  // RES pin (Reset)
-#define TFT_SCLK 12  // [SCL] Hardware SPI SCLK
-#define TFT_MOSI 11  // [SDA] Hardware SPI MOSI
-#define TFT_BLK  19  // BLK pin (Backlight control - PWM capable)
-// Dimensions for 1.9" ST7789 display
-#define TFT_WIDTH 240   // Common resolution for ST7789
-#define TFT_HEIGHT 320  // Common resolution for ST7789
-
-// Rotary Encoder
-// Using GPIO pins with interrupt capability
-#define ENCODER_PIN_A 15  // GPIO15 (RTC/GPIO/TOUCH capable)
-#define ENCODER_PIN_B 16  // GPIO16 (RTC/GPIO/TOUCH capable)
-#define ENCODER_BUTTON 17 // GPIO17
-
-// Mode button
-#define BTN_MODE 9    // GPIO7
-
-// NFC Module (I2C)  
-#define NFC_SDA 8  // SDA pin for NFC module
-#define NFC_SCL 7  // SCL pin for NFC module
-#define NFC_ADDR 0x24  // Default I2C address for PN532 (check your module's documentation)
+// Pins, LED count and display geometry come from the board profile (kBoard)
+#include "board_profile.h"
 
 // // Additional Button
 // #define MODE_BUTTON 9    // GPIO9
@@ -0,0 +1,15 @@
+#pragma once
+
+// Copy this file to ota_signing_key.h (same folder) to require signed OTA images.
+// Without it, uploads are accepted unsigned (an optional sha256 is still checked).
+//
+// Generate a key pair (ECDSA P-256) once and keep the private key off the device:
+//   openssl ecparam -name prime256v1 -genkey -noout -out ota_private.pem
+//   openssl ec -in ota_private.pem -pubout -out ota_public.pem
+// Sign a firmware image (DER signature over SHA-256 of the .bin), hex-encoded for the upload:
+//   openssl dgst -sha256 -sign ota_private.pem firmware.bin | xxd -p | tr -d '\n'
+
+#define OTA_SIGNING_PUBKEY_PEM \
+"-----BEGIN PUBLIC KEY-----\n" \
+"PASTE_YOUR_PUBLIC_KEY_HERE\n" \
+"-----END PUBLIC KEY-----\n"
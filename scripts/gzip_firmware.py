@@ -0,0 +1,29 @@
+# PlatformIO post-build step: writes firmware.bin.gz next to firmware.bin for compressed OTA
+# (POST /update/firmware accepts either). Also prints the SHA-256 of the raw image, which is
+# what the device verifies when ?sha256= is given.
+Import("env")
+
+import gzip
+import hashlib
+import os
+
+
+def gzip_firmware(source, target, env):
+    bin_path = str(target[0])
+    gz_path = bin_path + ".gz"
+
+    with open(bin_path, "rb") as f:
+        data = f.read()
+
+    # mtime=0 keeps the output reproducible for identical builds
+    with open(gz_path, "wb") as f:
+        f.write(gzip.compress(data, compresslevel=9, mtime=0))
+
+    raw = len(data)
+    packed = os.path.getsize(gz_path)
+    print("OTA image: %s (%d bytes) -> %s (%d bytes, %.0f%%)" % (
+        os.path.basename(bin_path), raw, os.path.basename(gz_path), packed, 100.0 * packed / raw))
+    print("OTA sha256: %s" % hashlib.sha256(data).hexdigest())
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", gzip_firmware)
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Decode binary log output (firmware built with -DLOG_BINARY=1) back into text lines.
+
+The device sends each LOGx call as a frame  A5 C3 <len> <record>  and ordinary text lines
+as-is. A record holds the addresses of the format and tag strings; they are looked up in
+the firmware ELF (same build!) and the arguments are formatted here instead of on the device.
+
+    python scripts/log_decode.py .pio/build/<env>/firmware.elf capture.bin
+    python scripts/log_decode.py .pio/build/<env>/firmware.elf --port COM9 [--baud 115200]
+
+Record layout (see BinaryRecord in src/util/Log.h):
+    u32 ms, u32 fmt address, u32 tag address, u8 level (bit 7: arguments truncated),
+    then arguments: 4 bytes per int/char/pointer, 8 per double and 64-bit int,
+    strings inline as u8 length + bytes.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_SYNC = b"\xa5\xc3"
+HEADER = struct.Struct("<IIIB")
+LEVELS = "EWID"
+TRUNCATED = 0x80
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# printf conversion: flags, width, precision, length, conversion
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|L|z|j|t)?([diouxXeEfgGcsp%])")
+
+
+class Elf:
+    """Just enough little-endian ELF (32-bit target; 64-bit for host builds) to read strings
+    from allocated sections."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] not in (1, 2):
+            raise SystemExit("%s: not an ELF file" % path)
+        if self.data[4] == 1:
+            shoff, = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+            section = "<IIIIII"
+        else:
+            shoff, = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x3A)
+            section = "<IIQQQQ"
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(section, self.data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, offset, size))
+        self.cache = {}
+
+    def string(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        text = None
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + (addr - base)
+                end = self.data.find(b"\0", start, offset + size)
+                text = self.data[start:end if end >= 0 else offset + size].decode("utf-8", "replace")
+                break
+        self.cache[addr] = text
+        return text
+
+
+class Args:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def take(self, fmt):
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise IndexError
+        value, = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return value
+
+    def string(self):
+        n = self.take("<B")
+        if self.pos + n > len(self.data):
+            raise IndexError
+        s = self.data[self.pos:self.pos + n].decode("utf-8", "replace")
+        self.pos += n
+        return s
+
+
+def render(fmt, args):
+    out = []
+    last = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        try:
+            if width == "*":
+                width = str(args.take("<i"))
+            if precision == "*":
+                precision = str(args.take("<i"))
+            wide = length in ("ll", "j")
+            if conv in "di":
+                value = args.take("<q" if wide else "<i")
+            elif conv in "ouxX":
+                value = args.take("<Q" if wide else "<I")
+                conv = "d" if conv == "u" else conv
+            elif conv in "eEfgG":
+                value = args.take("<d")
+            elif conv == "c":
+                value = chr(args.take("<I") & 0xFF)
+            elif conv == "s":
+                value = args.string()
+            else:  # p
+                value, conv, flags, width = args.take("<I"), "x", "#0", "10"
+        except IndexError:
+            out.append("<?>")
+            continue
+        spec = "%" + (flags or "") + (width or "") + ("." + precision if precision else "") + conv
+        out.append(spec % value)
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def decode_record(elf, record):
+    if len(record) < HEADER.size:
+        return "<short record>"
+    ms, fmt_addr, tag_addr, level = HEADER.unpack_from(record)
+    fmt = elf.string(fmt_addr)
+    tag = elf.string(tag_addr) if tag_addr else ""
+    level_char = LEVELS[level & 0x3]
+    if fmt is None:
+        text = "<unknown format 0x%08x: wrong ELF?>" % fmt_addr
+    else:
+        text = render(fmt, Args(record[HEADER.size:]))
+    if level & TRUNCATED:
+        text += " <truncated>"
+    prefix = "[%u][%s]" % (ms, level_char)
+    if tag is None:
+        prefix += "[0x%08x]" % tag_addr
+    elif tag:
+        prefix += "[%s]" % tag
+    return "%s %s" % (prefix, text)
+
+
+def decode_stream(elf, read, write):
+    """read() returns bytes, b"" when nothing arrived yet, or None at end of input."""
+    buf = b""
+    while True:
+        chunk = read()
+        if chunk is None:
+            break
+        buf += chunk
+        while buf:
+            sync = buf.find(FRAME_SYNC)
+            if sync == 0:
+                if len(buf) < 3 or len(buf) < 3 + buf[2]:
+                    break  # partial frame
+                n = buf[2]
+                write(decode_record(elf, buf[3:3 + n]))
+                buf = buf[3 + n:]
+                continue
+            # Plain text (boot messages, direct Log::info() calls, ROM output) up to the next frame
+            end = sync if sync > 0 else len(buf)
+            newline = buf.find(b"\n", 0, end)
+            if newline >= 0:
+                write(buf[:newline].decode("utf-8", "replace").rstrip("\r"))
+                buf = buf[newline + 1:]
+            elif sync > 0:
+                text = buf[:sync].decode("utf-8", "replace").strip()
+                if text:
+                    write(text)
+                buf = buf[sync:]
+            else:
+                break  # partial text line
+    if buf.strip():
+        write(buf.decode("utf-8", "replace").rstrip())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware.elf of the running build")
+    parser.add_argument("capture", nargs="?", help="raw capture file ('-' for stdin)")
+    parser.add_argument("--port", help="read live from a serial port instead (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    write = lambda line: print(line, flush=True)
+
+    if args.port:
+        import serial  # pyserial ships with PlatformIO
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            decode_stream(elf, lambda: port.read(4096), write)
+    elif args.capture in (None, "-"):
+        decode_stream(elf, lambda: sys.stdin.buffer.read1(4096) or None, write)
+    else:
+        with open(args.capture, "rb") as f:
+            decode_stream(elf, lambda: f.read(4096) or None, write)
+
+
+if __name__ == "__main__":
+    main()
@@ -3,9 +3,17 @@
 
 namespace color_utils {
 
+uint32_t stripColor(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    if (kBoard.ledType != LedStripType::Ws2812bGrb) {
+        return Adafruit_NeoPixel::Color(r, g, b, w);
+    }
+    const auto fold = [w](uint8_t c) { return static_cast<uint8_t>(c + w > 255 ? 255 : c + w); };
+    return Adafruit_NeoPixel::Color(fold(r), fold(g), fold(b));
+}
+
 // Blend RGB and White channels
 uint32_t blendColorWithWhite(Adafruit_NeoPixel* strip, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
-    return strip->Color(r, g, b, w);
+    return stripColor(r, g, b, w);
 }
 
 // Calculate white intensity dynamically
@@ -16,13 +24,13 @@ uint8_t calculateWhiteIntensity(uint8_t r, uint8_t g, uint8_t b) {
 // Get color with auto white adjustment
 uint32_t getColorWithAutoWhite(Adafruit_NeoPixel* strip, uint8_t r, uint8_t g, uint8_t b) {
     uint8_t w = calculateWhiteIntensity(r, g, b);
-    return strip->Color(r, g, b, w);
+    return stripColor(r, g, b, w);
 }
 
 // Adjust color temperature
 uint32_t adjustColorTemperature(Adafruit_NeoPixel* strip, uint8_t r, uint8_t g, uint8_t b, int temperature) {
     uint8_t w = constrain(temperature, 0, 255);
-    return strip->Color(r, g, b, w);
+    return stripColor(r, g, b, w);
 }
 
 // Fade between two colors
@@ -42,13 +50,13 @@ uint32_t fadeToColor(Adafruit_NeoPixel* strip, uint32_t color1, uint32_t color2,
     uint8_t b = b1 + (b2 - b1) * ratio;
     uint8_t w = w1 + (w2 - w1) * ratio;
 
-    return strip->Color(r, g, b, w);
+    return stripColor(r, g, b, w);
 }
 
 // Set warm white
 void setWarmWhite(Adafruit_NeoPixel* strip, uint8_t brightness) {
     for (int i = 0; i < strip->numPixels(); i++) {
-        strip->setPixelColor(i, strip->Color(255, 223, 191, brightness));
+        strip->setPixelColor(i, stripColor(255, 223, 191, brightness));
     }
     strip->show();
 }
@@ -56,7 +64,7 @@ void setWarmWhite(Adafruit_NeoPixel* strip, uint8_t brightness) {
 // Set cool white
 void setCoolWhite(Adafruit_NeoPixel* strip, uint8_t brightness) {
     for (int i = 0; i < strip->numPixels(); i++) {
-        strip->setPixelColor(i, strip->Color(191, 223, 255, brightness));
+        strip->setPixelColor(i, stripColor(191, 223, 255, brightness));
     }
     strip->show();
 }
@@ -65,14 +73,14 @@ void setCoolWhite(Adafruit_NeoPixel* strip, uint8_t brightness) {
 void breathingWhite(Adafruit_NeoPixel* strip, uint8_t minBrightness, uint8_t maxBrightness, uint16_t delayMs) {
     for (int brightness = minBrightness; brightness <= maxBrightness; brightness++) {
         for (int i = 0; i < strip->numPixels(); i++) {
-            strip->setPixelColor(i, strip->Color(0, 0, 0, brightness));
+            strip->setPixelColor(i, stripColor(0, 0, 0, brightness));
         }
         strip->show();
         delay(delayMs);
     }
     for (int brightness = maxBrightness; brightness >= minBrightness; brightness--) {
         for (int i = 0; i < strip->numPixels(); i++) {
-            strip->setPixelColor(i, strip->Color(0, 0, 0, brightness));
+            strip->setPixelColor(i, stripColor(0, 0, 0, brightness));
         }
         strip->show();
         delay(delayMs);
@@ -81,7 +89,7 @@ void breathingWhite(Adafruit_NeoPixel* strip, uint8_t minBrightness, uint8_t max
 
 // Get white color with specified brightness
 uint32_t getWhiteColor(Adafruit_NeoPixel* strip, uint8_t brightness) {
-    return strip->Color(0, 0, 0, brightness); // White channel only
+    return stripColor(0, 0, 0, brightness); // White channel (RGB on strips without one)
 }
 
 } // namespace color_utils
\ No newline at end of file
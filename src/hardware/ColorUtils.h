@@ -3,9 +3,14 @@
 
 #include <Adafruit_NeoPixel.h>
 #include <Arduino.h>
+#include "config.h"
 
 namespace color_utils {
 
+// Packs a colour for the board's strip. Strips without a white channel (kBoard.ledType
+// Ws2812bGrb) get w added to r, g and b (saturating), so white-only colours still light up.
+uint32_t stripColor(uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
 // Blend RGB and White channels
 uint32_t blendColorWithWhite(Adafruit_NeoPixel* strip, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
 
@@ -1,57 +1,51 @@
 #include "DisplayControl.h"
+#include "util/Metrics.h"
+#include "util/Trace.h"
+
+namespace {
+// Whole screens (miniature, info, mode, options list)
+MetricHistogram s_drawTime("vitrine_display_draw_seconds", "TFT screen draw duration");
+} // namespace
 
 // Constructor
-TFTDisplayControl::TFTDisplayControl() {
-    // Initialize the ST7789 display with CS, DC, and RST pins
-    display = new Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
-}
+TFTDisplayControl::TFTDisplayControl() : display(kBoard.tftCs, kBoard.tftDc, kBoard.tftRst) {}
 
 // Initialize display
 bool TFTDisplayControl::begin() {
     // Configure backlight pin (if available)
-    #ifdef TFT_BLK
-    // Use PWM so brightness can be controlled (LEDC is available on ESP32-S3)
-    static constexpr uint8_t kPwmChannel = 0;
-    static constexpr uint32_t kPwmFreqHz = 5000;
-    static constexpr uint8_t kPwmResolutionBits = 8;
-
-    ledcSetup(kPwmChannel, kPwmFreqHz, kPwmResolutionBits);
-    ledcAttachPin(TFT_BLK, kPwmChannel);
-    setBacklight(true);
-    #endif
+    if (kBoard.hasBacklight()) {
+        // Use PWM so brightness can be controlled (LEDC is available on ESP32-S3)
+        static constexpr uint8_t kPwmChannel = 0;
+        static constexpr uint32_t kPwmFreqHz = 5000;
+        static constexpr uint8_t kPwmResolutionBits = 8;
+
+        ledcSetup(kPwmChannel, kPwmFreqHz, kPwmResolutionBits);
+        ledcAttachPin(kBoard.tftBlk, kPwmChannel);
+        setBacklight(true);
+    }
     
-    // Initialize SPI using hardware SPI pins
-    // VSPI on ESP32-S3: SCLK=GPIO12, MISO=GPIO13, MOSI=GPIO11
-    SPI.begin(TFT_SCLK, -1, TFT_MOSI, -1); // SCLK, MISO, MOSI, SS (we manage CS manually)
+    // Initialize SPI on the board's hardware SPI pins (write-only panel: no MISO)
+    SPI.begin(kBoard.tftSclk, -1, kBoard.tftMosi, -1); // SCLK, MISO, MOSI, SS (we manage CS manually)
     
-    // Initialize the display with specific width and height for the 1.9" ST7789
-    display->init(TFT_WIDTH, TFT_HEIGHT);
+    // Initialize the display with the panel's native width and height
+    display.init(kBoard.tftWidth, kBoard.tftHeight);
 
     // Ensure colors are not inverted (some panels can power up inverted)
-    display->invertDisplay(false);
-    
-    // Set rotation (0-3) - may need to be adjusted based on your specific display orientation
-    display->setRotation(3);
+    display.invertDisplay(false);
     
-    // Fill with black to clear any initial artifacts
-    display->fillScreen(BLACK);
+    // Set rotation (0-3) for how the panel is mounted on this board
+    display.setRotation(kBoard.tftRotation);
     
-    // Display initial message to confirm the display is working
-    showMessage("Initializing...", 10, 10, 2, WHITE);
-    
-    // Delay to show the startup message
-    delay(2000);
+    // Fill with black to clear any initial artifacts.
+    // No splash: setup() draws the last miniature right after init.
+    display.fillScreen(BLACK);
     
     return true;
 }
 
 void TFTDisplayControl::setBacklight(bool on) {
-#ifdef TFT_BLK
     backlightOn = on;
     applyBacklight();
-#else
-    (void)on;
-#endif
 }
 
 void TFTDisplayControl::setBacklightBrightnessPercent(uint8_t percent) {
@@ -59,35 +53,36 @@ void TFTDisplayControl::setBacklightBrightnessPercent(uint8_t percent) {
         percent = 100;
     }
     backlightBrightnessPercent = percent;
-#ifdef TFT_BLK
     applyBacklight();
-#endif
 }
 
 void TFTDisplayControl::applyBacklight() {
-#ifdef TFT_BLK
+    if (!kBoard.hasBacklight()) {
+        return;
+    }
     static constexpr uint8_t kPwmChannel = 0;
     const uint8_t duty = backlightOn ? static_cast<uint8_t>(map(backlightBrightnessPercent, 0, 100, 0, 255)) : 0;
     ledcWrite(kPwmChannel, duty);
-#endif
 }
 
 // Clear display
 void TFTDisplayControl::clear() {
-    display->fillScreen(BLACK);
+    listValid = false;
+    display.fillScreen(BLACK);
 }
 
 // Fill screen with color
 void TFTDisplayControl::fillScreen(uint16_t color) {
-    display->fillScreen(color);
+    listValid = false;
+    display.fillScreen(color);
 }
 
 void TFTDisplayControl::showWrappedMessage (const char* message, int x, int y, int size, uint16_t color) {
-    display->setTextSize(size);
-    display->setTextColor(color);
+    display.setTextSize(size);
+    display.setTextColor(color);
 
     int cursorY = y; // Keep the initial Y position
-    int maxWidth = TFT_WIDTH - x; // Maximum allowed width for the text
+    int maxWidth = kBoard.tftWidth - x; // Maximum allowed width for the text
     char buffer[256]; // Buffer to handle the text
     strncpy(buffer, message, sizeof(buffer) - 1);
     buffer[sizeof(buffer) - 1] = '\0'; // Ensure the text is null-terminated
@@ -101,12 +96,12 @@ void TFTDisplayControl::showWrappedMessage (const char* message, int x, int y, i
         uint16_t w, h;
 
         // Calculate the width of the current line with the new word
-        display->getTextBounds((line + " " + word).c_str(), x, cursorY, &x1, &y1, &w, &h);
+        display.getTextBounds((line + " " + word).c_str(), x, cursorY, &x1, &y1, &w, &h);
 
         if (w > maxWidth) {
             // If the line is too long, print the current line and start a new one
-            display->setCursor(x, cursorY);
-            display->println(line.c_str());
+            display.setCursor(x, cursorY);
+            display.println(line.c_str());
             cursorY += h; // Move the cursor to the next line
             line = word; // Start a new line with the current word
         } else {
@@ -122,8 +117,8 @@ void TFTDisplayControl::showWrappedMessage (const char* message, int x, int y, i
 
     // Print the last line
     if (!line.isEmpty()) {
-        display->setCursor(x, cursorY);
-        display->println(line.c_str());
+        display.setCursor(x, cursorY);
+        display.println(line.c_str());
     }
 }
 
@@ -132,6 +127,8 @@ void TFTDisplayControl::showMiniatureInfo(int index) {
     if (index < 0 || index >= MAX_MINIATURES) {
         return;
     }
+    MetricTimer timer(s_drawTime);
+    TRACE_SCOPE("display.draw");
     
     clear();
 
@@ -164,6 +161,8 @@ void TFTDisplayControl::showMiniatureInfo(int index) {
 }
 
 void TFTDisplayControl::showInfo(const char* title, const char* subtitle, const char* author, const char* date) {
+    MetricTimer timer(s_drawTime);
+    TRACE_SCOPE("display.draw");
     clear();
     
     showTitle(title, YELLOW);
@@ -185,6 +184,8 @@ void TFTDisplayControl::showInfo(const char* title, const char* subtitle, const
 }
 
 void TFTDisplayControl::showMode(const char* mode, const char* message) {
+    MetricTimer timer(s_drawTime);
+    TRACE_SCOPE("display.draw");
     clear();
     
     showTitle(mode, MAGENTA);
@@ -197,10 +198,10 @@ void TFTDisplayControl::showMode(const char* mode, const char* message) {
 
 // Show a message at the specified location
 void TFTDisplayControl::showMessage(const char* message, int x, int y, int size, uint16_t color) {
-    display->setTextSize(size);
-    display->setTextColor(color);
-    display->setCursor(x, y);
-    display->println(message);
+    display.setTextSize(size);
+    display.setTextColor(color);
+    display.setCursor(x, y);
+    display.println(message);
 }
 
 // Show a centered title
@@ -208,30 +209,30 @@ void TFTDisplayControl::showTitle(const char* title, uint16_t color) {
     int16_t x1, y1;
     uint16_t w, h;
     
-    display->setTextSize(3);
-    display->setTextColor(color);
+    display.setTextSize(3);
+    display.setTextColor(color);
     
     // Calculate width of title text
-    display->getTextBounds(title, 0, 0, &x1, &y1, &w, &h);
+    display.getTextBounds(title, 0, 0, &x1, &y1, &w, &h);
     
     // Center the text
-    display->setCursor((TFT_HEIGHT - w) / 2, 15);
-    display->println(title);
+    display.setCursor((kBoard.tftHeight - w) / 2, 15);
+    display.println(title);
 }
 
 void TFTDisplayControl::showSubTitle(const char* title, uint16_t color) {
     int16_t x1, y1;
     uint16_t w, h;
 
-    display->setTextSize(2);
-    display->setTextColor(color);
+    display.setTextSize(2);
+    display.setTextColor(color);
     
     // Calculate width of title text
-    display->getTextBounds(title, 0, 0, &x1, &y1, &w, &h);
+    display.getTextBounds(title, 0, 0, &x1, &y1, &w, &h);
     
     // Center the text
-    display->setCursor((TFT_HEIGHT - w) / 2, 45);
-    display->println(title);
+    display.setCursor((kBoard.tftHeight - w) / 2, 45);
+    display.println(title);
 }
 
 void TFTDisplayControl::getCenterXPosition(const char* text, int& centerXPosition) {
@@ -239,79 +240,192 @@ void TFTDisplayControl::getCenterXPosition(const char* text, int& centerXPositio
     uint16_t w, h;
 
     // Calculate width of text
-    display->getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
+    display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
 
-    centerXPosition = (TFT_HEIGHT - w) / 2;
+    centerXPosition = (kBoard.tftHeight - w) / 2;
 }
 
 // Utility method to get display pointer for advanced operations
 Adafruit_ST7789* TFTDisplayControl::getDisplay() {
-    return display;
+    return &display;
 }
 
 // Convert RGB values to 16-bit color
 uint16_t TFTDisplayControl::color565(uint8_t r, uint8_t g, uint8_t b) {
-    return display->color565(r, g, b);
+    return display.color565(r, g, b);
 }
 
-void TFTDisplayControl::showOptions(const char* const options[], int numOptions, int focusIndex, int selectedIndex, const char* footerHint) {
-    clear();
+namespace {
+// Options list layout
+constexpr int kListYStart = 30;
+constexpr int kListLineH = 20;
+constexpr int kListXText = 18;
+constexpr int kListXTri = 6;
+constexpr int kListFooterH = 16;
+constexpr int kListScrollbarW = 4;
+}
 
-    const int w = display->width();
-    const int yStart = 30;
-    const int lineH = 20;
-    const int xText = 18;
-    const int xTri = 6;
+int TFTDisplayControl::getOptionsVisibleRows(const char* footerHint) const {
+    const bool hasFooter = footerHint && footerHint[0] != '\0';
+    const int bottom = display.height() - (hasFooter ? kListFooterH : 0);
+    const int rows = (bottom - kListYStart) / kListLineH;
+    return rows > 0 ? rows : 1;
+}
+
+void TFTDisplayControl::drawOptionRow(int optionIndex, int row, bool isFocused, bool isSelected) {
+    const bool scrollable = listNumOptions > getOptionsVisibleRows(listFooterHint);
+    const int w = display.width() - (scrollable ? kListScrollbarW + 2 : 0);
+    const int y = kListYStart + row * kListLineH;
     const int xMarker = w - 10;
 
     // Dark blue highlight background for focused line
     const uint16_t DARK_BLUE = color565(0, 0, 80);
 
-    for (int i = 0; i < numOptions; i++) {
-        const int y = yStart + i * lineH;
-        const bool isFocused = (i == focusIndex);
-        const bool isSelected = (selectedIndex >= 0 && i == selectedIndex);
-
-        if (isFocused) {
-            display->fillRect(0, y - 2, w, lineH, DARK_BLUE);
-            // Triangle marker (focus)
-            display->fillTriangle(
-                xTri, y + 6,
-                xTri, y + 14,
-                xTri + 6, y + 10,
-                YELLOW
-            );
-        }
+    // Repaint the row background so a previously focused row loses its highlight
+    display.fillRect(0, y - 2, w, kListLineH, isFocused ? DARK_BLUE : BLACK);
+
+    if (isFocused) {
+        // Triangle marker (focus)
+        display.fillTriangle(
+            kListXTri, y + 6,
+            kListXTri, y + 14,
+            kListXTri + 6, y + 10,
+            YELLOW
+        );
+    }
+
+    if (isSelected) {
+        // Check marker (current value)
+        const int x = xMarker - 6;
+        const int yMid = y + 10;
+        // Two-pass lines to make it slightly thicker
+        display.drawLine(x, yMid, x + 3, yMid + 3, GREEN);
+        display.drawLine(x + 3, yMid + 3, x + 10, yMid - 4, GREEN);
+        display.drawLine(x, yMid + 1, x + 3, yMid + 4, GREEN);
+        display.drawLine(x + 3, yMid + 4, x + 10, yMid - 3, GREEN);
+    }
 
-        if (isSelected) {
-            // Check marker (current value)
-            const int x = xMarker - 6;
-            const int yMid = y + 10;
-            // Two-pass lines to make it slightly thicker
-            display->drawLine(x, yMid, x + 3, yMid + 3, GREEN);
-            display->drawLine(x + 3, yMid + 3, x + 10, yMid - 4, GREEN);
-            display->drawLine(x, yMid + 1, x + 3, yMid + 4, GREEN);
-            display->drawLine(x + 3, yMid + 4, x + 10, yMid - 3, GREEN);
+    uint16_t color = WHITE;
+    if (isFocused) {
+        color = YELLOW;
+    } else if (isSelected) {
+        color = GREEN;
+    }
+
+    // Long labels must not wrap into the next row
+    display.setTextWrap(false);
+    display.setTextSize(2);
+    display.setTextColor(color);
+    display.setCursor(kListXText, y);
+    display.print(listOptions[optionIndex]);
+    display.setTextWrap(true);
+}
+
+void TFTDisplayControl::drawOptionRows() {
+    const int visibleRows = getOptionsVisibleRows(listFooterHint);
+    display.fillRect(0, kListYStart - 2, display.width(), visibleRows * kListLineH, BLACK);
+
+    for (int row = 0; row < visibleRows; row++) {
+        const int i = listFirstVisible + row;
+        if (i >= listNumOptions) {
+            break;
         }
+        drawOptionRow(i, row, i == listFocusIndex, listSelectedIndex >= 0 && i == listSelectedIndex);
+    }
+}
+
+void TFTDisplayControl::drawOptionsScrollbar() {
+    const int visibleRows = getOptionsVisibleRows(listFooterHint);
+    if (listNumOptions <= visibleRows) {
+        return;
+    }
+
+    const int x = display.width() - kListScrollbarW;
+    const int trackTop = kListYStart - 2;
+    const int trackH = visibleRows * kListLineH;
+    const int maxFirst = listNumOptions - visibleRows;
+
+    int thumbH = (trackH * visibleRows) / listNumOptions;
+    if (thumbH < 8) {
+        thumbH = 8;
+    }
+    const int thumbY = trackTop + ((trackH - thumbH) * listFirstVisible) / maxFirst;
+
+    display.fillRect(x, trackTop, kListScrollbarW, trackH, color565(40, 40, 40));
+    display.fillRect(x, thumbY, kListScrollbarW, thumbH, color565(170, 170, 170));
+}
 
-        uint16_t color = WHITE;
-        if (isFocused) {
-            color = YELLOW;
-        } else if (isSelected) {
-            color = GREEN;
+void TFTDisplayControl::showOptions(const char* const options[], int numOptions, int focusIndex, int selectedIndex, const char* footerHint) {
+    MetricTimer timer(s_drawTime);
+    TRACE_SCOPE("display.draw");
+    if (numOptions <= 0) {
+        clear();
+        return;
+    }
+    if (focusIndex < 0) focusIndex = 0;
+    if (focusIndex >= numOptions) focusIndex = numOptions - 1;
+
+    const int visibleRows = getOptionsVisibleRows(footerHint);
+    const bool sameList = listValid &&
+        listOptions == options &&
+        listNumOptions == numOptions &&
+        listSelectedIndex == selectedIndex &&
+        listFooterHint == footerHint;
+
+    // Move the window only as far as needed to keep the focus visible
+    int firstVisible = sameList ? listFirstVisible : 0;
+    if (focusIndex < firstVisible) {
+        firstVisible = focusIndex;
+    } else if (focusIndex >= firstVisible + visibleRows) {
+        firstVisible = focusIndex - visibleRows + 1;
+    }
+    const int maxFirst = (numOptions > visibleRows) ? (numOptions - visibleRows) : 0;
+    if (firstVisible > maxFirst) {
+        firstVisible = maxFirst;
+    }
+
+    const int prevFocusIndex = listFocusIndex;
+    const int prevFirstVisible = listFirstVisible;
+
+    listOptions = options;
+    listNumOptions = numOptions;
+    listSelectedIndex = selectedIndex;
+    listFooterHint = footerHint;
+    listFocusIndex = focusIndex;
+    listFirstVisible = firstVisible;
+
+    if (!sameList) {
+        // New menu: full repaint
+        display.fillScreen(BLACK);
+        drawOptionRows();
+        drawOptionsScrollbar();
+
+        if (footerHint && footerHint[0] != '\0') {
+            const uint16_t GRAY = color565(170, 170, 170);
+            display.setTextSize(1);
+            display.setTextColor(GRAY);
+            display.setCursor(6, display.height() - 14);
+            display.print(footerHint);
         }
 
-        display->setTextSize(2);
-        display->setTextColor(color);
-        display->setCursor(xText, y);
-        display->print(options[i]);
+        listValid = true;
+        return;
     }
 
-    if (footerHint && footerHint[0] != '\0') {
-        const uint16_t GRAY = color565(170, 170, 170);
-        display->setTextSize(1);
-        display->setTextColor(GRAY);
-        display->setCursor(6, display->height() - 14);
-        display->print(footerHint);
+    if (firstVisible != prevFirstVisible) {
+        // Window scrolled: repaint the list area only (title/footer stay untouched)
+        drawOptionRows();
+        drawOptionsScrollbar();
+        return;
     }
-}
\ No newline at end of file
+
+    if (focusIndex == prevFocusIndex) {
+        return;
+    }
+
+    // Same window: only the previously focused row and the new one change
+    if (prevFocusIndex >= firstVisible && prevFocusIndex < firstVisible + visibleRows) {
+        drawOptionRow(prevFocusIndex, prevFocusIndex - firstVisible, false, selectedIndex >= 0 && prevFocusIndex == selectedIndex);
+    }
+    drawOptionRow(focusIndex, focusIndex - firstVisible, true, selectedIndex >= 0 && focusIndex == selectedIndex);
+}
@@ -9,12 +9,27 @@
 
 class TFTDisplayControl {
 private:
-    Adafruit_ST7789* display;
+    Adafruit_ST7789 display;
 
     uint8_t backlightBrightnessPercent = 100;
     bool backlightOn = true;
 
     void applyBacklight();
+
+    // Options list viewport. Kept between showOptions() calls so moving the focus
+    // only repaints the rows that changed and the window scrolls instead of jumping.
+    const char* const* listOptions = nullptr;
+    int listNumOptions = 0;
+    int listSelectedIndex = -1;
+    const char* listFooterHint = nullptr;
+    int listFirstVisible = 0;
+    int listFocusIndex = -1;
+    bool listValid = false;
+
+    int getOptionsVisibleRows(const char* footerHint) const;
+    void drawOptionRow(int optionIndex, int row, bool isFocused, bool isSelected);
+    void drawOptionRows();
+    void drawOptionsScrollbar();
     
     // Color definitions for 16-bit color
     static const uint16_t BLACK = 0x0000;
@@ -34,7 +49,7 @@ public:
     // Initialize display
     bool begin();
 
-    // Backlight control (if TFT_BLK is available)
+    // Backlight control (if the board has a backlight pin)
     void setBacklight(bool on);
     void setBacklightBrightnessPercent(uint8_t percent);
     uint8_t getBacklightBrightnessPercent() const { return backlightBrightnessPercent; }
@@ -59,7 +74,11 @@ public:
     // - focusIndex: item currently navigated by encoder
     // - selectedIndex: optional marker for the current saved/configured value (-1 disables)
     // - footerHint: optional hint displayed at the bottom (nullptr disables)
+    // Only the rows that fit on screen are drawn; lists longer than the panel scroll
+    // with the focus and show a scrollbar on the right edge.
     void showOptions(const char* const options[], int numOptions, int focusIndex, int selectedIndex = -1, const char* footerHint = nullptr);
+    // Force the next showOptions() call to repaint the whole list (e.g. a new menu was opened)
+    void invalidateOptions() { listValid = false; }
     
     void getCenterXPosition(const char* text, int& centerXPosition);
     // Utility method to get display pointer for advanced operations
@@ -9,7 +9,6 @@ static int wrapIndex(int idx, int max) {
 
 // Constructor
 EncoderControl::EncoderControl() {
-    encoder = new ESP32Encoder();
     lastPosition = 0;
     currentIndex = 0;
     buttonState = false;
@@ -29,11 +28,11 @@ EncoderControl::EncoderControl() {
 void EncoderControl::begin() {
     // Configure encoder pins
     ESP32Encoder::useInternalWeakPullResistors = UP;
-    encoder->attachHalfQuad(ENCODER_PIN_A, ENCODER_PIN_B);
-    encoder->setCount(0);
+    encoder.attachHalfQuad(kBoard.encoderPinA, kBoard.encoderPinB);
+    encoder.setCount(0);
     
     // Configure button pin with pull-up resistor
-    pinMode(ENCODER_BUTTON, INPUT_PULLUP);
+    pinMode(kBoard.encoderButton, INPUT_PULLUP);
     
     Serial0.println("Encoder initialized");
 }
@@ -53,7 +52,7 @@ bool EncoderControl::checkMovement() {
 }
 
 bool EncoderControl::checkMovementWithWrap(int wrapMax) {
-    const long newPosition = encoder->getCount() / 2;  // Divide by 2 for half-step encoding
+    const long newPosition = encoder.getCount() / 2;  // Divide by 2 for half-step encoding
     if (newPosition == lastPosition) {
         return false;
     }
@@ -120,7 +119,7 @@ void EncoderControl::adjustBrightness(LedControl& ledControl) {
 
 void EncoderControl::updateButton() {
     // Raw reading: true when pressed (INPUT_PULLUP -> LOW when pressed)
-    const bool reading = (digitalRead(ENCODER_BUTTON) == LOW);
+    const bool reading = (digitalRead(kBoard.encoderButton) == LOW);
 
     if (reading != lastButtonReading) {
         lastDebounceTime = millis();
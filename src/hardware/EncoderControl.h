@@ -8,7 +8,7 @@
 
 class EncoderControl {
 private:
-    ESP32Encoder* encoder;
+    ESP32Encoder encoder;
     long lastPosition;
     int currentIndex;
     bool buttonState;       // debounced state (true = pressed)
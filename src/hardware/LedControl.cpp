@@ -1,54 +1,61 @@
 #include "LedControl.h"
 #include "ColorUtils.h" // Include the new color_utils header
+#include "util/Metrics.h"
+#include "util/Trace.h"
 
-// Constructor
-LedControl::LedControl() {
-    // RGBW strips are commonly SK6812 with GRBW byte order
-    strip = new Adafruit_NeoPixel(NUM_LEDS, LED_PIN, NEO_GRBW + NEO_KHZ800);
+namespace {
+MetricHistogram s_showTime("vitrine_led_show_seconds", "LED strip show() duration");
+
+constexpr neoPixelType stripType(LedStripType type) {
+    return type == LedStripType::Ws2812bGrb ? NEO_GRB + NEO_KHZ800 : NEO_GRBW + NEO_KHZ800;
 }
+} // namespace
+
+// Constructor
+LedControl::LedControl() : strip(kBoard.numLeds, kBoard.ledPin, stripType(kBoard.ledType)) {}
 
 // Initialize LED strip
 void LedControl::begin() {
-    strip->begin();
-    strip->clear();
-    strip->setBrightness(125); // Default to 12/255 brightness (about 5%)
-    strip->show();
+    strip.begin();
+    strip.clear();
+    strip.setBrightness(125); // Default to 12/255 brightness (about 5%)
+    show();
 }
 
 // Set brightness (0-255)
 void LedControl::setBrightness(uint8_t brightnessPercentage) {
     uint8_t brightness = map(brightnessPercentage, 0, 100, 0, 255);
-    strip->setBrightness(brightness);
+    strip.setBrightness(brightness);
 }
 
 // Clear all LEDs
 void LedControl::clear() {
-    strip->clear();
-    strip->show();
+    strip.clear();
+    show();
 }
 
 // Light up a specific position
 void LedControl::lightPosition(int position, uint32_t color) {
-    if (position < 0 || position >= NUM_LEDS) {
+    if (position < 0 || position >= kBoard.numLeds) {
         return;
     }
     
-    strip->setPixelColor(position, color);
-    strip->show();
+    strip.setPixelColor(position, color);
+    show();
 }
 
 void LedControl::setPixel(int position, uint32_t color) {
-    if (position < 0 || position >= NUM_LEDS) {
+    if (position < 0 || position >= kBoard.numLeds) {
         return;
     }
-    strip->setPixelColor(position, color);
+    strip.setPixelColor(position, color);
 }
 
 void LedControl::setPixelRGBW(int position, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
-    if (position < 0 || position >= NUM_LEDS) {
+    if (position < 0 || position >= kBoard.numLeds) {
         return;
     }
-    strip->setPixelColor(position, r, g, b, w);
+    strip.setPixelColor(position, color_utils::stripColor(r, g, b, w));
 }
 
 void LedControl::setPixelWhite(int position, uint8_t w) {
@@ -56,61 +63,63 @@ void LedControl::setPixelWhite(int position, uint8_t w) {
 }
 
 void LedControl::show() {
-    strip->show();
+    MetricTimer timer(s_showTime);
+    TRACE_SCOPE("led.show");
+    strip.show();
 }
 
 void LedControl::fill(uint32_t color) {
-    strip->fill(color);
-    strip->show();
+    strip.fill(color);
+    show();
 }
 
 // Add clearAll method implementation to turn off all LEDs
 void LedControl::clearAll() {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        strip->setPixelColor(i, 0);
+    for (int i = 0; i < kBoard.numLeds; i++) {
+        strip.setPixelColor(i, 0);
     }
-    strip->show();
+    show();
 }
 
 void LedControl::setWhite(uint8_t brightnessPercentage) {
     uint8_t brightness = map(brightnessPercentage, 0, 100, 0, 255);
-    strip->fill(strip->Color(0, 0, 0, brightness));
-    strip->show();
+    strip.fill(color_utils::stripColor(0, 0, 0, brightness));
+    show();
 }
 
 
 // Color helper methods
 uint32_t LedControl::getColor(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
-    return strip->Color(r, g, b, w);
+    return color_utils::stripColor(r, g, b, w);
 }
 
 uint32_t LedControl::getWhite(uint8_t brightnessPercentage) {
     uint8_t brightness = map(brightnessPercentage, 0, 100, 0, 255);
-    return strip->Color(0, 0, 0, brightness);
+    return color_utils::stripColor(0, 0, 0, brightness);
 }
 
 uint32_t LedControl::getRed() {
-    return strip->Color(255,0, 0);
+    return strip.Color(255,0, 0);
 }
 
 uint32_t LedControl::getGreen() {
-    return strip->Color(0, 255, 0);
+    return strip.Color(0, 255, 0);
 }
 
 uint32_t LedControl::getBlue() {
-    return strip->Color(0, 0, 255);
+    return strip.Color(0, 0, 255);
 }
 
 uint32_t LedControl::getYellow() {
-    return strip->Color(255, 255, 0);
+    return strip.Color(255, 255, 0);
 }
 
 uint32_t LedControl::getWhiteRGB() {
-    return strip->Color(255, 255, 255);
+    return strip.Color(255, 255, 255);
 }
 
 uint32_t LedControl::getOff() {
-    return  strip->Color(0, 0, 0);
+    return  strip.Color(0, 0, 0);
 }
 
 
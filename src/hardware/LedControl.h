@@ -7,7 +7,7 @@
 
 class LedControl {
 private:
-    Adafruit_NeoPixel* strip;
+    Adafruit_NeoPixel strip;
 
 public:
     // Constructor
@@ -19,7 +19,7 @@ public:
     // Set brightness (0-255)
     void setBrightness(uint8_t brightness);
 
-    // Clear all LEDs (using strip->clear())
+    // Clear all LEDs (using strip.clear())
     void clear();
     
     // Light a specific position with a color
@@ -31,7 +31,7 @@ public:
     // Set a pixel using explicit RGBW components (no show)
     void setPixelRGBW(int position, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
 
-    // Convenience: set only the white channel (no show)
+    // Convenience: set only the white channel (no show); drawn as r=g=b on strips without one
     void setPixelWhite(int position, uint8_t w);
 
     // Push pending pixel changes to the strip
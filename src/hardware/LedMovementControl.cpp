@@ -56,7 +56,7 @@ void LedMovementControl::startAmbientRandom(uint8_t maxBrightnessPercentage, uin
     ambientDensity = density;
     lastAmbientUpdateMs = 0;
 
-    for (int i = 0; i < NUM_LEDS; i++) {
+    for (int i = 0; i < kBoard.numLeds; i++) {
         ambientLevels[i] = 0;
         ambientDelta[i] = 0;
     }
@@ -89,6 +89,14 @@ bool LedMovementControl::isAmbientActive() const {
     return pattern == Pattern::AmbientAll || pattern == Pattern::AmbientRandom;
 }
 
+const char* LedMovementControl::getAmbientName() const {
+    switch (pattern) {
+        case Pattern::AmbientAll: return "all";
+        case Pattern::AmbientRandom: return "random";
+        default: return "off";
+    }
+}
+
 void LedMovementControl::update() {
     if (pattern != Pattern::AmbientRandom) {
         return;
@@ -105,7 +113,7 @@ void LedMovementControl::update() {
     const uint8_t step = ambientStep;
 
     int active = 0;
-    for (int i = 0; i < NUM_LEDS; i++) {
+    for (int i = 0; i < kBoard.numLeds; i++) {
         if (ambientDelta[i] != 0) {
             active++;
 
@@ -124,14 +132,14 @@ void LedMovementControl::update() {
     // Spawn new fades until we reach desired density
     const int target = ambientDensity;
     for (int tries = 0; active < target && tries < 10; tries++) {
-        const int idx = random(NUM_LEDS);
+        const int idx = random(kBoard.numLeds);
         if (ambientDelta[idx] == 0 && ambientLevels[idx] == 0) {
             ambientDelta[idx] = static_cast<int8_t>(step);
             active++;
         }
     }
 
-    for (int i = 0; i < NUM_LEDS; i++) {
+    for (int i = 0; i < kBoard.numLeds; i++) {
         ledControl.setPixelWhite(i, ambientLevels[i]);
     }
     ledControl.show();
@@ -25,6 +25,8 @@ public:
     uint8_t getAmbientRandomStep() const { return ambientStep; }
     void stopAmbient();
     bool isAmbientActive() const;
+    // "off" | "all" | "random"
+    const char* getAmbientName() const;
 
     // Call frequently from loop() to advance animations
     void update();
@@ -65,8 +67,8 @@ private:
     uint8_t ambientDensity = 6;
     uint16_t ambientFrameMs = 40;
     uint8_t ambientStep = 6;
-    uint8_t ambientLevels[NUM_LEDS] = {0};
-    int8_t ambientDelta[NUM_LEDS] = {0};
+    uint8_t ambientLevels[kBoard.numLeds] = {0};
+    int8_t ambientDelta[kBoard.numLeds] = {0};
 };
 
 #endif
\ No newline at end of file
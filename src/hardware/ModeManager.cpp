@@ -7,6 +7,7 @@
 #include "modes/ModesRegistry.h"
 #include "util/SettingsStore.h"
 #include <cstring>
+#include <vector>
 #include <WiFi.h>
 #include "esp_sleep.h"
 #include "driver/gpio.h"
@@ -74,6 +75,12 @@ bool ModeManager::persistSettings() {
 }
 
 void ModeManager::addNewMiniature() {
+    // NFC is probed in the background at boot; it may be missing or not ready yet.
+    if (!nfcReader.isReady()) {
+        displayControl.showMode("NFC Read", "NFC not available");
+        return;
+    }
+
     displayControl.showMode("NFC Read", "Reading tag...");
 
     uint8_t uid[7];
@@ -313,6 +320,71 @@ bool ModeManager::setWifiApConfig(const char* ssid, const char* pass, bool passP
     return changed;
 }
 
+void ModeManager::setEventsMaxRateHz(uint8_t hz) {
+    if (hz < 1) hz = 1;
+    if (hz > 20) hz = 20;
+    if (settings.eventsMaxRateHz == hz) {
+        return;
+    }
+    settings.eventsMaxRateHz = hz;
+    persistSettings();
+}
+
+uint8_t ModeManager::getEventsMaxRateHz() const {
+    return settings.eventsMaxRateHz;
+}
+
+bool ModeManager::getMqttEnabled() const {
+    return settings.mqttEnabled;
+}
+
+const char* ModeManager::getMqttHost() const {
+    return settings.mqttHost;
+}
+
+uint16_t ModeManager::getMqttPort() const {
+    return settings.mqttPort;
+}
+
+const char* ModeManager::getMqttUser() const {
+    return settings.mqttUser;
+}
+
+bool ModeManager::hasMqttPass() const {
+    return settings.mqttPass[0] != '\0';
+}
+
+bool ModeManager::setMqttConfig(bool enabled, const char* host, uint16_t port, const char* user, const char* pass, bool passProvided) {
+    bool changed = false;
+
+    if (settings.mqttEnabled != enabled) {
+        settings.mqttEnabled = enabled;
+        changed = true;
+    }
+
+    if (host != nullptr) {
+        changed |= copyCStrIfChanged(settings.mqttHost, sizeof(settings.mqttHost), host);
+    }
+
+    if (port != 0 && settings.mqttPort != port) {
+        settings.mqttPort = port;
+        changed = true;
+    }
+
+    if (user != nullptr) {
+        changed |= copyCStrIfChanged(settings.mqttUser, sizeof(settings.mqttUser), user);
+    }
+
+    if (passProvided) {
+        changed |= copyCStrIfChanged(settings.mqttPass, sizeof(settings.mqttPass), pass);
+    }
+
+    if (changed) {
+        persistSettings();
+    }
+    return changed;
+}
+
 int ModeManager::getNumModes() const {
     return Modes::getNumModes();
 }
@@ -323,22 +395,17 @@ const char* ModeManager::getModeName(int modeIndex) const {
 
 void ModeManager::selectMainMode(std::function<void(int)> callback) {
     const int numModes = getNumModes();
-    const int maxModes = Modes::MAX_MODES;
     if (numModes <= 0) {
         return;
     }
 
-    if (numModes > maxModes) {
-        displayControl.showMode("Error", "Too many modes");
-        return;
-    }
-
     // Add a "Back" entry so users can exit without triggering a mode.
-    const char* modeNames[Modes::MAX_MODES + 1];
+    std::vector<const char*> modeNames;
+    modeNames.reserve(numModes + 1);
     for (int i = 0; i < numModes; i++) {
-        modeNames[i] = getModeName(i);
+        modeNames.push_back(getModeName(i));
     }
-    modeNames[numModes] = "Back";
+    modeNames.push_back("Back");
 
     int initialFocus = numModes;
     if (settings.lastMainModeIndex >= 0 && settings.lastMainModeIndex < numModes) {
@@ -346,8 +413,8 @@ void ModeManager::selectMainMode(std::function<void(int)> callback) {
     }
 
     selectMode(
-        modeNames,
-        numModes + 1,
+        modeNames.data(),
+        static_cast<int>(modeNames.size()),
         [&](int selectedIndex) {
             if (selectedIndex < 0 || selectedIndex >= numModes) {
                 callback(-1);
@@ -378,8 +445,11 @@ void ModeManager::selectMode(const char* const options[], int numOptions, std::f
     int lastRenderedFocusIndex = -1;
     bool optionSelected = false;
 
-    // Allow using BTN_MODE as a quick "Back" while in menus.
-    int lastModeBtnState = digitalRead(BTN_MODE);
+    // New menu: the list view must repaint fully on the first render
+    displayControl.invalidateOptions();
+
+    // Allow using the mode button as a quick "Back" while in menus.
+    int lastModeBtnState = digitalRead(kBoard.btnMode);
 
     while (!optionSelected) {
         if (focusIndex != lastRenderedFocusIndex) {
@@ -387,7 +457,7 @@ void ModeManager::selectMode(const char* const options[], int numOptions, std::f
             lastRenderedFocusIndex = focusIndex;
         }
 
-        const int modeBtnState = digitalRead(BTN_MODE);
+        const int modeBtnState = digitalRead(kBoard.btnMode);
         const bool modeBtnPressedEdge = (modeBtnState != lastModeBtnState) && (modeBtnState == LOW);
         lastModeBtnState = modeBtnState;
         if (!optionSelected && modeBtnPressedEdge) {
@@ -429,11 +499,8 @@ void ModeManager::handleModeOptions(int modeIndex) {
     }
 
     // Add a "Back" option so exiting doesn't run an action.
-    const char* optionsWithBack[Modes::MAX_MODE_OPTIONS + 1];
-    for (int i = 0; i < mode.numOptions; i++) {
-        optionsWithBack[i] = mode.options[i];
-    }
-    optionsWithBack[mode.numOptions] = "Back";
+    std::vector<const char*> optionsWithBack(mode.options, mode.options + mode.numOptions);
+    optionsWithBack.push_back("Back");
 
     const char* footerHint = nullptr;
     if (mode.name && (strcmp(mode.name, "Settings") == 0)) {
@@ -441,8 +508,8 @@ void ModeManager::handleModeOptions(int modeIndex) {
     }
 
     selectMode(
-        optionsWithBack,
-        mode.numOptions + 1,
+        optionsWithBack.data(),
+        static_cast<int>(optionsWithBack.size()),
         [&](int optionIndex) {
             if (optionIndex < 0 || optionIndex >= mode.numOptions) {
                 return;
@@ -480,6 +547,17 @@ void ModeManager::wakeFromSleep(int currentIndex) {
     ledMovementControl.setFocusMode(currentIndex);
 }
 
+void ModeManager::focusMiniature(int index) {
+    if (sleeping || index < 0 || index >= MAX_MINIATURES) {
+        return;
+    }
+    ledMovementControl.stopAmbient();
+    encoderControl.setCurrentIndex(index);
+    setLastMiniatureIndex(static_cast<uint8_t>(index));
+    displayControl.showMiniatureInfo(index);
+    ledMovementControl.setFocusMode(index);
+}
+
 bool ModeManager::isSleeping() const {
     return sleeping;
 }
@@ -514,15 +592,15 @@ bool ModeManager::isSleepMode(int modeIndex) const {
     displayControl.fillScreen(displayControl.getBlackColor());
     displayControl.setBacklight(false);
 
-#ifdef TFT_BLK
-    // Backlight is PWM-controlled (LEDC). In deep sleep the peripheral can stop,
-    // so we forcibly drive the pin LOW and hold it there.
-    ledcDetachPin(TFT_BLK);
-    pinMode(TFT_BLK, OUTPUT);
-    digitalWrite(TFT_BLK, LOW);
-    gpio_hold_en(static_cast<gpio_num_t>(TFT_BLK));
-    gpio_deep_sleep_hold_en();
-#endif
+    if (kBoard.hasBacklight()) {
+        // Backlight is PWM-controlled (LEDC). In deep sleep the peripheral can stop,
+        // so we forcibly drive the pin LOW and hold it there.
+        ledcDetachPin(kBoard.tftBlk);
+        pinMode(kBoard.tftBlk, OUTPUT);
+        digitalWrite(kBoard.tftBlk, LOW);
+        gpio_hold_en(static_cast<gpio_num_t>(kBoard.tftBlk));
+        gpio_deep_sleep_hold_en();
+    }
 
     // Stop WiFi to reduce current before sleeping.
     WiFi.disconnect(true);
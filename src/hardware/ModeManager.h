@@ -69,12 +69,27 @@ public:
     // Returns true if anything changed (and was persisted)
     bool setWifiApConfig(const char* ssid, const char* pass, bool passProvided);
 
+    // /api/events max delta rate (1..20 Hz)
+    void setEventsMaxRateHz(uint8_t hz);
+    uint8_t getEventsMaxRateHz() const;
+
+    // MQTT persisted settings (applied on boot by MqttManager)
+    bool getMqttEnabled() const;
+    const char* getMqttHost() const;
+    uint16_t getMqttPort() const;
+    const char* getMqttUser() const;
+    bool hasMqttPass() const;
+    // Returns true if anything changed (and was persisted)
+    bool setMqttConfig(bool enabled, const char* host, uint16_t port, const char* user, const char* pass, bool passProvided);
+
     // Sleep helpers
     void enterSleep();
     // Deep-sleep (lowest power). By default, no wake sources are configured; wake via reset/power-cycle.
     [[noreturn]] void powerOffDeepSleep();
     void wakeFromSleep(int currentIndex);
     bool isSleeping() const;
+    // Focus a miniature from a remote command (display + LEDs + persisted index)
+    void focusMiniature(int index);
     void setSleepTimeoutMinutes(uint16_t minutes);
     uint16_t getSleepTimeoutMinutes() const;
     uint32_t getSleepTimeoutMs() const;
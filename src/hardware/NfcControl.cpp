@@ -1,53 +1,55 @@
 #include "NfcControl.h"
 #include "config.h"
+#include "util/Trace.h"
 #include <Wire.h>
 #include <ArduinoJson.h> // Include the ArduinoJson library
 
 // Constructor
-NFCReaderControl::NFCReaderControl() {
-  wire = new TwoWire(1); // Use I2C bus 1
-  nfc = new Adafruit_PN532(NFC_SDA, NFC_SCL, wire);
-}
+NFCReaderControl::NFCReaderControl()
+    : wire(kBoard.nfcI2cBus == 0 ? Wire : Wire1), nfc(kBoard.nfcSda, kBoard.nfcScl, &wire) {}
 
 // Initialize the NFC reader
 bool NFCReaderControl::begin() {
-    if (!wire->begin(NFC_SDA, NFC_SCL)) { // Initialize the custom Wire instance
+    if (!wire.begin(kBoard.nfcSda, kBoard.nfcScl)) { // Initialize the NFC I2C bus
         Serial0.println("[begin] Custom Wire initialization failed!");
         return false;
     }
 
-    if (!nfc->begin()) {
+    if (!nfc.begin()) {
         Serial0.println("[begin] NFC object is not initialized!");
         return false;
     }
 
-    uint32_t versionData = nfc->getFirmwareVersion();
+    uint32_t versionData = nfc.getFirmwareVersion();
     if (!versionData) {
         Serial0.println("Didn't find PN53x board");
         return false;
     }
 
     // Configure the board to read NFC tags
-    nfc->SAMConfig();
+    nfc.SAMConfig();
     Serial0.println("NFC reader initialized");
+    ready = true;
     return true;
 }
 
 // Read the UID of the NFC tag
 bool NFCReaderControl::readTagUID(uint8_t* uidBuffer, uint8_t& uidLength) {
-    if (nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uidBuffer, &uidLength)) {
+    TRACE_SCOPE("nfc.readUid");
+    if (nfc.readPassiveTargetID(PN532_MIFARE_ISO14443A, uidBuffer, &uidLength)) {
         return true;
     }
     return false;
 }
 
 bool NFCReaderControl::readTagContext(uint8_t* uidBuffer, uint8_t uidLength, JsonDocument& jsonDoc) {
+    TRACE_SCOPE("nfc.readTag");
     uint8_t data[32]; // Buffer to store the tag data
     String result = ""; // Accumulate decoded text
 
     // Read multiple pages
     for (uint8_t page = 4; page < 42; page++) {
-        if (nfc->ntag2xx_ReadPage(page, data)) {
+        if (nfc.ntag2xx_ReadPage(page, data)) {
             // Process the data
             for (uint8_t i = 0; i < 4; i++) {
                 if (data[i] > 0x1F && data[i] != 0xFE) { // Ignore non-printable characters
@@ -5,11 +5,13 @@
 #include <ArduinoJson.h>
 #include <Adafruit_PN532.h>
 #include <Wire.h>
+#include <atomic>
 
 class NFCReaderControl {
 private:
-    Adafruit_PN532* nfc; // Pointer to the NFC reader object
-    TwoWire* wire;       // Pointer to the custom Wire instance
+    TwoWire& wire;      // The core's Wire/Wire1 for the board's NFC bus
+    Adafruit_PN532 nfc; // Constructed after wire (declaration order)
+    std::atomic<bool> ready{false}; // Set once begin() found the PN532 (may run on a boot task)
 
 public:
     // Constructor
@@ -18,6 +20,9 @@ public:
     // Initialize the NFC reader
     bool begin();
 
+    // True once begin() has succeeded
+    bool isReady() const { return ready.load(); }
+
     // Read the UID of the NFC tag
     bool readTagUID(uint8_t* uidBuffer, uint8_t& uidLength);
 
@@ -3,7 +3,10 @@
 #include "util/Log.h"
 #include "net/WifiManager.h"
 #include "net/WebServer.h"
+#include "net/MqttManager.h"
+#include "net/MqttDevice.h"
 #include "net/MaintenanceMode.h"
+#include "net/OtaRollback.h"
 #include "hardware/LedControl.h"
 #include "hardware/DisplayControl.h"
 #include "hardware/EncoderControl.h"
@@ -11,12 +14,23 @@
 #include "hardware/LedMovementControl.h"
 #include "hardware/ModeManager.h"
 #include "net/WsEventHandlers.h"
+#include "net/WsStateModel.h"
+#include "net/WsLogStream.h"
+#include "net/JsonPool.h"
 #include "util/DeviceSettings.h"
 #include "util/SettingsStore.h"
+#include "util/BootTimeline.h"
+#include "util/Metrics.h"
+#include "util/LoopProfiler.h"
+#include "util/HeapMonitor.h"
 
 // Network managers
 WifiManager wifiManager;
 WebServer webServer;
+WiFiClient mqttNet;
+MqttManager mqttManager(mqttNet, []() { return WiFi.status() == WL_CONNECTED; });
+WsStateModel wsState;
+WsLogStream wsLog;
 
 // Hardware control instances
 LedControl ledControl;
@@ -30,12 +44,58 @@ ModeManager modeManager(ledMovementControl, nfcReader, displayControl, encoderCo
 
 // State tracking
 int currentIndex = 0;
-bool isNFCConnected = false;
 int lastModeBtnState = HIGH;
 bool lastMaintenanceActive = false;
 unsigned long lastActivityMs = 0;
 bool inMenu = false;
 
+static MetricHistogram loopTime("vitrine_loop_seconds", "Main loop iteration duration");
+
+// Persisted settings loaded at boot (also read by the background network task)
+static DeviceSettings bootSettings;
+
+// Background boot: Wi-Fi + HTTP/WS server. Runs on core 0 so the local UI is
+// usable while the station connects.
+static void networkBootTask(void* arg) {
+  (void)arg;
+  {
+    BootTimeline::Stage stage("wifi");
+    wifiManager.begin(bootSettings);
+  }
+  {
+    BootTimeline::Stage stage("http");
+    wsState.begin(webServer.getWsServer(), &modeManager, &ledMovementControl);
+    wsLog.begin(webServer.getWsServer());
+    attachWsEventHandlers(*webServer.getWsServer(), ledControl, ledMovementControl, &modeManager, &wsState, &wsLog);
+    webServer.getEventStream()->setSources(&modeManager, &ledMovementControl, &wifiManager);
+    webServer.begin(&modeManager, &wifiManager, &mqttManager);
+    OtaRollback::getInstance().pass(OtaRollback::CheckHttp);
+  }
+  {
+    BootTimeline::Stage stage("mqtt");
+    uint8_t mac[6] = {0};
+    WiFi.macAddress(mac);
+    attachMqttDevice(mqttManager, modeManager, ledMovementControl);
+    mqttManager.begin(bootSettings, mac);
+  }
+  BootTimeline::milestone("network ready");
+  vTaskDelete(nullptr);
+}
+
+// Background boot: PN532 probing (I2C timeouts when the module is absent).
+static void nfcBootTask(void* arg) {
+  (void)arg;
+  {
+    BootTimeline::Stage stage("nfc");
+    if (nfcReader.begin()) {
+      LOGI("nfc", "NFC reader initialized");
+    } else {
+      LOGW("nfc", "NFC reader not connected. NFC features disabled.");
+    }
+  }
+  vTaskDelete(nullptr);
+}
+
 void setup() {
   // Initialize serial communication + logging
   Log::begin(Serial0, 115200);
@@ -44,53 +104,64 @@ void setup() {
   LOGI("boot", "SDK: %s", ESP.getSdkVersion());
   LOGI("boot", "CPU Freq: %u MHz", ESP.getCpuFreqMHz());
 
+  // Heap/PSRAM free, largest block and fragmentation, sampled in the background
+  HeapMonitor::begin();
+  // Fixed JSON documents/buffers for the network handlers, allocated before anything fragments the heap
+  JsonPool::begin();
+
+  // A new OTA image stays pending until the health checks pass (see OtaRollback)
+  OtaRollback::getInstance().begin();
+
   // Step 7: Maintenance mode boot trigger (optional)
   if (MaintenanceMode::checkBootTrigger()) {
     MaintenanceMode::getInstance().enter();
   }
 
-  // Load persisted settings early (needed for WiFi init)
-  DeviceSettings bootSettings;
-  SettingsStore::load(bootSettings);
+  // Staged boot: restore the local UI (LEDs + last miniature) from persisted
+  // state first, then bring up networking and NFC in the background.
+  {
+    BootTimeline::Stage stage("settings");
+    SettingsStore::load(bootSettings);
+  }
 
-  // Initialize networking
-  wifiManager.begin(bootSettings);
-  webServer.begin(&modeManager);
-  attachWsEventHandlers(*webServer.getWsServer(), ledControl, ledMovementControl, &modeManager);
+  {
+    BootTimeline::Stage stage("leds");
+    ledControl.begin();
+    LOGI("led", "LED strip initialized");
+    OtaRollback::getInstance().pass(OtaRollback::CheckLeds);
+  }
 
-  // Initialize LED strip
-  ledControl.begin();
-  LOGI("led", "LED strip initialized");
+  {
+    BootTimeline::Stage stage("display");
+    if (!displayControl.begin()) {
+      LOGE("display", "Failed to initialize TFT display!");
+    } else {
+      LOGI("display", "TFT display initialized");
+    }
+  }
 
-  // Initialize TFT display
-  if (!displayControl.begin()) {
-    LOGE("display", "Failed to initialize TFT display!");
-  } else {
-    LOGI("display", "TFT display initialized");
+  {
+    BootTimeline::Stage stage("input");
+    encoderControl.begin();
+    // Button Mode pin configuration
+    pinMode(kBoard.btnMode, INPUT_PULLUP);
   }
 
-  // Initialize the NFC reader conditionally
-  if (nfcReader.begin()) {
-    LOGI("nfc", "NFC reader initialized");
-    isNFCConnected = true;
-  } else {
-    LOGW("nfc", "NFC reader not connected. NFC features disabled.");
-    isNFCConnected = false;
+  {
+    BootTimeline::Stage stage("restore ui");
+    // Load persisted settings into the ModeManager and apply them to hardware
+    modeManager.begin(&bootSettings);
+
+    // Set initial position
+    currentIndex = modeManager.getLastMiniatureIndex();
+    encoderControl.setCurrentIndex(currentIndex);
+    displayControl.showMiniatureInfo(currentIndex);
+    ledMovementControl.setFocusMode(currentIndex);
   }
-  
-  // Initialize encoder
-  encoderControl.begin();
-  // Button Mode pin configuration
-  pinMode(BTN_MODE, INPUT_PULLUP);
+  BootTimeline::milestone("first miniature shown");
 
-  // Load persisted settings into the ModeManager and apply them to hardware
-  modeManager.begin(&bootSettings);
-  
-  // Set initial position
-  currentIndex = modeManager.getLastMiniatureIndex();
-  encoderControl.setCurrentIndex(currentIndex);
-  displayControl.showMiniatureInfo(currentIndex);
-  ledMovementControl.setFocusMode(currentIndex);
+  xTaskCreatePinnedToCore(networkBootTask, "bootNet", 8192, nullptr, 1, nullptr, 0);
+  xTaskCreatePinnedToCore(nfcBootTask, "bootNfc", 4096, nullptr, 1, nullptr, 0);
 
   lastActivityMs = millis();
 
@@ -99,23 +170,84 @@ void setup() {
 }
 
 void loop() {
+  MetricTimer loopTimer(loopTime);
+  // Per-stage timing (LoopProfiler; off unless enabled via /api/profile)
+  LOOP_FRAME();
+
+  // Post-OTA health check: confirms the new image once every check has passed
+  {
+    LOOP_STAGE(Ota);
+    OtaRollback::getInstance().tick();
+  }
+
   // Flush deferred persistence (e.g., lastMiniatureIndex)
-  modeManager.tick();
+  {
+    LOOP_STAGE(Modes);
+    modeManager.tick();
+  }
+
+  // Wi-Fi reconnect state machine (non-blocking)
+  {
+    LOOP_STAGE(Wifi);
+    wifiManager.tick();
+  }
+
+  // MQTT / Home Assistant: remote commands count as user activity
+  bool mqttActivity;
+  {
+    LOOP_STAGE(Mqtt);
+    mqttActivity = mqttManager.tick();
+  }
+  if (mqttActivity) {
+    LOOP_STAGE(Broadcast);
+    lastActivityMs = millis();
+    currentIndex = encoderControl.getCurrentIndex();
+    if (webServer.getWsServer() && !modeManager.isSleeping()) {
+      broadcastDisplayMiniature(*webServer.getWsServer(), currentIndex);
+    }
+  }
 
   // Network is handled asynchronously by ESPAsyncWebServer
 
+  // Versioned WS state: broadcast deltas for changes made by any input
+  {
+    LOOP_STAGE(WsState);
+    wsState.tick();
+  }
+
+  // Live log lines for subscribed WS clients (batched, rate-limited)
+  {
+    LOOP_STAGE(WsLog);
+    wsLog.tick();
+  }
+
+  // SSE telemetry deltas (rate-limited; also measures loop lag)
+  {
+    LOOP_STAGE(Events);
+    webServer.getEventStream()->tick();
+  }
+
   // Advance ambient animations (non-blocking)
-  ledMovementControl.update();
+  {
+    LOOP_STAGE(Leds);
+    ledMovementControl.update();
+  }
 
   // Sleep handling: wake on any user input
-  int modeBtnState = digitalRead(BTN_MODE);
+  int modeBtnState = digitalRead(kBoard.btnMode);
   const bool modeBtnPressedEdge = (modeBtnState != lastModeBtnState) && (modeBtnState == LOW);
 
   if (modeManager.isSleeping()) {
-    const bool encoderMoved = encoderControl.checkMovement();
-    const bool encoderPressed = encoderControl.isButtonPressed();
+    bool encoderMoved;
+    bool encoderPressed;
+    {
+      LOOP_STAGE(Input);
+      encoderMoved = encoderControl.checkMovement();
+      encoderPressed = encoderControl.isButtonPressed();
+    }
 
     if (encoderMoved || encoderPressed || modeBtnPressedEdge) {
+      LOOP_STAGE(Display);
       currentIndex = encoderControl.getCurrentIndex();
       modeManager.wakeFromSleep(currentIndex);
       lastActivityMs = millis();
@@ -125,6 +257,7 @@ void loop() {
     } else {
       // Keep loop light while sleeping
       lastModeBtnState = modeBtnState;
+      LOOP_STAGE(Idle);
       delay(20);
     }
     return;
@@ -138,10 +271,18 @@ void loop() {
       ledControl.clearAll();
     }
     lastMaintenanceActive = true;
+    LOOP_STAGE(Idle);
     delay(50);
     return;
   }
 
+  if (lastMaintenanceActive) {
+    // Left maintenance without a reboot (filesystem OTA): restore the focus lighting
+    LOGI("maint", "Maintenance mode ended: resuming");
+    currentIndex = encoderControl.getCurrentIndex();
+    ledMovementControl.setFocusMode(currentIndex);
+    lastActivityMs = millis();
+  }
   lastMaintenanceActive = false;
 
   // Auto-sleep after inactivity (if enabled)
@@ -166,6 +307,7 @@ void loop() {
 
       inMenu = true;
 
+      LOOP_STAGE(Menu);
       modeManager.selectMainMode(
         [&](int modeIndex) {
           if (modeIndex < 0) {
@@ -204,7 +346,12 @@ void loop() {
   }
 
   // Check for encoder movement
-  if (encoderControl.checkMovement()) {
+  bool encoderMoved;
+  {
+    LOOP_STAGE(Input);
+    encoderMoved = encoderControl.checkMovement();
+  }
+  if (encoderMoved) {
     lastActivityMs = millis();
     if (ledMovementControl.isAmbientActive()) {
       // Ignore focus updates while ambient is active
@@ -214,20 +361,30 @@ void loop() {
       modeManager.setLastMiniatureIndex(static_cast<uint8_t>(currentIndex));
 
       // Update display with new miniature info
-      displayControl.showMiniatureInfo(currentIndex);
+      {
+        LOOP_STAGE(Display);
+        displayControl.showMiniatureInfo(currentIndex);
+      }
 
       if (webServer.getWsServer()) {
+        LOOP_STAGE(Broadcast);
         broadcastEncoderRotate(*webServer.getWsServer(), currentIndex);
         broadcastDisplayMiniature(*webServer.getWsServer(), currentIndex);
       }
 
       // Highlight the corresponding LED position
+      LOOP_STAGE(Leds);
       ledMovementControl.setFocusMode(currentIndex,ledMovementControl.getIsStandbyLight() );
 
       LOGI("encoder", "Selected position: %d", currentIndex);
     }
   }
-   if (encoderControl.isButtonPressed()) {
+  bool encoderPressed;
+  {
+    LOOP_STAGE(Input);
+    encoderPressed = encoderControl.isButtonPressed();
+  }
+   if (encoderPressed) {
     lastActivityMs = millis();
     if (ledMovementControl.isAmbientActive()) {
       // Ignore selection mode while ambient is active
@@ -237,11 +394,15 @@ void loop() {
       if (webServer.getWsServer()) {
         broadcastEncoderPress(*webServer.getWsServer(), currentIndex);
       }
+      mqttManager.publishEvent("press", currentIndex + 1);
 
       // Set selected mode
       ledMovementControl.setSelectedMode(currentIndex);
 
-      delay(500);
+      {
+        LOOP_STAGE(Idle);
+        delay(500);
+      }
 
       // Return to focus mode
       ledMovementControl.setFocusMode(currentIndex);
@@ -250,5 +411,6 @@ void loop() {
   
 
 
+  LOOP_STAGE(Idle);
   delay(10);
 }
@@ -4,16 +4,15 @@ class ModeManager;
 
 namespace Modes {
 
-static constexpr int MAX_MODE_OPTIONS = 8;
-static constexpr int MAX_MODES = 8;
-
 using ModeAction = void (*)(ModeManager&);
 
+// Options/actions point at static arrays owned by each registry entry, so a mode
+// can list as many options as it needs (the menu view scrolls).
 struct ModeDef {
     const char* name;
-    const char* options[MAX_MODE_OPTIONS];
+    const char* const* options;
     int numOptions;
-    ModeAction actions[MAX_MODE_OPTIONS];
+    const ModeAction* actions;
 };
 
 int getNumModes();
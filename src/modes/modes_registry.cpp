@@ -6,42 +6,40 @@
 #include "SettingsMode.h"
 #include "SleepMode.h"
 
+#define MODE_COUNT_OF(arr) static_cast<int>(sizeof(arr) / sizeof((arr)[0]))
+
 namespace Modes {
 
+static const char* const ADD_MINI_OPTIONS[] = {"Start NFC Read"};
+static const ModeAction ADD_MINI_ACTIONS[] = {addMini_startNfcRead};
+
+static const char* const SETTINGS_OPTIONS[] = {"Backlight Brightness", "LED Brightness", "Standby Brightness", "Speed ambient lights", "Sleep timeout", "Power off", "Reset"};
+static const ModeAction SETTINGS_ACTIONS[] = {settings_backlightBrightness, settings_ledBrightness, settings_standbyBrightness, settings_ambientSpeed, settings_sleepTimeout, settings_powerOff, settings_reset};
+
+static const char* const SLEEP_OPTIONS[] = {"Enter sleep"};
+static const ModeAction SLEEP_ACTIONS[] = {sleep_enter};
+
+static const char* const AMBIENT_OPTIONS[] = {"All Lights", "Random"};
+static const ModeAction AMBIENT_ACTIONS[] = {ambient_allLights, ambient_random};
+
+static const char* const INFO_OPTIONS[] = {"View Details"};
+static const ModeAction INFO_ACTIONS[] = {info_viewDetails};
+
+static_assert(MODE_COUNT_OF(ADD_MINI_OPTIONS) == MODE_COUNT_OF(ADD_MINI_ACTIONS), "Add Mini options/actions mismatch");
+static_assert(MODE_COUNT_OF(SETTINGS_OPTIONS) == MODE_COUNT_OF(SETTINGS_ACTIONS), "Settings options/actions mismatch");
+static_assert(MODE_COUNT_OF(SLEEP_OPTIONS) == MODE_COUNT_OF(SLEEP_ACTIONS), "Sleep options/actions mismatch");
+static_assert(MODE_COUNT_OF(AMBIENT_OPTIONS) == MODE_COUNT_OF(AMBIENT_ACTIONS), "Ambient options/actions mismatch");
+static_assert(MODE_COUNT_OF(INFO_OPTIONS) == MODE_COUNT_OF(INFO_ACTIONS), "Info options/actions mismatch");
+
 static const ModeDef MODE_DEFS[] = {
-    {
-        "Add Mini",
-        {"Start NFC Read"},
-        1,
-        {addMini_startNfcRead}
-    },
-    {
-        "Settings",
-        {"Backlight Brightness", "LED Brightness", "Standby Brightness", "Speed ambient lights", "Sleep timeout", "Power off", "Reset"},
-        7,
-        {settings_backlightBrightness, settings_ledBrightness, settings_standbyBrightness, settings_ambientSpeed, settings_sleepTimeout, settings_powerOff, settings_reset}
-    },
-    {
-        "Sleep",
-        {"Enter sleep"},
-        1,
-        {sleep_enter}
-    },
-    {
-        "Ambient Light",
-        {"All Lights", "Random"},
-        2,
-        {ambient_allLights, ambient_random}
-    },
-    {
-        "Miniature Info",
-        {"View Details"},
-        1,
-        {info_viewDetails}
-    },
+    {"Add Mini", ADD_MINI_OPTIONS, MODE_COUNT_OF(ADD_MINI_OPTIONS), ADD_MINI_ACTIONS},
+    {"Settings", SETTINGS_OPTIONS, MODE_COUNT_OF(SETTINGS_OPTIONS), SETTINGS_ACTIONS},
+    {"Sleep", SLEEP_OPTIONS, MODE_COUNT_OF(SLEEP_OPTIONS), SLEEP_ACTIONS},
+    {"Ambient Light", AMBIENT_OPTIONS, MODE_COUNT_OF(AMBIENT_OPTIONS), AMBIENT_ACTIONS},
+    {"Miniature Info", INFO_OPTIONS, MODE_COUNT_OF(INFO_OPTIONS), INFO_ACTIONS},
 };
 
-static const int MODE_COUNT = sizeof(MODE_DEFS) / sizeof(MODE_DEFS[0]);
+static const int MODE_COUNT = MODE_COUNT_OF(MODE_DEFS);
 
 int getNumModes() {
     return MODE_COUNT;
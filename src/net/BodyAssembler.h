@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Fixed buffer that assembles one multi-chunk request body at a time.
+// - One owner (the request) holds it from acquire() to release(). An owner idle for longer
+//   than the stale timeout is displaced by the next acquire(), which hands the displaced
+//   owner back so the caller can answer it.
+// - Chunks must arrive in order, without gaps, with a constant total that fits Capacity;
+//   anything else is rejected and the buffer stays with its owner until released.
+// - Not synchronized: the caller serializes calls (WebServer holds a portMUX).
+// Header-only and free of Arduino/AsyncWebServer so it can be fuzzed on the host.
+template <typename Owner, size_t Capacity>
+class BodyAssembler {
+public:
+    enum class Append : uint8_t {
+        Partial,   // accepted, more chunks to come
+        Complete,  // accepted, data()/size() hold the whole body
+        Rejected,  // not the owner, or a chunk that doesn't fit the body being assembled
+    };
+
+    // displaced: the previous (stale) owner, or nullptr
+    bool acquire(Owner* who, uint32_t nowMs, uint32_t staleMs, Owner*& displaced) {
+        displaced = nullptr;
+        if (owner && (nowMs - ownerSinceMs) <= staleMs) {
+            return false;
+        }
+        displaced = owner;
+        owner = who;
+        ownerSinceMs = nowMs;
+        filled = 0;
+        expected = 0;
+        return true;
+    }
+
+    bool ownedBy(Owner* who) const { return who && owner == who; }
+
+    Append append(Owner* who, const uint8_t* data, size_t len, size_t index, size_t total) {
+        if (!ownedBy(who) || total > Capacity || index != filled || index > total ||
+            len > total - index) {
+            return Append::Rejected;
+        }
+        if (index == 0) {
+            expected = total;
+        } else if (total != expected) {
+            return Append::Rejected;
+        }
+        memcpy(buf + index, data, len);
+        filled += len;
+        return filled == expected ? Append::Complete : Append::Partial;
+    }
+
+    // No-op unless who holds the buffer (a displaced owner's late release is ignored)
+    void release(Owner* who) {
+        if (ownedBy(who)) {
+            owner = nullptr;
+            filled = 0;
+            expected = 0;
+        }
+    }
+
+    const char* data() const { return reinterpret_cast<const char*>(buf); }
+    size_t size() const { return filled; }
+
+private:
+    uint8_t buf[Capacity];
+    Owner* owner = nullptr;
+    uint32_t ownerSinceMs = 0;
+    size_t filled = 0;
+    size_t expected = 0;
+};
@@ -0,0 +1,156 @@
+#include "EventStream.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "WifiManager.h"
+#include "hardware/LedMovementControl.h"
+#include "hardware/ModeManager.h"
+#include "util/Log.h"
+
+namespace {
+constexpr uint8_t kMinRateHz = 1;
+constexpr uint8_t kMaxRateHz = 20;
+constexpr uint32_t kClientRetryMs = 2000;
+
+// Below these, changes are noise and not worth a delta
+constexpr uint32_t kHeapThresholdBytes = 1024;
+constexpr int kRssiThresholdDbm = 2;
+constexpr int kLoopLagThresholdMs = 5;
+} // namespace
+
+EventStream::EventStream() : events("/api/events") {}
+
+void EventStream::begin(AsyncWebServer* server) {
+    events.onConnect([this](AsyncEventSourceClient* client) {
+        handleConnect(client);
+    });
+    server->addHandler(&events);
+    lastTickUs = micros();
+    started = true;
+}
+
+void EventStream::setSources(ModeManager* modeManagerIn, LedMovementControl* ledMovementControlIn, WifiManager* wifiManagerIn) {
+    modeManager = modeManagerIn;
+    ledMovementControl = ledMovementControlIn;
+    wifiManager = wifiManagerIn;
+}
+
+void EventStream::setMaxRateHz(uint8_t hz) {
+    maxRateHz = constrain(hz, kMinRateHz, kMaxRateHz);
+}
+
+void EventStream::publish(const char* event, const char* json) {
+    if (!started || events.count() == 0) {
+        return;
+    }
+    events.send(json, event, millis());
+}
+
+void EventStream::readSample(Sample& out) {
+    out.focus = modeManager ? modeManager->getLastMiniatureIndex() : 0;
+    if (modeManager && modeManager->isSleeping()) {
+        out.led = "sleep";
+    } else if (ledMovementControl && ledMovementControl->isAmbientActive()) {
+        out.led = ledMovementControl->getAmbientName();
+    } else {
+        out.led = "focus";
+    }
+    out.heap = ESP.getFreeHeap();
+    out.loopLagMs = static_cast<uint16_t>(min<uint32_t>(maxGapUs / 1000, UINT16_MAX));
+    out.rssi = wifiManager ? wifiManager->getRssi() : 0;
+}
+
+size_t EventStream::formatSnapshot(char* out, size_t outSize, const Sample& s) {
+    const int n = snprintf(out, outSize,
+                           "{\"focus\":%d,\"led\":\"%s\",\"heap\":%lu,\"loopLagMs\":%u,\"rssi\":%d}",
+                           s.focus, s.led, (unsigned long)s.heap, s.loopLagMs, s.rssi);
+    return (n > 0 && static_cast<size_t>(n) < outSize) ? static_cast<size_t>(n) : 0;
+}
+
+void EventStream::handleConnect(AsyncEventSourceClient* client) {
+    // AsyncTCP task: copy the latest sample, format outside the lock
+    Sample s;
+    portENTER_CRITICAL(&sampleMux);
+    s = current;
+    portEXIT_CRITICAL(&sampleMux);
+
+    char buf[128];
+    if (formatSnapshot(buf, sizeof(buf), s) > 0) {
+        client->send(buf, "snapshot", millis(), kClientRetryMs);
+    }
+}
+
+void EventStream::tick() {
+    const uint32_t nowUs = micros();
+    const uint32_t gapUs = nowUs - lastTickUs;
+    lastTickUs = nowUs;
+    if (gapUs > maxGapUs) {
+        maxGapUs = gapUs;
+    }
+
+    if (!started) {
+        return;
+    }
+
+    const uint32_t nowMs = millis();
+    if (nowMs - lastEmitMs < 1000u / maxRateHz) {
+        return;
+    }
+    lastEmitMs = nowMs;
+
+    Sample s;
+    readSample(s);
+    maxGapUs = 0;
+
+    portENTER_CRITICAL(&sampleMux);
+    current = s;
+    portEXIT_CRITICAL(&sampleMux);
+
+    if (events.count() == 0) {
+        // Nobody listening: new clients start from the snapshot anyway
+        sent = s;
+        return;
+    }
+
+    char buf[128];
+    size_t len = 0;
+    auto sep = [&len]() { return len > 1 ? "," : ""; };
+    auto advance = [&len, &buf](int n) {
+        if (n > 0 && len + n < sizeof(buf)) {
+            len += n;
+        }
+    };
+
+    buf[len++] = '{';
+    if (s.focus != sent.focus) {
+        advance(snprintf(buf + len, sizeof(buf) - len, "%s\"focus\":%d", sep(), s.focus));
+        sent.focus = s.focus;
+    }
+    if (!sent.led || strcmp(s.led, sent.led) != 0) {
+        advance(snprintf(buf + len, sizeof(buf) - len, "%s\"led\":\"%s\"", sep(), s.led));
+        sent.led = s.led;
+    }
+    if ((s.heap > sent.heap ? s.heap - sent.heap : sent.heap - s.heap) >= kHeapThresholdBytes) {
+        advance(snprintf(buf + len, sizeof(buf) - len, "%s\"heap\":%lu", sep(), (unsigned long)s.heap));
+        sent.heap = s.heap;
+    }
+    if (abs(static_cast<int>(s.loopLagMs) - static_cast<int>(sent.loopLagMs)) >= kLoopLagThresholdMs) {
+        advance(snprintf(buf + len, sizeof(buf) - len, "%s\"loopLagMs\":%u", sep(), s.loopLagMs));
+        sent.loopLagMs = s.loopLagMs;
+    }
+    if (abs(static_cast<int>(s.rssi) - static_cast<int>(sent.rssi)) >= kRssiThresholdDbm) {
+        advance(snprintf(buf + len, sizeof(buf) - len, "%s\"rssi\":%d", sep(), s.rssi));
+        sent.rssi = s.rssi;
+    }
+
+    if (len == 1) {
+        return; // nothing changed enough
+    }
+    if (len + 2 > sizeof(buf)) {
+        return;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+    events.send(buf, "delta", nowMs);
+}
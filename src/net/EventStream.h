@@ -0,0 +1,66 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+
+class ModeManager;
+class LedMovementControl;
+class WifiManager;
+
+// Server-Sent Events telemetry on /api/events (read-only dashboards).
+// - "snapshot" event with every field on connect
+// - "delta" events with only the fields that changed, coalesced to at most maxRateHz
+// - other producers (OTA progress) publish their own named events; the stream stays
+//   open in maintenance mode
+class EventStream {
+public:
+    EventStream();
+
+    void begin(AsyncWebServer* server);
+    void setSources(ModeManager* modeManager, LedMovementControl* ledMovementControl, WifiManager* wifiManager);
+
+    // Call every loop() pass (also measures loop lag)
+    void tick();
+
+    void setMaxRateHz(uint8_t hz);
+    uint8_t getMaxRateHz() const { return maxRateHz; }
+
+    size_t clientCount() { return events.count(); }
+
+    // Send a named event with a preformatted JSON payload to all clients (AsyncTCP task)
+    void publish(const char* event, const char* json);
+
+private:
+    struct Sample {
+        int16_t focus;
+        const char* led;
+        uint32_t heap;
+        uint16_t loopLagMs;
+        int8_t rssi;
+    };
+
+    void readSample(Sample& out);
+    static size_t formatSnapshot(char* out, size_t outSize, const Sample& s);
+    void handleConnect(AsyncEventSourceClient* client);
+
+    AsyncEventSource events;
+    std::atomic<bool> started{false};
+
+    ModeManager* modeManager = nullptr;
+    LedMovementControl* ledMovementControl = nullptr;
+    WifiManager* wifiManager = nullptr;
+
+    uint8_t maxRateHz = 4;
+    uint32_t lastEmitMs = 0;
+
+    // Loop lag: longest gap between two tick() calls since the last emit
+    uint32_t lastTickUs = 0;
+    uint32_t maxGapUs = 0;
+
+    // Latest sample (read by the AsyncTCP task for snapshots)
+    portMUX_TYPE sampleMux = portMUX_INITIALIZER_UNLOCKED;
+    Sample current = {0, "focus", 0, 0, 0};
+
+    // Last values sent to clients (delta baseline)
+    Sample sent = {-1, nullptr, 0, 0, 0};
+};
@@ -0,0 +1,73 @@
+#include "FsListStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../util/JsonEscape.h"
+
+bool FsListStream::next() {
+    pendingLen = 0;
+    pendingPos = 0;
+
+    if (!started) {
+        started = true;
+        if (fs) {
+            root = fs->open("/");
+            rootFailed = !root;
+        }
+        pendingLen = snprintf(pending, sizeof(pending), "{\"mounted\":%s,\"files\":[", fs ? "true" : "false");
+        return true;
+    }
+
+    if (fs && root) {
+        fs::File file = root.openNextFile();
+        while (file) {
+            size_t n = 0;
+            if (!firstEntry) {
+                pending[n++] = ',';
+            }
+            n += snprintf(pending + n, sizeof(pending) - n, "{\"name\":\"");
+            // Room is kept for the closing quote
+            const char* name = file.name();
+            const size_t nameLen = json_escape::escape(pending + n, sizeof(pending) - n - 1, name, strlen(name));
+            if (nameLen == 0 && name[0]) {
+                // Name too long for the entry buffer: skip it
+                file = root.openNextFile();
+                continue;
+            }
+            n += nameLen;
+            pending[n++] = '"';
+            n += snprintf(pending + n, sizeof(pending) - n, ",\"size\":%u}", static_cast<unsigned>(file.size()));
+            if (n >= sizeof(pending)) {
+                file = root.openNextFile();
+                continue;
+            }
+            firstEntry = false;
+            pendingLen = n;
+            return true;
+        }
+        root.close();
+    }
+
+    if (!finished) {
+        finished = true;
+        pendingLen = snprintf(pending, sizeof(pending), "]%s}",
+                              rootFailed ? ",\"error\":\"Failed to open LittleFS root\"" : "");
+        return true;
+    }
+    return false;
+}
+
+size_t FsListStream::fill(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (pendingPos >= pendingLen && !next()) {
+            break;
+        }
+        const size_t n = std::min(maxLen - written, pendingLen - pendingPos);
+        memcpy(buffer + written, pending + pendingPos, n);
+        pendingPos += n;
+        written += n;
+    }
+    return written;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Incremental generator for GET /api/fs: {"mounted":bool,"files":[{"name":..,"size":..},...]}
+// One directory entry at a time is formatted into a fixed buffer and copied out as the
+// chunked response asks for it, so memory stays flat however many files the filesystem
+// holds. Entries whose JSON doesn't fit the buffer are skipped.
+class FsListStream {
+public:
+    // fs: the mounted filesystem, or nullptr when it isn't mounted
+    explicit FsListStream(fs::FS* fs) : fs(fs) {}
+
+    // Chunked response callback: up to maxLen bytes, 0 once the document is complete
+    size_t fill(uint8_t* buffer, size_t maxLen);
+
+private:
+    // Produce the next piece of JSON into pending[]. Returns false when the document is complete.
+    bool next();
+
+    fs::FS* const fs;
+    bool started = false;
+    bool finished = false;
+    bool firstEntry = true;
+    bool rootFailed = false;
+    fs::File root;
+
+    char pending[160];
+    size_t pendingLen = 0;
+    size_t pendingPos = 0;
+};
@@ -0,0 +1,154 @@
+#include "HotFileCache.h"
+#include "../util/Log.h"
+
+#include <esp_heap_caps.h>
+#include <new>
+
+namespace {
+// Files worth keeping in RAM: requested on every page load / SPA route.
+const char* const kHotPaths[] = {
+    "/index.html",
+    "/update/index.html",
+    "/vite.svg",
+    "/favicon.ico",
+};
+constexpr size_t kNumHotPaths = sizeof(kHotPaths) / sizeof(kHotPaths[0]);
+
+bool isHotPath(const String& path) {
+    for (size_t i = 0; i < kNumHotPaths; i++) {
+        if (path == kHotPaths[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// In front of every cached buffer
+struct BufferHeader {
+    std::atomic<uint32_t> refs;
+    uint32_t reserved;  // keeps the data 8-byte aligned
+};
+
+BufferHeader* headerOf(const uint8_t* data) {
+    return reinterpret_cast<BufferHeader*>(const_cast<uint8_t*>(data) - sizeof(BufferHeader));
+}
+
+// Returns the data pointer, with one reference (the cache's)
+uint8_t* allocBuffer(size_t len) {
+    // Prefer PSRAM so the cache doesn't eat internal heap
+    void* p = heap_caps_malloc(sizeof(BufferHeader) + len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) {
+        p = malloc(sizeof(BufferHeader) + len);
+    }
+    if (!p) {
+        return nullptr;
+    }
+    BufferHeader* header = new (p) BufferHeader();
+    header->refs = 1;
+    return reinterpret_cast<uint8_t*>(header + 1);
+}
+
+void formatEtag(char* out, size_t outSize, const uint8_t* data, size_t len) {
+    // FNV-1a over the content
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    snprintf(out, outSize, "\"%08x\"", static_cast<unsigned>(h));
+}
+} // namespace
+
+static_assert(sizeof(kHotPaths) / sizeof(kHotPaths[0]) <= HotFileCache::kMaxEntries, "Too many hot paths");
+
+HotFileCache::~HotFileCache() {
+    invalidate();
+}
+
+uint8_t* HotFileCache::readFile(fs::FS& fs, const String& path, size_t& outLen) {
+    outLen = 0;
+    File file = fs.open(path, "r");
+    if (!file || file.isDirectory()) {
+        return nullptr;
+    }
+
+    const size_t len = file.size();
+    if (len == 0 || len > kMaxFileBytes || (totalBytes + len) > kMaxTotalBytes) {
+        LOGW("cache", "Not caching %s (%u bytes)", path.c_str(), static_cast<unsigned>(len));
+        return nullptr;
+    }
+
+    uint8_t* buf = allocBuffer(len);
+    if (!buf) {
+        return nullptr;
+    }
+    if (file.read(buf, len) != len) {
+        release(buf);
+        return nullptr;
+    }
+
+    totalBytes += len;
+    outLen = len;
+    return buf;
+}
+
+void HotFileCache::load(fs::FS& fs) {
+    invalidate();
+
+    for (size_t i = 0; i < kNumHotPaths && numEntries < kMaxEntries; i++) {
+        const String path = kHotPaths[i];
+
+        Entry& e = entries[numEntries];
+        e.data = readFile(fs, path, e.len);
+        if (!e.data) {
+            continue;
+        }
+        e.gzData = readFile(fs, path + ".gz", e.gzLen);
+
+        strncpy(e.path, path.c_str(), sizeof(e.path) - 1);
+        e.path[sizeof(e.path) - 1] = '\0';
+        formatEtag(e.etag, sizeof(e.etag), e.data, e.len);
+        if (e.gzData) {
+            formatEtag(e.gzEtag, sizeof(e.gzEtag), e.gzData, e.gzLen);
+        }
+        numEntries++;
+    }
+
+    LOGI("cache", "Hot file cache: %u files, %u bytes", static_cast<unsigned>(numEntries), static_cast<unsigned>(totalBytes));
+}
+
+void HotFileCache::invalidate() {
+    for (size_t i = 0; i < numEntries; i++) {
+        // Responses still sending from these keep them alive
+        release(entries[i].data);
+        release(entries[i].gzData);
+        entries[i] = Entry{};
+    }
+    numEntries = 0;
+    totalBytes = 0;
+}
+
+const HotFileCache::Entry* HotFileCache::find(const String& path) {
+    for (size_t i = 0; i < numEntries; i++) {
+        if (path == entries[i].path) {
+            hits++;
+            return &entries[i];
+        }
+    }
+    if (isHotPath(path)) {
+        misses++;
+    }
+    return nullptr;
+}
+
+void HotFileCache::retain(const uint8_t* data) {
+    if (data) {
+        headerOf(data)->refs++;
+    }
+}
+
+void HotFileCache::release(const uint8_t* data) {
+    if (data && --headerOf(data)->refs == 0) {
+        free(headerOf(data));
+    }
+}
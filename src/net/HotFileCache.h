@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <atomic>
+
+// Bounded in-memory copy of a few small, hot LittleFS files (SPA shell, OTA page, icons).
+// Loaded once at startup (PSRAM when available) and served with zero flash I/O.
+// invalidate()/load() must be called when the filesystem image changes (FS OTA).
+// Buffers are reference counted: the cache holds one reference and a response sending from a
+// buffer holds another (retain()/release()), so a reload never frees memory still being sent.
+class HotFileCache {
+public:
+    static constexpr size_t kMaxEntries = 4;
+    static constexpr size_t kMaxFileBytes = 16 * 1024;
+    static constexpr size_t kMaxTotalBytes = 64 * 1024;
+
+    struct Entry {
+        char path[32];
+        uint8_t* data;
+        size_t len;
+        uint8_t* gzData;   // optional "<path>.gz" variant (nullptr if absent)
+        size_t gzLen;
+        char etag[16];     // content hash of data
+        char gzEtag[16];   // content hash of gzData
+    };
+
+    ~HotFileCache();
+
+    // (Re)load the hot file set from fs. Missing or oversized files are skipped.
+    void load(fs::FS& fs);
+
+    // Drop all cached contents (e.g. before the filesystem is rewritten)
+    void invalidate();
+
+    // Cached entry for path, or nullptr. Lookups of hot paths count as hit/miss.
+    const Entry* find(const String& path);
+
+    // Keep an entry's data/gzData alive for an in-flight response; release() when it is done
+    static void retain(const uint8_t* data);
+    static void release(const uint8_t* data);
+
+    uint32_t getHits() const { return hits.load(); }
+    uint32_t getMisses() const { return misses.load(); }
+    size_t getBytes() const { return totalBytes; }
+
+private:
+    Entry entries[kMaxEntries] = {};
+    size_t numEntries = 0;
+    size_t totalBytes = 0;
+
+    std::atomic<uint32_t> hits{0};
+    std::atomic<uint32_t> misses{0};
+
+    uint8_t* readFile(fs::FS& fs, const String& path, size_t& outLen);
+};
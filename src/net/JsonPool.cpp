@@ -0,0 +1,240 @@
+#include "JsonPool.h"
+
+#include <esp_heap_caps.h>
+
+#include "../util/Log.h"
+#include "../util/Metrics.h"
+
+namespace {
+constexpr size_t kAlign = 8;  // 64-bit values live in the document's slots
+
+MetricCounter s_docMisses("vitrine_json_pool_misses", "JSON work that fell back to the heap", "pool=\"doc\"");
+MetricCounter s_arenaMisses("vitrine_json_pool_misses", "JSON work that fell back to the heap", "pool=\"arena\"");
+MetricCounter s_bufferMisses("vitrine_json_pool_misses", "JSON work that fell back to the heap", "pool=\"buffer\"");
+MetricGauge s_arenaPeak("vitrine_json_arena_peak_bytes", "Most arena bytes a pooled document has used");
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+JsonArena s_arenas[JsonPool::kDocs];
+bool s_arenaLeased[JsonPool::kDocs];
+bool s_ready = false;
+char* s_buffers[JsonPool::kBuffers];
+bool s_bufferLeased[JsonPool::kBuffers];
+JsonArena s_heapArena;
+
+size_t alignUp(size_t n) {
+    return (n + kAlign - 1) & ~(kAlign - 1);
+}
+
+// Long-lived pool memory: prefer PSRAM, fall back to internal RAM
+void* allocPool(size_t size) {
+    void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : malloc(size);
+}
+} // namespace
+
+void JsonArena::attach(uint8_t* memIn, size_t size) {
+    mem = memIn;
+    capacity = size;
+    rewind();
+}
+
+void JsonArena::rewind() {
+    top = 0;
+    peak = 0;
+    last = kNoBlock;
+}
+
+bool JsonArena::owns(const void* ptr) const {
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    return mem && p >= mem && p < mem + capacity;
+}
+
+void* JsonArena::heapAllocate(size_t size) {
+    if (mem) {
+        JsonPool::countMiss(JsonPool::Miss::Arena);
+    }
+    return malloc(size);
+}
+
+void* JsonArena::allocate(size_t size) {
+    const size_t need = sizeof(Block) + alignUp(size);
+    if (!mem || top + need > capacity) {
+        return heapAllocate(size);
+    }
+    Block* block = reinterpret_cast<Block*>(mem + top);
+    block->size = static_cast<uint32_t>(size);
+    block->prev = last;
+    last = static_cast<uint32_t>(top);
+    top += need;
+    peak = max(peak, top);
+    return block + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    blockOf(ptr)->size |= kFreed;
+    // Pop every freed block at the top; holes below are reclaimed by rewind()
+    while (last != kNoBlock) {
+        const Block* block = reinterpret_cast<const Block*>(mem + last);
+        if (!(block->size & kFreed)) {
+            break;
+        }
+        top = last;
+        last = block->prev;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (!ptr) {
+        return allocate(newSize);
+    }
+    if (!owns(ptr)) {
+        return realloc(ptr, newSize);
+    }
+
+    Block* block = blockOf(ptr);
+    const uint32_t offset = static_cast<uint32_t>(reinterpret_cast<uint8_t*>(block) - mem);
+    if (offset == last) {
+        const size_t end = offset + sizeof(Block) + alignUp(newSize);
+        if (end <= capacity) {
+            block->size = static_cast<uint32_t>(newSize);
+            top = end;
+            peak = max(peak, top);
+            return ptr;
+        }
+    } else if (newSize <= block->size) {
+        // Shrinking a block below the top: keep it where it is
+        block->size = static_cast<uint32_t>(newSize);
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved) {
+        memcpy(moved, ptr, min(static_cast<size_t>(block->size), newSize));
+        deallocate(ptr);
+    }
+    return moved;
+}
+
+bool JsonPool::begin() {
+    if (s_ready) {
+        return true;
+    }
+    uint8_t* arenaMem = static_cast<uint8_t*>(allocPool(kDocs * kDocArenaBytes));
+    char* bufferMem = static_cast<char*>(allocPool(kBuffers * kBufferBytes));
+    if (!arenaMem || !bufferMem) {
+        free(arenaMem);
+        free(bufferMem);
+        LOGE("json", "No memory for the JSON pool: using the heap");
+        return false;
+    }
+    for (size_t i = 0; i < kDocs; i++) {
+        s_arenas[i].attach(arenaMem + i * kDocArenaBytes, kDocArenaBytes);
+    }
+    for (size_t i = 0; i < kBuffers; i++) {
+        s_buffers[i] = bufferMem + i * kBufferBytes;
+    }
+    portENTER_CRITICAL(&s_mux);
+    s_ready = true;
+    portEXIT_CRITICAL(&s_mux);
+    LOGI("json", "JSON pool: %u x %u B documents, %u x %u B buffers", static_cast<unsigned>(kDocs),
+         static_cast<unsigned>(kDocArenaBytes), static_cast<unsigned>(kBuffers), static_cast<unsigned>(kBufferBytes));
+    return true;
+}
+
+JsonArena* JsonPool::acquireArena() {
+    JsonArena* arena = nullptr;
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; s_ready && i < kDocs; i++) {
+        if (!s_arenaLeased[i]) {
+            s_arenaLeased[i] = true;
+            arena = &s_arenas[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return arena;
+}
+
+void JsonPool::releaseArena(JsonArena* arena) {
+    // The document has freed its blocks by now: report the arena's high-water mark
+    const size_t used = arena->getPeak();
+    if (static_cast<int32_t>(used) > s_arenaPeak.value()) {
+        s_arenaPeak.set(static_cast<int32_t>(used));
+    }
+    arena->rewind();
+    portENTER_CRITICAL(&s_mux);
+    s_arenaLeased[arena - s_arenas] = false;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+JsonArena* JsonPool::heapArena() {
+    return &s_heapArena;
+}
+
+char* JsonPool::acquireBuffer() {
+    char* buffer = nullptr;
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; s_ready && i < kBuffers; i++) {
+        if (!s_bufferLeased[i]) {
+            s_bufferLeased[i] = true;
+            buffer = s_buffers[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return buffer;
+}
+
+void JsonPool::releaseBuffer(char* buffer) {
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; i < kBuffers; i++) {
+        if (s_buffers[i] == buffer) {
+            s_bufferLeased[i] = false;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void JsonPool::countMiss(Miss miss) {
+    switch (miss) {
+        case Miss::Doc: s_docMisses.inc(); break;
+        case Miss::Arena: s_arenaMisses.inc(); break;
+        case Miss::Buffer: s_bufferMisses.inc(); break;
+    }
+}
+
+PooledJsonBuffer::~PooledJsonBuffer() {
+    releaseStorage();
+}
+
+void PooledJsonBuffer::releaseStorage() {
+    if (pooled) {
+        JsonPool::releaseBuffer(buffer);
+    } else {
+        free(buffer);
+    }
+    buffer = nullptr;
+    pooled = false;
+}
+
+bool PooledJsonBuffer::serialize(const JsonDocument& doc) {
+    const size_t need = measureJson(doc) + 1;
+    if (!pooled || need > JsonPool::kBufferBytes) {
+        JsonPool::countMiss(JsonPool::Miss::Buffer);
+        releaseStorage();
+        buffer = static_cast<char*>(malloc(need));
+        if (!buffer) {
+            len = 0;
+            return false;
+        }
+    }
+    len = serializeJson(doc, buffer, need);
+    return true;
+}
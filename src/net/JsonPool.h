@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+
+// Bump allocator for one JsonDocument over a fixed block of memory.
+// - Blocks are carved from the top; the last block grows/shrinks in place (ArduinoJson
+//   reallocates string buffers and shrinks pools that way), freed blocks at the top are popped.
+// - When the arena is full, or has no memory attached, allocations go to the heap.
+// Used by one document at a time (see JsonPool); not thread-safe by itself.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    void attach(uint8_t* mem, size_t size);
+    // Forgets every block (the document using the arena must be gone)
+    void rewind();
+    size_t getUsed() const { return top; }
+    // Most bytes in use since the last rewind()
+    size_t getPeak() const { return peak; }
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+private:
+    struct Block {
+        uint32_t size;  // kFreed bit set once deallocated
+        uint32_t prev;  // offset of the previous block, kNoBlock for the first
+    };
+    static constexpr uint32_t kFreed = 0x80000000u;
+    static constexpr uint32_t kNoBlock = 0xffffffffu;
+
+    uint8_t* mem = nullptr;
+    size_t capacity = 0;
+    size_t top = 0;
+    size_t peak = 0;
+    uint32_t last = kNoBlock;  // offset of the topmost block
+
+    bool owns(const void* ptr) const;
+    Block* blockOf(void* ptr) const { return reinterpret_cast<Block*>(static_cast<uint8_t*>(ptr) - sizeof(Block)); }
+    void* heapAllocate(size_t size);
+};
+
+// Fixed pool of JSON documents and output buffers for the network handlers.
+// - begin() allocates kDocs arenas and kBuffers output buffers once, at boot (PSRAM preferred).
+// - PooledJsonDocument is a JsonDocument whose memory comes from an arena leased for its
+//   scope; PooledJsonBuffer serializes into a leased buffer. Steady-state messages and
+//   requests therefore cost no heap allocation for JSON work.
+// - Misses (no free lease, arena or buffer too small) fall back to the heap and are counted
+//   in vitrine_json_pool_misses_total; vitrine_json_arena_peak_bytes tells how close the
+//   arenas get to full.
+// Leases are taken and returned under a spinlock: safe from any task.
+class JsonPool {
+public:
+    static constexpr size_t kDocs = 4;
+    static constexpr size_t kDocArenaBytes = 8 * 1024;
+    static constexpr size_t kBuffers = 3;
+    static constexpr size_t kBufferBytes = 2 * 1024;
+
+    static bool begin();
+
+    // nullptr when every arena is leased
+    static JsonArena* acquireArena();
+    static void releaseArena(JsonArena* arena);
+    // Arena without memory: every allocation goes to the heap
+    static JsonArena* heapArena();
+
+    // nullptr when every buffer is leased
+    static char* acquireBuffer();
+    static void releaseBuffer(char* buffer);
+
+    enum class Miss : uint8_t { Doc, Arena, Buffer };
+    static void countMiss(Miss miss);
+};
+
+// Base-from-member: the arena must be leased before the JsonDocument is constructed
+class JsonArenaLease {
+protected:
+    JsonArenaLease() : leased(JsonPool::acquireArena()) {
+        if (!leased) {
+            JsonPool::countMiss(JsonPool::Miss::Doc);
+        }
+    }
+    ~JsonArenaLease() {
+        if (leased) {
+            JsonPool::releaseArena(leased);
+        }
+    }
+    ArduinoJson::Allocator* allocator() { return leased ? leased : JsonPool::heapArena(); }
+
+private:
+    JsonArena* const leased;
+};
+
+// A JsonDocument for one scope (message, request, broadcast) backed by a pooled arena.
+// The document is destroyed before the lease is returned (base order).
+class PooledJsonDocument : private JsonArenaLease, public JsonDocument {
+public:
+    PooledJsonDocument() : JsonArenaLease(), JsonDocument(allocator()) {}
+
+    PooledJsonDocument(const PooledJsonDocument&) = delete;
+    PooledJsonDocument& operator=(const PooledJsonDocument&) = delete;
+};
+
+// Serialized JSON in a pooled buffer (heap only when none is free or the output is too big)
+class PooledJsonBuffer {
+public:
+    PooledJsonBuffer() : buffer(JsonPool::acquireBuffer()), pooled(buffer != nullptr) {}
+    ~PooledJsonBuffer();
+
+    PooledJsonBuffer(const PooledJsonBuffer&) = delete;
+    PooledJsonBuffer& operator=(const PooledJsonBuffer&) = delete;
+
+    // False when out of memory
+    bool serialize(const JsonDocument& doc);
+    const char* c_str() const { return buffer ? buffer : ""; }
+    size_t length() const { return len; }
+
+private:
+    char* buffer;
+    bool pooled;
+    size_t len = 0;
+
+    void releaseStorage();
+};
@@ -29,11 +29,11 @@ bool MaintenanceMode::isActive() const {
 }
 
 bool MaintenanceMode::checkBootTrigger() {
-    // Check if BTN_MODE is held LOW at boot (future OTA trigger)
-    pinMode(BTN_MODE, INPUT_PULLUP);
+    // Check if the mode button is held LOW at boot (future OTA trigger)
+    pinMode(kBoard.btnMode, INPUT_PULLUP);
     delay(10); // Small debounce
     
-    bool triggered = (digitalRead(BTN_MODE) == LOW);
+    bool triggered = (digitalRead(kBoard.btnMode) == LOW);
     
     if (triggered) {
         LOGI("maint", "Maintenance mode triggered by button at boot");
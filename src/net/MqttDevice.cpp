@@ -0,0 +1,116 @@
+#include "MqttDevice.h"
+
+#include <cstring>
+
+#include "config.h"
+#include "MaintenanceMode.h"
+#include "hardware/LedMovementControl.h"
+#include "hardware/ModeManager.h"
+#include "util/Log.h"
+
+namespace {
+// Restored by "light ON" after "light OFF"
+uint8_t lastOnBrightness = 40;
+
+int parseInt(const char* s, int fallback) {
+    char* end = nullptr;
+    const long v = strtol(s, &end, 10);
+    return (end == s) ? fallback : static_cast<int>(v);
+}
+
+void sample(MqttManager& mqtt, ModeManager& modeManager, LedMovementControl& ledMovementControl) {
+    char buf[12];
+    const uint8_t brightness = modeManager.getLedBrightnessPercent();
+    if (brightness > 0) {
+        lastOnBrightness = brightness;
+    }
+    mqtt.setState(MqttManager::TopicLight, brightness > 0 ? "ON" : "OFF");
+    snprintf(buf, sizeof(buf), "%u", brightness);
+    mqtt.setState(MqttManager::TopicBrightness, buf);
+
+    snprintf(buf, sizeof(buf), "%u", modeManager.getLastMiniatureIndex() + 1);
+    mqtt.setState(MqttManager::TopicFocus, buf);
+
+    mqtt.setState(MqttManager::TopicAmbient, ledMovementControl.getAmbientName());
+    mqtt.setState(MqttManager::TopicSleep, modeManager.isSleeping() ? "ON" : "OFF");
+}
+
+void refreshLeds(ModeManager& modeManager, LedMovementControl& ledMovementControl) {
+    if (modeManager.isSleeping()) {
+        return;
+    }
+    // Brightness scaling is applied on the next show(); redraw the current pattern
+    if (strcmp(ledMovementControl.getAmbientName(), "all") == 0) {
+        ledMovementControl.setAmbientAllLights(modeManager.getAmbientAllLightsBrightnessPercent());
+    } else if (!ledMovementControl.isAmbientActive()) {
+        ledMovementControl.setFocusMode(modeManager.getLastMiniatureIndex(), ledMovementControl.getIsStandbyLight());
+    }
+}
+
+// Returns true when the command was applied
+bool apply(const char* name, const char* value, ModeManager& modeManager, LedMovementControl& ledMovementControl) {
+    if (MaintenanceMode::getInstance().isActive()) {
+        LOGW("mqtt", "Ignoring %s while in maintenance", name);
+        return false;
+    }
+
+    if (strcmp(name, "light") == 0) {
+        const bool on = strcmp(value, "ON") == 0;
+        const uint8_t current = modeManager.getLedBrightnessPercent();
+        if (on && current == 0) {
+            modeManager.setLedBrightnessPercent(lastOnBrightness);
+        } else if (!on && current > 0) {
+            lastOnBrightness = current;
+            modeManager.setLedBrightnessPercent(0);
+        }
+        refreshLeds(modeManager, ledMovementControl);
+    } else if (strcmp(name, "brightness") == 0) {
+        const int v = constrain(parseInt(value, -1), -1, 100);
+        if (v < 0) {
+            return false;
+        }
+        modeManager.setLedBrightnessPercent(static_cast<uint8_t>(v));
+        refreshLeds(modeManager, ledMovementControl);
+    } else if (strcmp(name, "focus") == 0) {
+        const int v = parseInt(value, 0);
+        if (v < 1 || v > MAX_MINIATURES) {
+            return false;
+        }
+        modeManager.focusMiniature(v - 1);
+    } else if (strcmp(name, "ambient") == 0) {
+        if (modeManager.isSleeping()) {
+            return false;
+        }
+        if (strcmp(value, "all") == 0) {
+            modeManager.ambientAllLights();
+        } else if (strcmp(value, "random") == 0) {
+            modeManager.ambientRandom();
+        } else if (strcmp(value, "off") == 0) {
+            modeManager.focusMiniature(modeManager.getLastMiniatureIndex());
+        } else {
+            return false;
+        }
+    } else if (strcmp(name, "sleep") == 0) {
+        if (strcmp(value, "ON") == 0) {
+            modeManager.enterSleep();
+        } else if (strcmp(value, "OFF") == 0) {
+            modeManager.wakeFromSleep(modeManager.getLastMiniatureIndex());
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+void attachMqttDevice(MqttManager& mqtt, ModeManager& modeManager, LedMovementControl& ledMovementControl) {
+    mqtt.setDevice(
+        [&mqtt, &modeManager, &ledMovementControl]() {
+            sample(mqtt, modeManager, ledMovementControl);
+        },
+        [&modeManager, &ledMovementControl](const char* name, const char* value) {
+            return apply(name, value, modeManager, ledMovementControl);
+        });
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "MqttManager.h"
+
+class ModeManager;
+class LedMovementControl;
+
+// Wires MqttManager to the vitrine (call before mqtt.begin()): the state topics follow
+// ModeManager/LedMovementControl, and <base>/cmd/<name> drives them (ignored in maintenance).
+void attachMqttDevice(MqttManager& mqtt, ModeManager& modeManager, LedMovementControl& ledMovementControl);
@@ -0,0 +1,366 @@
+#include "MqttManager.h"
+
+#include <ArduinoJson.h>
+#include <cstring>
+
+#include "config.h"
+#include "version.h"
+#include "util/Log.h"
+
+namespace {
+constexpr uint32_t kBackoffMinMs = 2000;
+constexpr uint32_t kBackoffMaxMs = 60000;
+// DNS (up to 15 s on Arduino-ESP32 2.x) and the TCP handshake run on a short-lived task,
+// bounded by the socket's own connect timeout (WiFiClient: 3 s). The loop only waits for
+// CONNACK, which a reachable broker sends within milliseconds.
+constexpr uint32_t kConnackTimeoutSec = 2;
+constexpr uint32_t kConnectTaskStackBytes = 4096;
+constexpr UBaseType_t kConnectTaskPriority = 1;
+constexpr uint16_t kKeepAliveSec = 30;
+constexpr uint16_t kBufferSize = 768;
+
+constexpr uint32_t kSampleIntervalMs = 100;
+constexpr uint32_t kMinPublishIntervalMs = 500;
+constexpr uint8_t kMaxEventsPerTick = 4;
+
+constexpr const char* kOnline = "online";
+constexpr const char* kOffline = "offline";
+constexpr const char* kDiscoveryPrefix = "homeassistant";
+
+// Indexed by MqttManager::StateTopic
+constexpr const char* kStateNames[] = {"light", "brightness", "focus", "ambient", "sleep"};
+
+void copyCStr(char* dst, size_t dstSize, const char* src) {
+    strncpy(dst, src ? src : "", dstSize - 1);
+    dst[dstSize - 1] = '\0';
+}
+} // namespace
+
+MqttManager::MqttManager(Client& netIn, std::function<bool()> networkUpIn, std::function<uint32_t()> clockIn)
+    : net(netIn), networkUp(networkUpIn), clock(clockIn), client(netIn) {}
+
+void MqttManager::setDevice(Sampler samplerIn, CommandHandler onCommandIn) {
+    sampler = samplerIn;
+    onCommand = onCommandIn;
+}
+
+void MqttManager::begin(const DeviceSettings& settings, const uint8_t mac[6]) {
+    enabled = settings.mqttEnabled && settings.mqttHost[0] != '\0';
+    copyCStr(host, sizeof(host), settings.mqttHost);
+    port = settings.mqttPort ? settings.mqttPort : 1883;
+    copyCStr(user, sizeof(user), settings.mqttUser);
+    copyCStr(pass, sizeof(pass), settings.mqttPass);
+
+    snprintf(nodeId, sizeof(nodeId), "vitrine_%02x%02x%02x", mac[3], mac[4], mac[5]);
+    snprintf(baseTopic, sizeof(baseTopic), "vitrine/%s", nodeId);
+
+    if (!enabled) {
+        state = State::Disabled;
+        LOGI("mqtt", "MQTT disabled");
+        started = true;
+        return;
+    }
+
+    client.setServer(host, port);
+    client.setKeepAlive(kKeepAliveSec);
+    client.setSocketTimeout(kConnackTimeoutSec);
+    client.setBufferSize(kBufferSize);
+    client.setCallback([this](char* topic, uint8_t* payload, unsigned int len) {
+        onMessage(topic, payload, len);
+    });
+
+    state = State::WaitingForWifi;
+    LOGI("mqtt", "MQTT broker %s:%u, base topic %s", host, port, baseTopic);
+    started = true;
+}
+
+const char* MqttManager::getStateName(State s) {
+    switch (s) {
+        case State::Disabled: return "disabled";
+        case State::WaitingForWifi: return "waiting_wifi";
+        case State::Connecting: return "connecting";
+        case State::Connected: return "connected";
+        case State::Backoff: return "backoff";
+    }
+    return "unknown";
+}
+
+void MqttManager::topicFor(char* out, size_t outSize, const char* kind, const char* name) const {
+    snprintf(out, outSize, "%s/%s/%s", baseTopic, kind, name);
+}
+
+bool MqttManager::tick() {
+    remoteChanged = false;
+    if (!started || !enabled) {
+        return false;
+    }
+
+    const uint32_t now = clock();
+
+    // Track state even while offline: slots keep only the latest value
+    if (now - lastSampleMs >= kSampleIntervalMs) {
+        lastSampleMs = now;
+        sampleState();
+    }
+
+    // The connect task owns net until it reports back
+    if (state == State::Connecting) {
+        if (!finishConnect(now)) {
+            return false;
+        }
+    } else if (!networkUp()) {
+        if (state == State::Connected) {
+            client.disconnect();
+        }
+        if (state != State::Backoff) {
+            state = State::WaitingForWifi;
+        }
+        return false;
+    } else if (!client.connected()) {
+        if (state == State::Connected) {
+            LOGW("mqtt", "Broker connection lost (state %d)", client.state());
+            state = State::Backoff;
+            backoffMs = 0;
+            nextAttemptMs = now;
+        }
+        if (static_cast<int32_t>(now - nextAttemptMs) >= 0) {
+            startConnect();
+        }
+        return false;
+    }
+
+    client.loop();
+    flushStates(now);
+    flushEvents();
+    return remoteChanged;
+}
+
+void MqttManager::startConnect() {
+    tcpResult = 0;
+    state = State::Connecting;
+    if (xTaskCreate(connectTask, "mqttConn", kConnectTaskStackBytes, this, kConnectTaskPriority, nullptr) != pdPASS) {
+        tcpResult = -1;
+    }
+}
+
+void MqttManager::connectTask(void* arg) {
+    MqttManager* self = static_cast<MqttManager*>(arg);
+    // Resolves host, then connects within the socket's timeout
+    const bool ok = self->net.connect(self->host, self->port) == 1;
+    self->tcpResult = ok ? 1 : -1;
+    vTaskDelete(nullptr);
+}
+
+void MqttManager::scheduleRetry(uint32_t nowMs, int reason) {
+    backoffMs = backoffMs ? min(backoffMs * 2, kBackoffMaxMs) : kBackoffMinMs;
+    nextAttemptMs = nowMs + backoffMs;
+    state = State::Backoff;
+    LOGW("mqtt", "Connect to %s:%u failed (state %d), retry in %lu ms", host, port, reason, (unsigned long)backoffMs);
+}
+
+bool MqttManager::finishConnect(uint32_t nowMs) {
+    const int8_t tcp = tcpResult;
+    if (tcp == 0) {
+        return false;
+    }
+    if (tcp < 0) {
+        scheduleRetry(nowMs, MQTT_CONNECT_FAILED);
+        return false;
+    }
+
+    char willTopic[48];
+    snprintf(willTopic, sizeof(willTopic), "%s/availability", baseTopic);
+
+    // The socket is already up: PubSubClient only sends CONNECT and waits for CONNACK
+    const bool ok = client.connect(nodeId,
+                                   user[0] ? user : nullptr,
+                                   user[0] ? pass : nullptr,
+                                   willTopic, 1, true, kOffline);
+    if (!ok) {
+        scheduleRetry(nowMs, client.state());
+        return false;
+    }
+
+    if (reconnectCount++ > 0) {
+        LOGI("mqtt", "Reconnected to broker");
+    } else {
+        LOGI("mqtt", "Connected to broker");
+    }
+    state = State::Connected;
+    backoffMs = 0;
+
+    client.publish(willTopic, kOnline, true);
+
+    char cmdTopic[48];
+    topicFor(cmdTopic, sizeof(cmdTopic), "cmd", "+");
+    client.subscribe(cmdTopic);
+
+    publishDiscovery();
+
+    // Retained states may have been lost (broker restart): republish everything once
+    for (auto& slot : slots) {
+        if (slot.value[0] != '\0') {
+            slot.dirty = true;
+            slot.lastPublishMs = nowMs - kMinPublishIntervalMs;
+        }
+    }
+    return true;
+}
+
+void MqttManager::publishDiscovery() {
+    struct Entity {
+        const char* component;
+        const char* object;
+        const char* name;
+    };
+    static const Entity kEntities[] = {
+        {"light", "light", "Vitrine LEDs"},
+        {"number", "focus", "Focused miniature"},
+        {"select", "ambient", "Ambient mode"},
+        {"switch", "sleep", "Sleep"},
+    };
+
+    char topic[96];
+    char payload[kBufferSize - 96];
+
+    for (const auto& e : kEntities) {
+        JsonDocument doc;
+        doc["~"] = baseTopic;
+        doc["name"] = e.name;
+
+        char uniqueId[32];
+        snprintf(uniqueId, sizeof(uniqueId), "%s_%s", nodeId, e.object);
+        doc["unique_id"] = uniqueId;
+        doc["availability_topic"] = "~/availability";
+
+        char stateTopic[24];
+        char cmdTopic[24];
+        snprintf(stateTopic, sizeof(stateTopic), "~/state/%s", e.object);
+        snprintf(cmdTopic, sizeof(cmdTopic), "~/cmd/%s", e.object);
+        doc["state_topic"] = stateTopic;
+        doc["command_topic"] = cmdTopic;
+
+        if (strcmp(e.component, "light") == 0) {
+            doc["brightness_state_topic"] = "~/state/brightness";
+            doc["brightness_command_topic"] = "~/cmd/brightness";
+            doc["brightness_scale"] = 100;
+        } else if (strcmp(e.component, "number") == 0) {
+            doc["min"] = 1;
+            doc["max"] = MAX_MINIATURES;
+            doc["step"] = 1;
+            doc["mode"] = "box";
+        } else if (strcmp(e.component, "select") == 0) {
+            JsonArray options = doc["options"].to<JsonArray>();
+            options.add("off");
+            options.add("all");
+            options.add("random");
+        }
+
+        JsonObject device = doc["device"].to<JsonObject>();
+        device["identifiers"].to<JsonArray>().add(nodeId);
+        device["name"] = "Smart Vitrine";
+        device["model"] = "ESP32-S3 Miniatures Vitrine";
+        device["sw_version"] = FIRMWARE_VERSION;
+
+        const size_t n = serializeJson(doc, payload, sizeof(payload));
+        if (n == 0 || n >= sizeof(payload)) {
+            LOGW("mqtt", "Discovery payload too large for %s", e.object);
+            continue;
+        }
+
+        snprintf(topic, sizeof(topic), "%s/%s/%s/%s/config", kDiscoveryPrefix, e.component, nodeId, e.object);
+        if (client.publish(topic, reinterpret_cast<const uint8_t*>(payload), n, true)) {
+            publishCount++;
+        }
+    }
+}
+
+void MqttManager::sampleState() {
+    if (sampler) {
+        sampler();
+    }
+}
+
+void MqttManager::setState(StateTopic topic, const char* value) {
+    StateSlot& slot = slots[topic];
+    if (strncmp(slot.value, value, sizeof(slot.value)) == 0) {
+        return;
+    }
+    copyCStr(slot.value, sizeof(slot.value), value);
+    slot.dirty = true;
+}
+
+void MqttManager::flushStates(uint32_t nowMs) {
+    char topic[48];
+    for (uint8_t i = 0; i < TopicCount; i++) {
+        StateSlot& slot = slots[i];
+        if (!slot.dirty || (nowMs - slot.lastPublishMs) < kMinPublishIntervalMs) {
+            continue;
+        }
+        topicFor(topic, sizeof(topic), "state", kStateNames[i]);
+        if (!client.publish(topic, slot.value, true)) {
+            return; // socket backed up; retry next tick
+        }
+        slot.dirty = false;
+        slot.lastPublishMs = nowMs;
+        publishCount++;
+    }
+}
+
+void MqttManager::publishEvent(const char* name, int value) {
+    if (!started || !enabled) {
+        return;
+    }
+    if (eventCount == kEventQueueLen) {
+        eventHead = (eventHead + 1) % kEventQueueLen;
+        eventCount--;
+        droppedEvents++;
+    }
+    QueuedEvent& e = events[(eventHead + eventCount) % kEventQueueLen];
+    copyCStr(e.name, sizeof(e.name), name);
+    e.value = value;
+    eventCount++;
+}
+
+void MqttManager::flushEvents() {
+    char topic[48];
+    char payload[48];
+    snprintf(topic, sizeof(topic), "%s/event", baseTopic);
+
+    for (uint8_t sent = 0; eventCount > 0 && sent < kMaxEventsPerTick; sent++) {
+        const QueuedEvent& e = events[eventHead];
+        snprintf(payload, sizeof(payload), "{\"event\":\"%s\",\"value\":%ld}", e.name, (long)e.value);
+        if (!client.publish(topic, payload, false)) {
+            return;
+        }
+        eventHead = (eventHead + 1) % kEventQueueLen;
+        eventCount--;
+        publishCount++;
+    }
+}
+
+void MqttManager::onMessage(char* topic, uint8_t* payload, unsigned int len) {
+    if (!onCommand) {
+        return;
+    }
+
+    const size_t prefixLen = strlen(baseTopic);
+    if (strncmp(topic, baseTopic, prefixLen) != 0 || strncmp(topic + prefixLen, "/cmd/", 5) != 0) {
+        return;
+    }
+    const char* name = topic + prefixLen + 5;
+
+    char value[16];
+    const size_t n = min(static_cast<size_t>(len), sizeof(value) - 1);
+    memcpy(value, payload, n);
+    value[n] = '\0';
+
+    LOGI("mqtt", "cmd %s = %s", name, value);
+    if (!onCommand(name, value)) {
+        return;
+    }
+
+    remoteChanged = true;
+    // Echo the new state promptly (still subject to the per-topic interval)
+    sampleState();
+}
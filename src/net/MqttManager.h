@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <PubSubClient.h>
+#include <atomic>
+#include <functional>
+
+#include "util/DeviceSettings.h"
+
+// MQTT 3.1.1 client + Home Assistant discovery.
+// - Runs from loop() (commands touch the display/LEDs, so they stay on the loop task).
+//   Only the broker's DNS + TCP connect runs on a short-lived task, as it can take seconds.
+// - State topics are retained and coalesced: at most one publish per topic per interval,
+//   and only the latest value is kept.
+// - Events (e.g. encoder presses) go through a small bounded queue that survives broker outages.
+// - LWT marks the device offline on the availability topic.
+// - Knows nothing about the vitrine itself: the device side reports values through setState()
+//   and applies commands (MqttDevice.h). The socket, the Wi-Fi check and the clock are injected,
+//   so test/test_mqtt_manager runs it against a local broker.
+class MqttManager {
+public:
+    enum StateTopic : uint8_t {
+        TopicLight,
+        TopicBrightness,
+        TopicFocus,
+        TopicAmbient,
+        TopicSleep,
+        TopicCount
+    };
+
+    // Both run on the loop task. The sampler runs every 100 ms and after each command and reports
+    // through setState(). The handler gets <base>/cmd/<name> and returns true when it changed the UI.
+    using Sampler = std::function<void()>;
+    using CommandHandler = std::function<bool(const char* name, const char* value)>;
+
+    // net: the broker socket (a WiFiClient on the device); its connect timeout bounds the connect
+    // task. networkUp: whether the station has an IP. clock: milliseconds.
+    MqttManager(Client& net, std::function<bool()> networkUp, std::function<uint32_t()> clock = millis);
+
+    // Call before begin()
+    void setDevice(Sampler sampler, CommandHandler onCommand);
+
+    // May run on the network boot task; tick() is a no-op until begin() finishes.
+    // mac: station MAC, which names the node ("vitrine_a1b2c3")
+    void begin(const DeviceSettings& settings, const uint8_t mac[6]);
+
+    // Call frequently from loop(). Returns true when a remote command changed the UI
+    // (caller should treat it as user activity and resync its focus index).
+    bool tick();
+
+    // Queue a one-shot event for <base>/event (oldest is dropped when the queue is full)
+    void publishEvent(const char* name, int value);
+
+    // Latest value of a state topic, published (retained) once it changes
+    void setState(StateTopic topic, const char* value);
+
+    enum class State : uint8_t {
+        Disabled,
+        WaitingForWifi,
+        Connecting,
+        Connected,
+        Backoff,
+    };
+
+    State getState() const { return state; }
+    static const char* getStateName(State state);
+
+    uint32_t getPublishCount() const { return publishCount; }
+    uint32_t getDroppedEvents() const { return droppedEvents; }
+    uint32_t getReconnectCount() const { return reconnectCount; }
+
+private:
+    struct StateSlot {
+        char value[12];
+        bool dirty;
+        uint32_t lastPublishMs;
+    };
+
+    static constexpr size_t kEventQueueLen = 16;
+    struct QueuedEvent {
+        char name[16];
+        int32_t value;
+    };
+
+    void startConnect();
+    static void connectTask(void* arg);
+    bool finishConnect(uint32_t nowMs);
+    void scheduleRetry(uint32_t nowMs, int reason);
+    void publishDiscovery();
+    void sampleState();
+    void flushStates(uint32_t nowMs);
+    void flushEvents();
+    void onMessage(char* topic, uint8_t* payload, unsigned int len);
+
+    void topicFor(char* out, size_t outSize, const char* kind, const char* name) const;
+
+    Client& net;
+    std::function<bool()> networkUp;
+    std::function<uint32_t()> clock;
+    PubSubClient client;
+
+    Sampler sampler;
+    CommandHandler onCommand;
+
+    std::atomic<bool> started{false};
+    bool enabled = false;
+    char host[MQTT_HOST_MAX_LEN + 1] = {0};
+    uint16_t port = 1883;
+    char user[MQTT_USER_MAX_LEN + 1] = {0};
+    char pass[MQTT_PASS_MAX_LEN + 1] = {0};
+
+    // "vitrine_a1b2c3" (from the STA MAC) and "vitrine/vitrine_a1b2c3"
+    char nodeId[16] = {0};
+    char baseTopic[32] = {0};
+
+    State state = State::Disabled;
+    // Written by connectTask: 0 while it runs, then 1 (TCP up) or -1 (DNS/TCP failed)
+    std::atomic<int8_t> tcpResult{0};
+    uint32_t nextAttemptMs = 0;
+    uint32_t backoffMs = 0;
+    uint32_t lastSampleMs = 0;
+    bool remoteChanged = false;
+
+    StateSlot slots[TopicCount] = {};
+
+    QueuedEvent events[kEventQueueLen] = {};
+    uint8_t eventHead = 0;
+    uint8_t eventCount = 0;
+
+    uint32_t publishCount = 0;
+    uint32_t droppedEvents = 0;
+    uint32_t reconnectCount = 0;
+};
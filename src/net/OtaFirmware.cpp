@@ -1,20 +1,46 @@
 #include "OtaFirmware.h"
 
 #include "MaintenanceMode.h"
+#include "OtaInflater.h"
+#include "OtaProgress.h"
+#include "OtaRollback.h"
+#include "OtaStage.h"
+#include "OtaWriter.h"
 #include "WsServer.h"
 #include "../util/Log.h"
 
 #include <ArduinoJson.h>
 #include <Ticker.h>
 #include <Update.h>
+#include <esp_task_wdt.h>
+#include <memory>
+#include <new>
 
 namespace {
+constexpr size_t kApplyChunkBytes = 4096;
+
 struct OtaUploadContext {
     bool ok = true;
-    bool begun = false;
     bool done = false;
-    size_t written = 0;
+    bool ownsBusy = false;  // this upload holds otaBusy
+    bool filesystem = false;
+    OtaWriter writer;
+    // Set when the upload is a gzip image (detected from the first bytes)
+    std::unique_ptr<OtaInflater> inflater;
     String error;
+    OtaProgress progress;
+    size_t uploaded = 0;
+
+    // Filesystem target: the upload is staged and verified (writer is kVerifyOnly), then
+    // copied into the spiffs partition. LittleFS is unmounted from the copy until remount().
+    OtaStage stage;
+    String signature;
+    bool fsRewritten = false;  // the copy into spiffs has started
+    bool fsUnmounted = false;
+    bool fsMounted = false;
+    OtaFirmware::UnmountHook unmount = nullptr;
+    OtaFirmware::RemountHook remount = nullptr;
+    void* fsHookCtx = nullptr;
 };
 
 Ticker rebootTicker;
@@ -23,60 +49,201 @@ volatile bool otaBusy = false;
 void scheduleRebootMs(uint32_t delayMs) {
     rebootTicker.once_ms(delayMs, []() {
         LOGW("ota", "Rebooting after OTA");
+        Log::flush();
         ESP.restart();
     });
 }
+
+// Header wins over the query string (the upload page uses the query string)
+String headerOrParam(AsyncWebServerRequest* request, const char* header, const char* param) {
+    if (request->hasHeader(header)) {
+        return request->header(header);
+    }
+    if (request->hasParam(param)) {
+        return request->getParam(param)->value();
+    }
+    return String();
+}
+
+// LittleFS v2 superblock: "littlefs" magic at offset 8 of block 0. Checked before the first
+// write so a firmware .bin sent to the filesystem endpoint never touches the partition.
+bool looksLikeLittleFs(const uint8_t* data, size_t len) {
+    return len >= 16 && memcmp(data + 8, "littlefs", 8) == 0;
+}
+
+bool writeImage(OtaUploadContext* ctx, const uint8_t* data, size_t len) {
+    if (ctx->filesystem && ctx->writer.getWritten() == 0 && !looksLikeLittleFs(data, len)) {
+        ctx->error = "Not a LittleFS image";
+        return false;
+    }
+    return ctx->writer.write(data, len);
+}
+
+void remountFilesystem(OtaUploadContext* ctx) {
+    if (!ctx->fsUnmounted) {
+        return;
+    }
+    ctx->fsUnmounted = false;
+    ctx->fsMounted = ctx->remount(ctx->fsHookCtx);
+}
+
+bool failApply(OtaUploadContext* ctx, OtaWriter& flashWriter, const char* error) {
+    ctx->error = error;
+    flashWriter.abort();
+    return false;
+}
+
+// Copies the verified image from the stage into the spiffs partition; this is the first write
+// to it. The copy is hashed again and must match the verified digest (and signature).
+// Runs in the final upload callback on the AsyncTCP task.
+bool applyStagedImage(OtaUploadContext* ctx) {
+    OtaWriter flashWriter;
+    if (!flashWriter.begin(U_SPIFFS, ctx->writer.getWritten(), ctx->writer.getDigestHex(), ctx->signature.c_str())) {
+        ctx->error = flashWriter.getError();
+        return false;
+    }
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[kApplyChunkBytes]);
+    std::unique_ptr<OtaInflater> inflater;
+    if (ctx->inflater) {
+        inflater.reset(new OtaInflater());
+    }
+    if (!buffer || (inflater && !inflater->begin())) {
+        return failApply(ctx, flashWriter, "No memory to apply the image");
+    }
+
+    // No open handles or cached reads may outlive the old image
+    ctx->unmount(ctx->fsHookCtx);
+    ctx->fsUnmounted = true;
+    ctx->fsRewritten = true;
+    LOGW("ota", "Verified; writing %u bytes to the filesystem partition", static_cast<unsigned>(ctx->writer.getWritten()));
+
+    const OtaInflater::Sink sink = [&flashWriter](const uint8_t* out, size_t outLen) {
+        return flashWriter.write(out, outLen);
+    };
+    const size_t staged = ctx->stage.getSize();
+    for (size_t offset = 0; offset < staged; offset += kApplyChunkBytes) {
+        const size_t n = (staged - offset < kApplyChunkBytes) ? staged - offset : kApplyChunkBytes;
+        if (!ctx->stage.read(offset, buffer.get(), n)) {
+            return failApply(ctx, flashWriter, "Staged image read failed");
+        }
+        const bool wrote = inflater ? inflater->feed(buffer.get(), n, sink) : flashWriter.write(buffer.get(), n);
+        if (!wrote) {
+            const char* error = flashWriter.getError();
+            if (!error[0]) {
+                error = inflater ? inflater->getError() : "Write failed";
+            }
+            return failApply(ctx, flashWriter, error);
+        }
+        ctx->progress.update(ctx->uploaded, flashWriter.getWritten());
+        // Long copy on the AsyncTCP task: keep its watchdog fed and let the idle task run
+        esp_task_wdt_reset();
+        vTaskDelay(1);
+    }
+    if (inflater && !inflater->isFinished()) {
+        return failApply(ctx, flashWriter, "Truncated gzip image");
+    }
+    if (!flashWriter.end()) {
+        ctx->error = flashWriter.getError();
+        return false;
+    }
+    return true;
+}
+
+void releaseContext(AsyncWebServerRequest* request) {
+    auto* ctx = static_cast<OtaUploadContext*>(request->_tempObject);
+    if (!ctx) {
+        return;
+    }
+    // The library free()s _tempObject; it was new'd, so delete it ourselves
+    request->_tempObject = nullptr;
+    if (ctx->writer.isActive()) {
+        LOGW("ota", "Upload aborted after %u bytes", static_cast<unsigned>(ctx->writer.getWritten()));
+        ctx->writer.abort();
+    }
+    remountFilesystem(ctx);
+    ctx->progress.finish(false, ctx->writer.getWritten(), "Upload aborted");
+    if (ctx->ownsBusy) {
+        otaBusy = false;
+    }
+    delete ctx;
+}
 } // namespace
 
+void OtaFirmware::setFilesystemHooks(void* ctx, UnmountHook unmount, RemountHook remount) {
+    fsHookCtx = ctx;
+    unmountHook = unmount;
+    remountHook = remount;
+}
+
 void OtaFirmware::attach(AsyncWebServer& server, WsServer& wsServer) {
+    attachUpload(server, wsServer, "/update/firmware", Target::Firmware);
+    attachUpload(server, wsServer, "/update/filesystem", Target::Filesystem);
+}
+
+void OtaFirmware::attachUpload(AsyncWebServer& server, WsServer& wsServer, const char* path, Target target) {
+    const bool filesystem = (target == Target::Filesystem);
     server.on(
-        "/update/firmware",
+        path,
         HTTP_POST,
-        [](AsyncWebServerRequest* request) {
+        [filesystem](AsyncWebServerRequest* request) {
             auto* ctx = static_cast<OtaUploadContext*>(request->_tempObject);
 
-            const bool ok = (ctx && ctx->done && ctx->ok && !Update.hasError());
+            const bool ok = (ctx && ctx->done && ctx->ok);
             const String err = (!ctx) ? String("No OTA context")
-                                      : (!ctx->error.isEmpty() ? ctx->error : String(Update.errorString()));
+                                      : (!ctx->error.isEmpty() ? ctx->error : String(ctx->writer.getError()));
 
             JsonDocument doc;
             doc["ok"] = ok;
             if (ctx) {
-                doc["written"] = static_cast<uint32_t>(ctx->written);
+                const OtaWriter& w = ctx->writer;
+                doc["written"] = static_cast<uint32_t>(w.getWritten());
+                if (ctx->inflater) {
+                    doc["compressed"] = static_cast<uint32_t>(ctx->inflater->getCompressedBytes());
+                }
+                doc["ms"] = w.getElapsedMs();
+                doc["kbps"] = w.getKBps();
+                if (w.getDigestHex()[0]) {
+                    doc["sha256"] = w.getDigestHex();
+                }
+                doc["sha256Verified"] = w.isDigestVerified();
+                doc["signatureVerified"] = w.isSignatureVerified();
+                if (filesystem && ctx->fsRewritten) {
+                    doc["mounted"] = ctx->fsMounted;
+                }
             }
             if (!ok) {
                 doc["error"] = err;
             }
 
-            String out;
-            serializeJson(doc, out);
+            AsyncResponseStream* response = request->beginResponseStream("application/json");
+            response->setCode(ok ? 200 : 500);
+            serializeJson(doc, *response);
+            request->send(response);
 
-            request->send(ok ? 200 : 500, "application/json", out);
+            releaseContext(request);
 
-            if (ctx) {
-                delete ctx;
-                request->_tempObject = nullptr;
+            if (!ok) {
+                return;
             }
-
-            otaBusy = false;
-
-            if (ok) {
+            if (filesystem) {
+                // New web assets are live: no reboot needed
+                MaintenanceMode::getInstance().exit();
+            } else {
                 scheduleRebootMs(800);
             }
         },
-        [&wsServer](AsyncWebServerRequest* request,
-                   const String& filename,
-                   size_t index,
-                   uint8_t* data,
-                   size_t len,
-                   bool final) {
+        [this, &wsServer, filesystem](AsyncWebServerRequest* request,
+                                      const String& filename,
+                                      size_t index,
+                                      uint8_t* data,
+                                      size_t len,
+                                      bool final) {
             auto* ctx = static_cast<OtaUploadContext*>(request->_tempObject);
 
             if (index == 0) {
-                if (ctx) {
-                    delete ctx;
-                }
+                releaseContext(request);
                 ctx = new OtaUploadContext();
+                ctx->filesystem = filesystem;
                 request->_tempObject = ctx;
 
                 if (otaBusy) {
@@ -86,21 +253,73 @@ void OtaFirmware::attach(AsyncWebServer& server, WsServer& wsServer) {
                     LOGW("ota", "Rejecting OTA upload (%s): busy", filename.c_str());
                     return;
                 }
+                if (filesystem && (!unmountHook || !remountHook)) {
+                    ctx->ok = false;
+                    ctx->done = true;
+                    ctx->error = "Filesystem update unavailable";
+                    return;
+                }
+                if (filesystem && OtaRollback::getInstance().isPendingVerify()) {
+                    // Staging would overwrite the rollback image
+                    ctx->ok = false;
+                    ctx->done = true;
+                    ctx->error = "Firmware not confirmed yet; retry after the health check";
+                    return;
+                }
 
                 otaBusy = true;
+                ctx->ownsBusy = true;
 
-                LOGW("ota", "Starting OTA firmware upload: %s", filename.c_str());
+                // A dropped connection must not leave Update half-open or the busy flag set
+                request->onDisconnect([request]() {
+                    releaseContext(request);
+                });
+
+                LOGW("ota", "Starting OTA %s upload: %s", filesystem ? "filesystem" : "firmware", filename.c_str());
+                // Multipart body length: slightly more than the file, close enough for % and ETA
+                ctx->progress.start(progressStream, filesystem ? "filesystem" : "firmware", request->contentLength());
                 MaintenanceMode::getInstance().enter();
                 wsServer.closeAll();
 
-                if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+                const String sha256 = headerOrParam(request, "X-Firmware-SHA256", "sha256");
+                ctx->signature = headerOrParam(request, "X-Firmware-Signature", "sig");
+                // Size of the raw image (after inflating a .gz), if the client knows it
+                const long sizeParam = headerOrParam(request, "X-Image-Size", "size").toInt();
+                const size_t imageSize = sizeParam > 0 ? static_cast<size_t>(sizeParam) : 0;
+                // Filesystem: nothing reaches the spiffs partition before the whole image is verified
+                const int command = filesystem ? OtaWriter::kVerifyOnly : U_FLASH;
+                if (!ctx->writer.begin(command, imageSize, sha256.c_str(), ctx->signature.c_str())) {
                     ctx->ok = false;
-                    ctx->error = Update.errorString();
-                    LOGE("ota", "Update.begin failed: %s", ctx->error.c_str());
+                    ctx->error = ctx->writer.getError();
+                    ctx->progress.finish(false, 0, ctx->error.c_str());
                     return;
                 }
+                if (filesystem && !ctx->stage.begin()) {
+                    ctx->ok = false;
+                    ctx->error = ctx->stage.getError();
+                    ctx->writer.abort();
+                    ctx->progress.finish(false, 0, ctx->error.c_str());
+                    return;
+                }
+
+                // .bin.gz: inflate on the fly; digest/signature still cover the raw image
+                if (OtaInflater::isGzip(data, len)) {
+                    ctx->inflater.reset(new OtaInflater());
+                    if (!ctx->inflater->begin()) {
+                        ctx->ok = false;
+                        ctx->error = ctx->inflater->getError();
+                        ctx->writer.abort();
+                        ctx->progress.finish(false, 0, ctx->error.c_str());
+                        return;
+                    }
+                    LOGI("ota", "Compressed (gzip) image");
+                }
 
-                ctx->begun = true;
+                if (filesystem) {
+                    ctx->unmount = unmountHook;
+                    ctx->remount = remountHook;
+                    ctx->fsHookCtx = fsHookCtx;
+                }
             }
 
             if (!ctx || !ctx->ok) {
@@ -108,34 +327,60 @@ void OtaFirmware::attach(AsyncWebServer& server, WsServer& wsServer) {
             }
 
             if (len > 0) {
-                const size_t writtenNow = Update.write(data, len);
-                if (writtenNow != len) {
+                bool wrote;
+                if (ctx->inflater) {
+                    wrote = ctx->inflater->feed(data, len, [ctx](const uint8_t* out, size_t outLen) {
+                        return writeImage(ctx, out, outLen);
+                    });
+                } else {
+                    wrote = writeImage(ctx, data, len);
+                }
+                if (wrote && ctx->filesystem && !ctx->stage.write(data, len)) {
+                    ctx->error = ctx->stage.getError();
+                    wrote = false;
+                }
+                if (!wrote) {
                     ctx->ok = false;
-                    ctx->error = Update.errorString();
-                    LOGE("ota", "Update.write failed: %s", ctx->error.c_str());
+                    if (ctx->error.isEmpty()) {
+                        const char* error = ctx->writer.getError();
+                        if (!error[0]) {
+                            error = ctx->inflater ? ctx->inflater->getError() : "Write failed";
+                        }
+                        ctx->error = error;
+                    }
+                    ctx->writer.abort();
+                    ctx->progress.finish(false, ctx->writer.getWritten(), ctx->error.c_str());
                     return;
                 }
-                ctx->written += writtenNow;
+                ctx->uploaded = index + len;
+                ctx->progress.update(ctx->uploaded, ctx->writer.getWritten());
             }
 
             if (final) {
-                if (ctx->begun) {
-                    if (!Update.end(true)) {
-                        ctx->ok = false;
-                        ctx->error = Update.errorString();
-                        LOGE("ota", "Update.end failed: %s", ctx->error.c_str());
-                    } else {
-                        LOGW("ota", "OTA finished. Written %u bytes", static_cast<unsigned>(ctx->written));
-                    }
-                } else {
+                if (ctx->inflater && !ctx->inflater->isFinished()) {
+                    ctx->ok = false;
+                    ctx->error = "Truncated gzip image";
+                    ctx->writer.abort();
+                    ctx->progress.finish(false, ctx->writer.getWritten(), ctx->error.c_str());
+                    ctx->done = true;
+                    return;
+                }
+                if (!ctx->writer.end()) {
                     ctx->ok = false;
-                    ctx->error = "Update was not started";
+                    ctx->error = ctx->writer.getError();
+                } else if (ctx->filesystem && !applyStagedImage(ctx)) {
+                    ctx->ok = false;
+                } else {
+                    LOGW("ota", "OTA finished. Written %u bytes", static_cast<unsigned>(ctx->writer.getWritten()));
                 }
-
-                if (!ctx->ok && ctx->begun) {
-                    Update.abort();
+                if (ctx->filesystem) {
+                    remountFilesystem(ctx);
+                    if (ctx->ok && !ctx->fsMounted) {
+                        ctx->ok = false;
+                        ctx->error = "Image written but LittleFS failed to mount";
+                    }
                 }
-
+                ctx->progress.finish(ctx->ok, ctx->writer.getWritten(), ctx->error.c_str());
                 ctx->done = true;
             }
         });
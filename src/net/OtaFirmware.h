@@ -3,8 +3,30 @@
 #include <ESPAsyncWebServer.h>
 
 class WsServer;
+class EventStream;
 
+// OTA uploads:
+// - POST /update/firmware   -> app partition (U_FLASH), reboots on success
+// - POST /update/filesystem -> LittleFS image into the "spiffs" partition (U_SPIFFS), remounts without reboot
 class OtaFirmware {
 public:
+    // A filesystem image can only be written with LittleFS unmounted. Both hooks run on the
+    // async_tcp task; remount returns whether LittleFS mounted again.
+    using UnmountHook = void (*)(void* ctx);
+    using RemountHook = bool (*)(void* ctx);
+
+    void setFilesystemHooks(void* ctx, UnmountHook unmount, RemountHook remount);
+    // Progress of the running upload is published there as "ota" events
+    void setProgressStream(EventStream* stream) { progressStream = stream; }
     void attach(AsyncWebServer& server, WsServer& wsServer);
+
+private:
+    enum class Target : uint8_t { Firmware, Filesystem };
+
+    void attachUpload(AsyncWebServer& server, WsServer& wsServer, const char* path, Target target);
+
+    void* fsHookCtx = nullptr;
+    UnmountHook unmountHook = nullptr;
+    RemountHook remountHook = nullptr;
+    EventStream* progressStream = nullptr;
 };
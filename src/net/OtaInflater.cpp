@@ -0,0 +1,236 @@
+#include "OtaInflater.h"
+
+#include <esp_heap_caps.h>
+
+#if __has_include("esp32s3/rom/miniz.h")
+#include "esp32s3/rom/miniz.h"
+#else
+#include "rom/miniz.h"
+#endif
+
+namespace {
+constexpr uint8_t kGzipId1 = 0x1f;
+constexpr uint8_t kGzipId2 = 0x8b;
+constexpr uint8_t kGzipDeflate = 8;
+
+constexpr uint8_t kFlagHeaderCrc = 0x02;
+constexpr uint8_t kFlagExtra = 0x04;
+constexpr uint8_t kFlagName = 0x08;
+constexpr uint8_t kFlagComment = 0x10;
+
+// Large, short-lived buffers: prefer PSRAM, fall back to internal RAM
+void* allocBuffer(size_t size) {
+    void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : malloc(size);
+}
+
+// Standard CRC-32 (gzip/zlib), table built on first use
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    while (len--) {
+        crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t readLe32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+} // namespace
+
+OtaInflater::~OtaInflater() {
+    release();
+}
+
+bool OtaInflater::isGzip(const uint8_t* data, size_t len) {
+    return len >= 3 && data[0] == kGzipId1 && data[1] == kGzipId2 && data[2] == kGzipDeflate;
+}
+
+void OtaInflater::release() {
+    free(decomp);
+    decomp = nullptr;
+    free(window);
+    window = nullptr;
+}
+
+bool OtaInflater::fail(const char* message) {
+    error = message;
+    state = State::Failed;
+    release();
+    return false;
+}
+
+bool OtaInflater::begin() {
+    release();
+    state = State::Header;
+    flags = 0;
+    fixedLen = 0;
+    extraRemaining = 0;
+    extraLenBytes = 0;
+    headerCrcRemaining = 0;
+    windowOfs = 0;
+    crc = 0;
+    trailerLen = 0;
+    compressedBytes = 0;
+    inflatedBytes = 0;
+    error = "";
+
+    decomp = static_cast<tinfl_decompressor*>(allocBuffer(sizeof(tinfl_decompressor)));
+    window = static_cast<uint8_t*>(allocBuffer(TINFL_LZ_DICT_SIZE));
+    if (!decomp || !window) {
+        return fail("Out of memory for inflate window");
+    }
+    tinfl_init(decomp);
+    return true;
+}
+
+size_t OtaInflater::parseHeader(const uint8_t* data, size_t len) {
+    size_t used = 0;
+    while (used < len && state != State::Body && state != State::Failed) {
+        const uint8_t b = data[used++];
+        switch (state) {
+            case State::Header:
+                fixed[fixedLen++] = b;
+                if (fixedLen == sizeof(fixed)) {
+                    if (fixed[0] != kGzipId1 || fixed[1] != kGzipId2 || fixed[2] != kGzipDeflate) {
+                        fail("Not a gzip/deflate stream");
+                        break;
+                    }
+                    flags = fixed[3];
+                    state = State::Extra;
+                }
+                break;
+            case State::Extra:
+                if (!(flags & kFlagExtra)) {
+                    state = State::Name;
+                    used--; // re-process this byte
+                } else if (extraLenBytes < 2) {
+                    extraRemaining |= static_cast<uint16_t>(b) << (8 * extraLenBytes++);
+                    if (extraLenBytes == 2 && extraRemaining == 0) {
+                        state = State::Name;
+                    }
+                } else if (--extraRemaining == 0) {
+                    state = State::Name;
+                }
+                break;
+            case State::Name:
+                if (!(flags & kFlagName)) {
+                    state = State::Comment;
+                    used--;
+                } else if (b == 0) {
+                    state = State::Comment;
+                }
+                break;
+            case State::Comment:
+                if (!(flags & kFlagComment)) {
+                    state = State::HeaderCrc;
+                    headerCrcRemaining = (flags & kFlagHeaderCrc) ? 2 : 0;
+                    used--;
+                } else if (b == 0) {
+                    state = State::HeaderCrc;
+                    headerCrcRemaining = (flags & kFlagHeaderCrc) ? 2 : 0;
+                }
+                break;
+            case State::HeaderCrc:
+                if (headerCrcRemaining == 0) {
+                    state = State::Body;
+                    used--;
+                } else if (--headerCrcRemaining == 0) {
+                    state = State::Body;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return used;
+}
+
+size_t OtaInflater::parseTrailer(const uint8_t* data, size_t len) {
+    const size_t n = min(len, sizeof(trailer) - trailerLen);
+    memcpy(trailer + trailerLen, data, n);
+    trailerLen += n;
+    if (trailerLen == sizeof(trailer)) {
+        if (readLe32(trailer) != crc) {
+            fail("gzip CRC mismatch");
+        } else if (readLe32(trailer + 4) != static_cast<uint32_t>(inflatedBytes)) {
+            fail("gzip size mismatch");
+        } else {
+            state = State::Done;
+            release();
+        }
+    }
+    return n;
+}
+
+bool OtaInflater::feed(const uint8_t* data, size_t len, const Sink& sink) {
+    compressedBytes += len;
+
+    while (len > 0 || state == State::Body) {
+        if (state == State::Failed) {
+            return false;
+        }
+        if (state == State::Done) {
+            // Trailing garbage after the gzip member is ignored
+            return true;
+        }
+
+        if (state != State::Body && state != State::Trailer) {
+            const size_t used = parseHeader(data, len);
+            data += used;
+            len -= used;
+            continue;
+        }
+
+        if (state == State::Trailer) {
+            const size_t used = parseTrailer(data, len);
+            data += used;
+            len -= used;
+            continue;
+        }
+
+        // Body: inflate into the ring window, flushing each produced span to the sink
+        size_t inBytes = len;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - windowOfs;
+        const tinfl_status status = tinfl_decompress(decomp, data, &inBytes, window, window + windowOfs, &outBytes,
+                                                     TINFL_FLAG_HAS_MORE_INPUT);
+        data += inBytes;
+        len -= inBytes;
+
+        if (outBytes > 0) {
+            crc = crc32Update(crc, window + windowOfs, outBytes);
+            inflatedBytes += outBytes;
+            if (!sink(window + windowOfs, outBytes)) {
+                return fail("Write failed");
+            }
+            windowOfs = (windowOfs + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if (status < TINFL_STATUS_DONE) {
+            return fail("Corrupt deflate stream");
+        }
+        if (status == TINFL_STATUS_DONE) {
+            state = State::Trailer;
+            continue;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0) {
+            return true;
+        }
+        // TINFL_STATUS_HAS_MORE_OUTPUT: window wrapped, keep going
+    }
+    return state != State::Failed;
+}
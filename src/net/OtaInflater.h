@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+struct tinfl_decompressor_tag;
+
+// Streaming gzip decoder for compressed OTA uploads.
+// Uses the ROM tinfl (miniz) inflater with a fixed 32 KB ring window; decompressed bytes are
+// handed to the sink as they are produced (no whole-image buffering). The gzip trailer
+// (CRC-32 + size) is checked once the deflate stream ends.
+class OtaInflater {
+public:
+    using Sink = std::function<bool(const uint8_t* data, size_t len)>;
+
+    ~OtaInflater();
+
+    static bool isGzip(const uint8_t* data, size_t len);
+
+    bool begin();
+    // Feed compressed bytes; returns false on corrupt input or when the sink fails
+    bool feed(const uint8_t* data, size_t len, const Sink& sink);
+    // True once the deflate stream and a valid trailer have been consumed
+    bool isFinished() const { return state == State::Done; }
+
+    const char* getError() const { return error; }
+    size_t getCompressedBytes() const { return compressedBytes; }
+    size_t getInflatedBytes() const { return inflatedBytes; }
+
+private:
+    enum class State : uint8_t { Header, Extra, Name, Comment, HeaderCrc, Body, Trailer, Done, Failed };
+
+    bool fail(const char* message);
+    void release();
+    size_t parseHeader(const uint8_t* data, size_t len);
+    size_t parseTrailer(const uint8_t* data, size_t len);
+
+    State state = State::Header;
+    uint8_t flags = 0;
+    uint8_t fixed[10] = {0};
+    size_t fixedLen = 0;
+    uint16_t extraRemaining = 0;
+    uint8_t extraLenBytes = 0;
+    uint8_t headerCrcRemaining = 0;
+
+    tinfl_decompressor_tag* decomp = nullptr;
+    uint8_t* window = nullptr;  // TINFL_LZ_DICT_SIZE ring
+    size_t windowOfs = 0;
+
+    uint32_t crc = 0;
+    uint8_t trailer[8] = {0};
+    size_t trailerLen = 0;
+
+    size_t compressedBytes = 0;
+    size_t inflatedBytes = 0;
+    const char* error = "";
+};
@@ -0,0 +1,85 @@
+#include "OtaProgress.h"
+
+#include "EventStream.h"
+#include "../util/JsonEscape.h"
+
+void OtaProgress::start(EventStream* streamIn, const char* targetIn, size_t totalIn) {
+    stream = streamIn;
+    target = targetIn;
+    total = totalIn;
+    received = 0;
+    written = 0;
+    startMs = millis();
+    lastSendMs = startMs;
+    lastPct = 0;
+    active = true;
+    send("start", nullptr);
+}
+
+void OtaProgress::update(size_t receivedIn, size_t writtenIn) {
+    received = receivedIn;
+    written = writtenIn;
+    if (!stream || !active) {
+        return;
+    }
+
+    const uint32_t now = millis();
+    const uint32_t sinceLast = now - lastSendMs;
+    if (sinceLast < kMinGapMs) {
+        return;
+    }
+    const uint8_t pct = total ? static_cast<uint8_t>(min<uint64_t>(100, (uint64_t)received * 100 / total)) : 0;
+    if (sinceLast < kReportIntervalMs && pct < lastPct + kReportStepPct) {
+        return;
+    }
+    send("writing", nullptr);
+}
+
+void OtaProgress::finish(bool ok, size_t writtenIn, const char* error) {
+    if (!active) {
+        return;
+    }
+    active = false;
+    written = writtenIn;
+    if (ok) {
+        received = total ? total : received;
+    }
+    send(ok ? "done" : "error", ok ? nullptr : error);
+}
+
+void OtaProgress::send(const char* phase, const char* error) {
+    if (!stream) {
+        return;
+    }
+    const uint32_t now = millis();
+    const uint32_t elapsedMs = now - startMs;
+    const uint8_t pct = total ? static_cast<uint8_t>(min<uint64_t>(100, (uint64_t)received * 100 / total)) : 0;
+
+    // Rate over the whole upload so far (upload bytes, the link is the bottleneck)
+    const uint32_t bytesPerSec = elapsedMs ? static_cast<uint32_t>((uint64_t)received * 1000 / elapsedMs) : 0;
+    // -1: unknown (no total yet, or nothing received)
+    const long etaS = (total && bytesPerSec && received <= total)
+                          ? static_cast<long>((total - received + bytesPerSec - 1) / bytesPerSec)
+                          : -1;
+
+    // Error text comes from Update.errorString() and the writers: may hold quotes or control characters
+    char escapedError[96] = "";
+    if (error) {
+        json_escape::escapeTruncated(escapedError, sizeof(escapedError), error, strlen(error));
+    }
+
+    char buf[256];
+    const int n = snprintf(buf, sizeof(buf),
+                           "{\"target\":\"%s\",\"phase\":\"%s\",\"received\":%u,\"total\":%u,\"written\":%u,"
+                           "\"pct\":%u,\"kbps\":%lu,\"etaS\":%ld,\"ms\":%lu%s%s%s}",
+                           target, phase, static_cast<unsigned>(received), static_cast<unsigned>(total),
+                           static_cast<unsigned>(written), pct, (unsigned long)(bytesPerSec / 1024), etaS,
+                           (unsigned long)elapsedMs, error ? ",\"error\":\"" : "", escapedError,
+                           error ? "\"" : "");
+    if (n <= 0 || static_cast<size_t>(n) >= sizeof(buf)) {
+        return;
+    }
+    stream->publish("ota", buf);
+    lastSendMs = now;
+    lastPct = pct;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+class EventStream;
+
+// Device-side OTA progress, sent as "ota" events on /api/events (SSE stays open in
+// maintenance mode, unlike the WebSocket). Updates are throttled: one every
+// kReportIntervalMs or every kReportStepPct of the upload, whichever comes first,
+// and never closer together than kMinGapMs. Runs on the AsyncTCP task with the upload.
+class OtaProgress {
+public:
+    static constexpr uint32_t kReportIntervalMs = 1000;
+    static constexpr uint8_t kReportStepPct = 5;
+    static constexpr uint32_t kMinGapMs = 100;
+
+    // target: "firmware" / "filesystem". total: expected upload bytes (0 = unknown).
+    void start(EventStream* stream, const char* target, size_t total);
+    // received: upload bytes so far (compressed, if gzip); written: bytes in flash
+    void update(size_t received, size_t written);
+    // Final event; not throttled. Only the first call after start() is sent.
+    void finish(bool ok, size_t written, const char* error);
+
+private:
+    void send(const char* phase, const char* error);
+
+    EventStream* stream = nullptr;
+    bool active = false;
+    const char* target = "";
+    size_t total = 0;
+    size_t received = 0;
+    size_t written = 0;
+    uint32_t startMs = 0;
+    uint32_t lastSendMs = 0;
+    uint8_t lastPct = 0;
+};
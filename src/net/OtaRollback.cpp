@@ -0,0 +1,130 @@
+#include "OtaRollback.h"
+
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <esp_timer.h>
+
+#include "../util/BootTimeline.h"
+#include "../util/Log.h"
+
+// The Arduino core calls this before setup(); returning true leaves a PENDING_VERIFY
+// image unconfirmed so the health check below decides instead.
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+namespace {
+// Separate from the "vitrine" settings namespace: bookkeeping, not user settings
+constexpr const char* kNamespace = "ota";
+constexpr const char* kKeyPending = "pend";
+constexpr const char* kKeyRollbacks = "rbCnt";
+} // namespace
+
+OtaRollback& OtaRollback::getInstance() {
+    static OtaRollback instance;
+    return instance;
+}
+
+void OtaRollback::begin() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (running) {
+        strncpy(runningLabel, running->label, sizeof(runningLabel) - 1);
+    }
+
+    esp_ota_img_states_t state = ESP_OTA_IMG_UNDEFINED;
+    const bool isPending = running && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+                           state == ESP_OTA_IMG_PENDING_VERIFY;
+
+    Preferences prefs;
+    if (prefs.begin(kNamespace, false)) {
+        rollbackCount = prefs.getUInt(kKeyRollbacks, 0);
+        const bool wasPending = prefs.getBool(kKeyPending, false);
+        if (wasPending && !isPending) {
+            // Last boot was an unverified image and we're not it any more: the bootloader rolled back
+            rollbackCount++;
+            prefs.putUInt(kKeyRollbacks, rollbackCount);
+            const esp_partition_t* invalid = esp_ota_get_last_invalid_partition();
+            LOGE("ota", "Rolled back from %s to %s (rollbacks: %u)", invalid ? invalid->label : "?", runningLabel,
+                 static_cast<unsigned>(rollbackCount));
+        }
+        if (wasPending != isPending) {
+            prefs.putBool(kKeyPending, isPending);
+        }
+        prefs.end();
+    }
+
+    if (!isPending) {
+        LOGI("ota", "Running %s (image state %d)", runningLabel, static_cast<int>(state));
+        return;
+    }
+
+    pending = true;
+    LOGW("ota", "Running %s pending verification (%u s deadline)", runningLabel,
+         static_cast<unsigned>(kHealthTimeoutMs / 1000));
+
+    // esp_timer runs on its own task, so this still fires if setup()/loop() hangs
+    esp_timer_create_args_t args = {};
+    args.callback = &OtaRollback::onDeadline;
+    args.arg = this;
+    args.name = "otaVerify";
+    esp_timer_handle_t timer = nullptr;
+    if (esp_timer_create(&args, &timer) == ESP_OK && esp_timer_start_once(timer, kHealthTimeoutMs * 1000ULL) == ESP_OK) {
+        deadlineTimer = timer;
+    } else {
+        LOGE("ota", "Could not arm the verify deadline");
+    }
+}
+
+void OtaRollback::pass(Check check) {
+    passed.fetch_or(check);
+}
+
+void OtaRollback::tick() {
+    if (!pending.load()) {
+        return;
+    }
+    passed.fetch_or(CheckLoop);
+    if (passed.load() != kAllChecks) {
+        return;
+    }
+
+    if (deadlineTimer) {
+        esp_timer_stop(static_cast<esp_timer_handle_t>(deadlineTimer));
+        esp_timer_delete(static_cast<esp_timer_handle_t>(deadlineTimer));
+        deadlineTimer = nullptr;
+    }
+
+    const esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+    pending = false;
+    if (err != ESP_OK) {
+        LOGE("ota", "Marking %s valid failed (%d)", runningLabel, static_cast<int>(err));
+        return;
+    }
+
+    Preferences prefs;
+    if (prefs.begin(kNamespace, false)) {
+        prefs.putBool(kKeyPending, false);
+        prefs.end();
+    }
+
+    bootToValidMs = millis();
+    LOGI("ota", "Health check passed: %s marked valid after %u ms", runningLabel,
+         static_cast<unsigned>(bootToValidMs));
+    BootTimeline::milestone("firmware marked valid");
+}
+
+void OtaRollback::onDeadline(void* arg) {
+    auto* self = static_cast<OtaRollback*>(arg);
+    if (!self->pending.load()) {
+        return;
+    }
+    const uint8_t missing = kAllChecks & ~self->passed.load();
+    LOGE("ota", "Health check timed out (missing:%s%s%s); rolling back",
+         (missing & CheckLoop) ? " loop" : "", (missing & CheckLeds) ? " leds" : "",
+         (missing & CheckHttp) ? " http" : "");
+    Log::flush();
+    // Counted on the next boot (the pending marker is still set)
+    const esp_err_t err = esp_ota_mark_app_invalid_rollback_and_reboot();
+    // Only returns if there is no valid image to fall back to
+    LOGE("ota", "Rollback not possible (%d); keeping %s", static_cast<int>(err), self->runningLabel);
+}
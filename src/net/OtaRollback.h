@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Post-OTA health check with automatic rollback.
+// A freshly flashed image boots in PENDING_VERIFY (the Arduino core skips its own immediate
+// verify because verifyRollbackLater() returns true). It is marked valid only once every
+// health check has passed; if that doesn't happen within kHealthTimeoutMs, or the device
+// resets before it does, the bootloader falls back to the previous ota_0/ota_1 image.
+// Rollbacks are counted in NVS (detected on the next boot).
+class OtaRollback {
+public:
+    enum Check : uint8_t {
+        CheckLoop = 1 << 0,   // loop() reached
+        CheckLeds = 1 << 1,   // LED strip initialized
+        CheckHttp = 1 << 2,   // HTTP server listening
+    };
+    static constexpr uint8_t kAllChecks = CheckLoop | CheckLeds | CheckHttp;
+    static constexpr uint32_t kHealthTimeoutMs = 90 * 1000;
+
+    static OtaRollback& getInstance();
+
+    // Early in setup(): reads the image state, counts a previous rollback, arms the deadline
+    void begin();
+    // Any task
+    void pass(Check check);
+    // Call from loop(): marks the image valid once all checks passed
+    void tick();
+
+    bool isPendingVerify() const { return pending.load(); }
+    const char* getRunningPartition() const { return runningLabel; }
+    uint32_t getRollbackCount() const { return rollbackCount; }
+    // ms since reset at which the image was marked valid (0 if it was not pending this boot)
+    uint32_t getBootToValidMs() const { return bootToValidMs; }
+
+private:
+    OtaRollback() = default;
+    OtaRollback(const OtaRollback&) = delete;
+    OtaRollback& operator=(const OtaRollback&) = delete;
+
+    static void onDeadline(void* arg);
+
+    std::atomic<bool> pending{false};
+    std::atomic<uint8_t> passed{0};
+    void* deadlineTimer = nullptr;  // esp_timer_handle_t
+    char runningLabel[17] = {0};
+    uint32_t rollbackCount = 0;
+    uint32_t bootToValidMs = 0;
+};
@@ -0,0 +1,52 @@
+#include "OtaStage.h"
+
+#include <esp_ota_ops.h>
+
+#include "../util/Log.h"
+
+bool OtaStage::fail(const char* message) {
+    error = message;
+    LOGE("ota", "Staging: %s", message);
+    return false;
+}
+
+bool OtaStage::begin() {
+    size = 0;
+    erased = 0;
+    error = "";
+    partition = esp_ota_get_next_update_partition(nullptr);
+    if (!partition) {
+        return fail("No inactive app slot to stage the image");
+    }
+    LOGI("ota", "Staging upload in %s (%u bytes)", partition->label, static_cast<unsigned>(partition->size));
+    return true;
+}
+
+bool OtaStage::write(const uint8_t* data, size_t len) {
+    if (!partition) {
+        return fail("Staging not started");
+    }
+    if (len > partition->size - size) {
+        return fail("Image too large to stage (upload it gzip-compressed)");
+    }
+    while (erased < size + len) {
+        const size_t left = partition->size - erased;
+        const size_t step = left < kEraseStep ? left : kEraseStep;
+        if (esp_partition_erase_range(partition, erased, step) != ESP_OK) {
+            return fail("Staging erase failed");
+        }
+        erased += step;
+    }
+    if (esp_partition_write(partition, size, data, len) != ESP_OK) {
+        return fail("Staging write failed");
+    }
+    size += len;
+    return true;
+}
+
+bool OtaStage::read(size_t offset, uint8_t* out, size_t len) const {
+    if (!partition || offset > size || len > size - offset) {
+        return false;
+    }
+    return esp_partition_read(partition, offset, out, len) == ESP_OK;
+}
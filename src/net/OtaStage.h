@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// Holds an upload in the inactive app slot (the next OTA partition) until it has been verified.
+// A filesystem image has no A/B slot of its own: it is staged here, its digest and signature
+// are checked, and only then is it copied over the spiffs partition.
+// - Staging replaces the previous firmware kept for rollback; refuse while the running image
+//   is still pending verification (see OtaRollback).
+// - The slot is 3.2 MB: full LittleFS images only fit gzip-compressed.
+// - Erased ahead of the writes in kEraseStep blocks; nothing here allocates.
+class OtaStage {
+public:
+    static constexpr size_t kEraseStep = 64 * 1024;
+
+    bool begin();
+    bool write(const uint8_t* data, size_t len);
+    bool read(size_t offset, uint8_t* out, size_t len) const;
+
+    size_t getSize() const { return size; }
+    size_t getCapacity() const { return partition ? partition->size : 0; }
+    const char* getError() const { return error; }
+
+private:
+    bool fail(const char* message);
+
+    const esp_partition_t* partition = nullptr;
+    size_t size = 0;
+    size_t erased = 0;
+    const char* error = "";
+};
@@ -0,0 +1,246 @@
+#include "OtaWriter.h"
+
+#include <Update.h>
+#include <mbedtls/pk.h>
+
+#include "../util/Log.h"
+
+#if __has_include("ota_signing_key.h")
+#include "ota_signing_key.h"
+#define HAS_OTA_SIGNING_KEY 1
+#else
+#define HAS_OTA_SIGNING_KEY 0
+#endif
+
+namespace {
+int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Returns the decoded length, or 0 on malformed input / overflow
+size_t decodeHex(const char* hex, uint8_t* out, size_t outSize) {
+    const size_t len = strlen(hex);
+    if (len == 0 || (len % 2) != 0 || len / 2 > outSize) {
+        return 0;
+    }
+    for (size_t i = 0; i < len / 2; i++) {
+        const int hi = hexNibble(hex[2 * i]);
+        const int lo = hexNibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return 0;
+        }
+        out[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return len / 2;
+}
+
+void encodeHex(const uint8_t* data, size_t len, char* out) {
+    static const char kHex[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = kHex[data[i] >> 4];
+        out[2 * i + 1] = kHex[data[i] & 0x0F];
+    }
+    out[2 * len] = '\0';
+}
+} // namespace
+
+OtaWriter::OtaWriter() {
+    mbedtls_sha256_init(&sha);
+}
+
+OtaWriter::~OtaWriter() {
+    if (active) {
+        abort();
+    }
+    mbedtls_sha256_free(&sha);
+}
+
+bool OtaWriter::isSignatureRequired() {
+    return HAS_OTA_SIGNING_KEY != 0;
+}
+
+void OtaWriter::fail(const char* message) {
+    strncpy(error, (message && message[0]) ? message : "unknown", sizeof(error) - 1);
+    error[sizeof(error) - 1] = '\0';
+    LOGE("ota", "%s", error);
+}
+
+bool OtaWriter::begin(int commandIn, size_t imageSize, const char* expectedSha256Hex, const char* signatureHex) {
+    command = commandIn;
+    expectedSize = imageSize;
+    written = 0;
+    error[0] = '\0';
+    digestHex[0] = '\0';
+    digestVerified = false;
+    signatureVerified = false;
+
+    hasExpectedDigest = false;
+    if (expectedSha256Hex && expectedSha256Hex[0]) {
+        if (decodeHex(expectedSha256Hex, expectedDigest, sizeof(expectedDigest)) != sizeof(expectedDigest)) {
+            fail("Malformed sha256 (expected 64 hex chars)");
+            return false;
+        }
+        hasExpectedDigest = true;
+    }
+
+    signatureLen = 0;
+    if (signatureHex && signatureHex[0]) {
+        signatureLen = decodeHex(signatureHex, signature, sizeof(signature));
+        if (signatureLen == 0) {
+            fail("Malformed signature (expected DER as hex)");
+            return false;
+        }
+    }
+    if (isSignatureRequired() && signatureLen == 0) {
+        fail("Signed image required");
+        return false;
+    }
+
+    if (command != kVerifyOnly && !Update.begin(imageSize ? imageSize : UPDATE_SIZE_UNKNOWN, command)) {
+        fail(Update.errorString());
+        return false;
+    }
+
+    mbedtls_sha256_starts(&sha, 0);
+    startMs = millis();
+    endMs = 0;
+    active = true;
+    return true;
+}
+
+bool OtaWriter::write(const uint8_t* data, size_t len) {
+    if (!active) {
+        // Keep the first failure (begin/abort) if there was one
+        if (!error[0]) {
+            fail("Update was not started");
+        }
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+
+    // Hash the exact bytes handed to flash, while they are still in cache
+    mbedtls_sha256_update(&sha, data, len);
+
+    const size_t writtenNow = (command == kVerifyOnly) ? len : Update.write(const_cast<uint8_t*>(data), len);
+    if (writtenNow != len) {
+        fail(Update.errorString());
+        abort();
+        return false;
+    }
+    written += writtenNow;
+    return true;
+}
+
+bool OtaWriter::verifySignature(const uint8_t digest[32]) {
+#if HAS_OTA_SIGNING_KEY
+    mbedtls_pk_context pk;
+    mbedtls_pk_init(&pk);
+
+    const auto* key = reinterpret_cast<const unsigned char*>(OTA_SIGNING_PUBKEY_PEM);
+    int rc = mbedtls_pk_parse_public_key(&pk, key, strlen(OTA_SIGNING_PUBKEY_PEM) + 1);
+    if (rc == 0) {
+        rc = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, 32, signature, signatureLen);
+    }
+    mbedtls_pk_free(&pk);
+
+    if (rc != 0) {
+        LOGE("ota", "Signature check failed (-0x%04x)", static_cast<unsigned>(-rc));
+        return false;
+    }
+    return true;
+#else
+    (void)digest;
+    // No key compiled in: a provided signature cannot be checked
+    LOGW("ota", "Signature provided but no OTA signing key is configured; ignoring");
+    return false;
+#endif
+}
+
+bool OtaWriter::end() {
+    if (!active) {
+        if (!error[0]) {
+            fail("Update was not started");
+        }
+        return false;
+    }
+    endMs = millis();
+
+    if (expectedSize && written != expectedSize) {
+        fail("Image size mismatch");
+        abort();
+        return false;
+    }
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    encodeHex(digest, sizeof(digest), digestHex);
+
+    if (hasExpectedDigest) {
+        if (memcmp(digest, expectedDigest, sizeof(digest)) != 0) {
+            fail("SHA-256 mismatch");
+            abort();
+            return false;
+        }
+        digestVerified = true;
+    }
+
+    if (signatureLen > 0) {
+        signatureVerified = verifySignature(digest);
+        if (!signatureVerified && isSignatureRequired()) {
+            fail("Invalid image signature");
+            abort();
+            return false;
+        }
+    }
+
+    if (command == kVerifyOnly) {
+        active = false;
+        LOGI("ota", "Image verified: %u bytes, sha256=%s", static_cast<unsigned>(written), digestHex);
+        return true;
+    }
+
+    if (!Update.end(true)) {
+        fail(Update.errorString());
+        abort();
+        return false;
+    }
+
+    active = false;
+    LOGW("ota", "Image committed: %u bytes in %lu ms (%lu KB/s), sha256=%s",
+         static_cast<unsigned>(written), (unsigned long)getElapsedMs(), (unsigned long)getKBps(), digestHex);
+    return true;
+}
+
+void OtaWriter::abort() {
+    if (!active) {
+        return;
+    }
+    active = false;
+    if (!endMs) {
+        endMs = millis();
+    }
+    if (command != kVerifyOnly) {
+        Update.abort();
+    }
+}
+
+uint32_t OtaWriter::getElapsedMs() const {
+    if (!startMs) {
+        return 0;
+    }
+    return (endMs ? endMs : millis()) - startMs;
+}
+
+uint32_t OtaWriter::getKBps() const {
+    const uint32_t ms = getElapsedMs();
+    if (ms == 0) {
+        return 0;
+    }
+    // bytes/ms == KB/s (1000 B/KB); scale to KiB
+    return static_cast<uint32_t>((static_cast<uint64_t>(written) * 1000u) / (static_cast<uint64_t>(ms) * 1024u));
+}
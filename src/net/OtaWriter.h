@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mbedtls/sha256.h>
+
+// Streams an OTA image into Update while hashing it (single pass, no extra buffering).
+// - SHA-256 runs on the same chunks handed to Update.write() (mbedtls uses the SHA peripheral).
+// - Optional expected digest (hex) and detached signature over that digest are checked
+//   before Update.end(true) commits the image; a mismatch aborts the update.
+// - Signatures are required when include/ota_signing_key.h provides a public key.
+// - kVerifyOnly hashes and checks without writing anything: used to verify a staged
+//   filesystem image before the spiffs partition is touched (see OtaStage).
+class OtaWriter {
+public:
+    static constexpr int kVerifyOnly = -1;
+
+    OtaWriter();
+    ~OtaWriter();
+
+    // command: U_FLASH, U_SPIFFS or kVerifyOnly. imageSize 0 = unknown (bounded by the partition); otherwise
+    // end() rejects an image of any other length. expectedSha256Hex / signatureHex may be null or empty.
+    bool begin(int command, size_t imageSize, const char* expectedSha256Hex, const char* signatureHex);
+    bool write(const uint8_t* data, size_t len);
+    // Verifies size/digest/signature, then commits (unless kVerifyOnly). Returns false (and aborts) on any failure.
+    bool end();
+    void abort();
+
+    bool isActive() const { return active; }
+    const char* getError() const { return error; }
+    size_t getWritten() const { return written; }
+    uint32_t getElapsedMs() const;
+    uint32_t getKBps() const;
+
+    // Valid after end(): hex digest of everything written, and what was checked
+    const char* getDigestHex() const { return digestHex; }
+    bool isDigestVerified() const { return digestVerified; }
+    bool isSignatureVerified() const { return signatureVerified; }
+
+    static bool isSignatureRequired();
+
+private:
+    void fail(const char* message);
+    bool verifySignature(const uint8_t digest[32]);
+
+    mbedtls_sha256_context sha;
+    bool active = false;
+    int command = 0;
+    size_t expectedSize = 0;
+    size_t written = 0;
+    uint32_t startMs = 0;
+    uint32_t endMs = 0;
+
+    bool hasExpectedDigest = false;
+    uint8_t expectedDigest[32] = {0};
+
+    // DER-encoded signature (ECDSA P-256 is ~72 bytes; room for RSA-2048)
+    uint8_t signature[256] = {0};
+    size_t signatureLen = 0;
+
+    char digestHex[65] = {0};
+    bool digestVerified = false;
+    bool signatureVerified = false;
+    char error[64] = {0};
+};
@@ -1,15 +1,182 @@
 #include "WebServer.h"
 #include "../util/Log.h"
+#include "../util/PersistentLog.h"
+#include "../util/Metrics.h"
+#include "../util/LoopProfiler.h"
+#include "../util/Trace.h"
+#include "../util/HeapMonitor.h"
+#include "../util/AllocTracker.h"
+#include "BodyAssembler.h"
+#include "FsListStream.h"
+#include "JsonPool.h"
 #include "MaintenanceMode.h"
+#include "OtaRollback.h"
 #include "version.h"
 #include <ArduinoJson.h>
+#include <algorithm>
+#include <memory>
 #include <WiFi.h>
 #include "hardware/ModeManager.h"
+#include "WifiManager.h"
+#include "MqttManager.h"
+
+namespace {
+// Sampled when /api/metrics is scraped
+MetricGauge s_uptime("vitrine_uptime_seconds", "Seconds since boot");
+MetricGauge s_rssi("vitrine_wifi_rssi_dbm", "Smoothed station RSSI (0 when not connected)");
+
+// Serialize straight into the response buffer (no intermediate heap String)
+void sendJson(AsyncWebServerRequest* request, const JsonDocument& doc, int code = 200) {
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(code);
+    serializeJson(doc, *response);
+    request->send(response);
+}
 
-WebServer::WebServer() : server(80), fsMounted(false), modeManager(nullptr) {}
+// Upper bound for POST /api/settings bodies (all fields + SSIDs/passwords fit easily)
+constexpr size_t kMaxSettingsBodyBytes = 2048;
+
+// Pre-sized buffer for the rare multi-chunk settings body (one request at a time).
+// Not stored in request->_tempObject: the library free()s that on disconnect.
+// Assembler calls go through mux; only the owner reads the completed body (after Complete).
+struct SettingsBodyBuffer {
+    using Body = BodyAssembler<AsyncWebServerRequest, kMaxSettingsBodyBytes>;
+    static constexpr uint32_t kStaleMs = 5000;
+
+    Body body;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    bool acquire(AsyncWebServerRequest* request) {
+        AsyncWebServerRequest* displaced = nullptr;
+        portENTER_CRITICAL(&mux);
+        const bool ok = body.acquire(request, millis(), kStaleMs, displaced);
+        portEXIT_CRITICAL(&mux);
+        if (displaced) {
+            // Reclaimed from a request that never finished its body. It is still connected
+            // (a disconnect releases the buffer), so answer it; its remaining chunks are ignored.
+            displaced->send(408, "application/json", "{\"error\":\"body_timeout\"}");
+        }
+        if (ok) {
+            request->onDisconnect([this, request]() { release(request); });
+        }
+        return ok;
+    }
 
-void WebServer::begin(ModeManager* modeManagerIn) {
+    bool ownedBy(AsyncWebServerRequest* request) {
+        portENTER_CRITICAL(&mux);
+        const bool owned = body.ownedBy(request);
+        portEXIT_CRITICAL(&mux);
+        return owned;
+    }
+
+    Body::Append append(AsyncWebServerRequest* request, const uint8_t* data, size_t len, size_t index, size_t total) {
+        portENTER_CRITICAL(&mux);
+        const Body::Append result = body.append(request, data, len, index, total);
+        portEXIT_CRITICAL(&mux);
+        return result;
+    }
+
+    void release(AsyncWebServerRequest* request) {
+        portENTER_CRITICAL(&mux);
+        body.release(request);
+        portEXIT_CRITICAL(&mux);
+    }
+};
+SettingsBodyBuffer s_settingsBody;
+} // namespace
+
+// Chrome Trace Event JSON for a stopped capture: metadata first, then one event per piece
+struct WebServer::TraceStream {
+    enum class Step : uint8_t { Header, Tasks, Events, Done };
+    Step step = Step::Header;
+    size_t index = 0;
+    uint32_t baseUs = 0;
+
+    char pending[160];
+    size_t pendingLen = 0;
+    size_t pendingPos = 0;
+
+    bool next() {
+        pendingLen = 0;
+        pendingPos = 0;
+
+        switch (step) {
+            case Step::Header: {
+                Trace::Event first;
+                if (Trace::getEvent(0, first)) {
+                    baseUs = first.tsUs;
+                }
+                pendingLen = snprintf(pending, sizeof(pending),
+                                      "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":%lu},"
+                                      "\"traceEvents\":[{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,"
+                                      "\"args\":{\"name\":\"vitrine\"}}",
+                                      (unsigned long)Trace::getOverwritten());
+                step = Step::Tasks;
+                return true;
+            }
+            case Step::Tasks:
+                if (index < Trace::taskCount()) {
+                    // Task names come from FreeRTOS; none of ours need escaping
+                    pendingLen = snprintf(pending, sizeof(pending),
+                                          ",{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+                                          "\"args\":{\"name\":\"%s\"}}",
+                                          static_cast<unsigned>(index), Trace::taskName(index));
+                    index++;
+                    return true;
+                }
+                index = 0;
+                step = Step::Events;
+                // fall through
+            case Step::Events: {
+                Trace::Event e;
+                if (Trace::getEvent(index, e)) {
+                    index++;
+                    size_t n = snprintf(pending, sizeof(pending),
+                                        ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,\"tid\":%u,"
+                                        "\"args\":{\"core\":%u",
+                                        e.name, static_cast<char>(e.phase), (unsigned long)(e.tsUs - baseUs),
+                                        static_cast<unsigned>(e.task), static_cast<unsigned>(e.core));
+                    if (e.arg != 0 && n < sizeof(pending)) {
+                        n += snprintf(pending + n, sizeof(pending) - n, ",\"arg\":%ld", (long)e.arg);
+                    }
+                    if (n < sizeof(pending)) {
+                        n += snprintf(pending + n, sizeof(pending) - n, "}%s}",
+                                      e.phase == Trace::Phase::Instant ? ",\"s\":\"t\"" : "");
+                    }
+                    pendingLen = std::min(n, sizeof(pending) - 1);
+                    return true;
+                }
+                step = Step::Done;
+                pendingLen = snprintf(pending, sizeof(pending), "]}");
+                return true;
+            }
+            case Step::Done:
+                break;
+        }
+        return false;
+    }
+
+    size_t fill(uint8_t* buffer, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (pendingPos >= pendingLen && !next()) {
+                break;
+            }
+            const size_t n = std::min(maxLen - written, pendingLen - pendingPos);
+            memcpy(buffer + written, pending + pendingPos, n);
+            pendingPos += n;
+            written += n;
+        }
+        return written;
+    }
+};
+
+WebServer::WebServer() : server(80), fsMounted(false), modeManager(nullptr), wifiManager(nullptr), mqttManager(nullptr) {}
+
+void WebServer::begin(ModeManager* modeManagerIn, WifiManager* wifiManagerIn, MqttManager* mqttManagerIn) {
     modeManager = modeManagerIn;
+    wifiManager = wifiManagerIn;
+    mqttManager = mqttManagerIn;
 
     // Mount LittleFS
     fsMounted = LittleFS.begin(true);
@@ -17,16 +184,47 @@ void WebServer::begin(ModeManager* modeManagerIn) {
         LOGE("fs", "LittleFS mount failed");
     } else {
         LOGI("fs", "LittleFS mounted");
+        hotCache.load(LittleFS);
+        PersistentLog::attach(LittleFS);
     }
     
     // Initialize WebSocket server
     wsServer.begin(&server);
+
+    // SSE telemetry (/api/events)
+    if (modeManager) {
+        eventStream.setMaxRateHz(modeManager->getEventsMaxRateHz());
+    }
+    eventStream.begin(&server);
     
     setupRoutes();
     server.begin();
     LOGI("http", "HTTP server started on port 80");
 }
 
+void WebServer::unmountFs(void* ctx) {
+    auto* self = static_cast<WebServer*>(ctx);
+    self->fsMounted = false;
+    PersistentLog::detach();
+    LittleFS.end();
+    LOGW("fs", "LittleFS unmounted for filesystem update");
+}
+
+bool WebServer::remountFs(void* ctx) {
+    auto* self = static_cast<WebServer*>(ctx);
+    // No format-on-fail: a broken image stays broken rather than silently becoming empty
+    self->fsMounted = LittleFS.begin(false);
+    if (!self->fsMounted) {
+        // Keep the old hot copies so /update can still be served for a retry
+        LOGE("fs", "LittleFS remount failed");
+        return false;
+    }
+    LOGI("fs", "LittleFS remounted");
+    self->hotCache.load(LittleFS);
+    PersistentLog::attach(LittleFS);
+    return true;
+}
+
 void WebServer::setupRoutes() {
     // API endpoints
     server.on("/api/info", HTTP_GET, [this](AsyncWebServerRequest *request) {
@@ -38,6 +236,76 @@ void WebServer::setupRoutes() {
         handleApiFs(request);
     });
 
+    // Prometheus text format
+    server.on("/api/metrics", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleApiMetrics(request);
+    });
+
+    // Loop stage profiler: GET stats; POST ?enabled=0|1&slowMs=N&reset=1
+    server.on("/api/profile", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleApiProfile(request);
+    });
+
+    server.on("/api/profile", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        if (request->hasParam("enabled")) {
+            LoopProfiler::setEnabled(request->getParam("enabled")->value().toInt() != 0);
+        }
+        if (request->hasParam("slowMs")) {
+            const long slowMs = request->getParam("slowMs")->value().toInt();
+            if (slowMs > 0) {
+                LoopProfiler::setSlowFrameUs(static_cast<uint32_t>(slowMs) * 1000);
+            }
+        }
+        if (request->hasParam("reset")) {
+            LoopProfiler::requestReset();
+        }
+        handleApiProfile(request);
+    });
+
+    // Heap telemetry: GET snapshot/history/allocation sites; POST ?reset=1 zeroes the site counters
+    server.on("/api/heap", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleApiHeap(request);
+    });
+
+    server.on("/api/heap", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        if (request->hasParam("reset")) {
+            AllocTracker::resetCounts();
+        }
+        handleApiHeap(request);
+    });
+
+    // Event trace: POST ?enabled=1 clears and starts a capture, ?enabled=0 stops it;
+    // GET stops the capture and downloads it as Chrome Trace JSON
+    server.on("/api/trace", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleApiTrace(request);
+    });
+
+    server.on("/api/trace", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!request->hasParam("enabled")) {
+            request->send(400, "application/json", "{\"error\":\"Missing enabled\"}");
+            return;
+        }
+        if (request->getParam("enabled")->value().toInt() == 0) {
+            Trace::stop();
+        } else if (!Trace::start()) {
+            request->send(503, "application/json", "{\"error\":\"No memory for the trace buffer\"}");
+            return;
+        }
+        AsyncResponseStream* response = request->beginResponseStream("application/json");
+        response->printf("{\"running\":%s,\"events\":%u}", Trace::isRunning() ? "true" : "false",
+                         static_cast<unsigned>(Trace::count()));
+        request->send(response);
+    });
+
+    server.on("/api/logs", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        handleApiLogs(request);
+    });
+
+    server.on("/api/logs", HTTP_DELETE, [](AsyncWebServerRequest *request) {
+        PersistentLog::clear();
+        request->send(200, "application/json", "{\"ok\":true}");
+    });
+
     server.on("/api/settings", HTTP_GET, [this](AsyncWebServerRequest* request) {
         handleApiSettingsGet(request);
     });
@@ -47,7 +315,10 @@ void WebServer::setupRoutes() {
         "/api/settings",
         HTTP_POST,
         [](AsyncWebServerRequest* request) {
-            (void)request;
+            // The body handler answers; without a body it is never called
+            if (request->contentLength() == 0) {
+                request->send(400, "application/json", "{\"error\":\"empty_body\"}");
+            }
         },
         nullptr,
         [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
@@ -55,23 +326,23 @@ void WebServer::setupRoutes() {
         }
     );
 
-    // Step 8: OTA firmware update
+    // Step 8: OTA firmware + filesystem update
+    otaFirmware.setFilesystemHooks(this, &WebServer::unmountFs, &WebServer::remountFs);
+    otaFirmware.setProgressStream(&eventStream);
     otaFirmware.attach(server, wsServer);
 
-    // Step 8: OTA upload page (served from LittleFS)
+    // Step 8: OTA upload page (served from LittleFS; the hot cache copy keeps it
+    // reachable while a failed filesystem update leaves LittleFS unmounted)
     server.on("/update", HTTP_GET, [this](AsyncWebServerRequest *request) {
-    if (fsMounted && LittleFS.exists("/update/index.html")) {
-        request->send(LittleFS, "/update/index.html", "text/html");
+    if (serveStaticFile(request, "/update/index.html")) {
         return;
     }
     request->send(404, "text/plain", "Update page missing in LittleFS (/update/index.html)");
     });
     server.serveStatic("/update/", LittleFS, "/update/").setDefaultFile("index.html");
 
-    // Serve the main SPA from LittleFS at the root.
-    // If the requested file doesn't exist, it'll fall through to onNotFound() for SPA fallback routing.
-    server.serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
-    
+    // The main SPA is served from LittleFS by handleNotFound() -> serveStaticFile()
+    // (pre-compressed .gz variants, ETag/304, immutable caching for hashed assets).
     // Static file handler (SPA fallback included)
     server.onNotFound([this](AsyncWebServerRequest *request) {
         handleNotFound(request);
@@ -84,9 +355,10 @@ void WebServer::handleApiSettingsGet(AsyncWebServerRequest* request) {
         return;
     }
 
-    JsonDocument doc;
+    PooledJsonDocument doc;
 
     doc["sleepTimeoutMinutes"] = modeManager->getSleepTimeoutMinutes();
+    doc["eventsMaxRateHz"] = modeManager->getEventsMaxRateHz();
     doc["backlightBrightnessPercent"] = modeManager->getBacklightBrightnessPercent();
     doc["ledBrightnessPercent"] = modeManager->getLedBrightnessPercent();
     doc["standbyBrightnessPercent"] = modeManager->getStandbyBrightnessPercent();
@@ -98,17 +370,29 @@ void WebServer::handleApiSettingsGet(AsyncWebServerRequest* request) {
     doc["ambientRandomStep"] = modeManager->getAmbientRandomStep();
 
     // WiFi (do not return passwords)
-    // NOTE: WiFi changes require reboot to take effect currently.
+    // NOTE: STA changes are applied live; AP changes still require a reboot.
     doc["wifiStaEnabled"] = modeManager->getWifiStaEnabled();
     doc["wifiStaSsid"] = modeManager->getWifiStaSsid();
     doc["wifiStaPassSet"] = modeManager->hasWifiStaPass();
+    if (wifiManager) {
+        doc["wifiStaState"] = WifiManager::getStaStateName(wifiManager->getStaState());
+    }
     doc["wifiApSsid"] = modeManager->getWifiApSsid();
     doc["wifiApPassSet"] = modeManager->hasWifiApPass();
-    doc["wifiRebootRequired"] = true;
+    doc["wifiApRebootRequired"] = true;
+
+    // MQTT / Home Assistant (applied on reboot; password is never returned)
+    doc["mqttEnabled"] = modeManager->getMqttEnabled();
+    doc["mqttHost"] = modeManager->getMqttHost();
+    doc["mqttPort"] = modeManager->getMqttPort();
+    doc["mqttUser"] = modeManager->getMqttUser();
+    doc["mqttPassSet"] = modeManager->hasMqttPass();
+    if (mqttManager) {
+        doc["mqttState"] = MqttManager::getStateName(mqttManager->getState());
+    }
+    doc["mqttRebootRequired"] = true;
 
-    String out;
-    serializeJson(doc, out);
-    request->send(200, "application/json", out);
+    sendJson(request, doc);
 }
 
 void WebServer::handleApiSettingsPost(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
@@ -117,35 +401,44 @@ void WebServer::handleApiSettingsPost(AsyncWebServerRequest* request, uint8_t* d
         return;
     }
 
-    // Collect body per-request (ESPAsyncWebServer pattern)
-    if (index == 0) {
-        if (request->_tempObject) {
-            delete static_cast<String*>(request->_tempObject);
-            request->_tempObject = nullptr;
+    // Reject oversized bodies up front (answer once, ignore the remaining chunks)
+    if (total > kMaxSettingsBodyBytes) {
+        if (index == 0) {
+            request->send(413, "application/json", "{\"error\":\"body_too_large\"}");
         }
-        String* body = new String();
-        body->reserve(total);
-        request->_tempObject = body;
-    }
-
-    String* body = static_cast<String*>(request->_tempObject);
-    if (!body) {
-        request->send(500, "application/json", "{\"error\":\"no_body_buffer\"}");
         return;
     }
 
-    for (size_t i = 0; i < len; i++) {
-        *body += static_cast<char>(data[i]);
-    }
+    PooledJsonDocument doc;
+    DeserializationError err;
 
-    if ((index + len) < total) {
-        return;
+    if (index == 0 && len == total) {
+        // Common case: the whole body arrived in one chunk, parse it in place
+        err = deserializeJson(doc, reinterpret_cast<const char*>(data), len);
+    } else {
+        // Multi-chunk body: assemble into the shared pre-sized buffer
+        if (index == 0 && !s_settingsBody.acquire(request)) {
+            request->send(503, "application/json", "{\"error\":\"busy\"}");
+            return;
+        }
+        if (!s_settingsBody.ownedBy(request)) {
+            return;  // displaced as stale (already answered) or refused at index 0
+        }
+
+        const SettingsBodyBuffer::Body::Append result = s_settingsBody.append(request, data, len, index, total);
+        if (result == SettingsBodyBuffer::Body::Append::Rejected) {
+            s_settingsBody.release(request);
+            request->send(400, "application/json", "{\"error\":\"bad_body\"}");
+            return;
+        }
+        if (result == SettingsBodyBuffer::Body::Append::Partial) {
+            return;
+        }
+
+        err = deserializeJson(doc, s_settingsBody.body.data(), s_settingsBody.body.size());
+        s_settingsBody.release(request);
     }
 
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, *body);
-    delete body;
-    request->_tempObject = nullptr;
     if (err) {
         request->send(400, "application/json", "{\"error\":\"bad_json\"}");
         return;
@@ -155,6 +448,10 @@ void WebServer::handleApiSettingsPost(AsyncWebServerRequest* request, uint8_t* d
     if (doc["sleepTimeoutMinutes"].is<uint16_t>() || doc["sleepTimeoutMinutes"].is<int>()) {
         modeManager->setSleepTimeoutMinutes(doc["sleepTimeoutMinutes"].as<uint16_t>());
     }
+    if (doc["eventsMaxRateHz"].is<uint8_t>() || doc["eventsMaxRateHz"].is<int>()) {
+        modeManager->setEventsMaxRateHz(doc["eventsMaxRateHz"].as<uint8_t>());
+        eventStream.setMaxRateHz(modeManager->getEventsMaxRateHz());
+    }
     if (doc["backlightBrightnessPercent"].is<uint8_t>() || doc["backlightBrightnessPercent"].is<int>()) {
         modeManager->setBacklightBrightnessPercent(doc["backlightBrightnessPercent"].as<uint8_t>());
     }
@@ -183,9 +480,9 @@ void WebServer::handleApiSettingsPost(AsyncWebServerRequest* request, uint8_t* d
         modeManager->setAmbientRandomSpeed(frameMs, step);
     }
 
-    bool wifiChanged = false;
+    bool apChanged = false;
 
-    // WiFi STA
+    // WiFi STA (applied live by WifiManager)
     const bool hasStaEnabled = doc["wifiStaEnabled"].is<bool>();
     const bool hasStaSsid = doc["wifiStaSsid"].is<const char*>();
     const bool hasStaPass = doc["wifiStaPass"].is<const char*>();
@@ -193,7 +490,10 @@ void WebServer::handleApiSettingsPost(AsyncWebServerRequest* request, uint8_t* d
         const bool enabled = hasStaEnabled ? doc["wifiStaEnabled"].as<bool>() : modeManager->getWifiStaEnabled();
         const char* ssid = hasStaSsid ? doc["wifiStaSsid"].as<const char*>() : modeManager->getWifiStaSsid();
         const char* pass = hasStaPass ? doc["wifiStaPass"].as<const char*>() : nullptr;
-        wifiChanged |= modeManager->setWifiStaConfig(enabled, ssid, pass, hasStaPass);
+        const bool staChanged = modeManager->setWifiStaConfig(enabled, ssid, pass, hasStaPass);
+        if (staChanged && wifiManager) {
+            wifiManager->setStationConfig(enabled, modeManager->getWifiStaSsid(), hasStaPass ? (pass ? pass : "") : nullptr);
+        }
     }
 
     // WiFi AP
@@ -202,19 +502,36 @@ void WebServer::handleApiSettingsPost(AsyncWebServerRequest* request, uint8_t* d
     if (hasApSsid || hasApPass) {
         const char* ssid = hasApSsid ? doc["wifiApSsid"].as<const char*>() : modeManager->getWifiApSsid();
         const char* pass = hasApPass ? doc["wifiApPass"].as<const char*>() : nullptr;
-        wifiChanged |= modeManager->setWifiApConfig(ssid, pass, hasApPass);
+        apChanged |= modeManager->setWifiApConfig(ssid, pass, hasApPass);
+    }
+
+    // MQTT
+    bool mqttChanged = false;
+    const bool hasMqttEnabled = doc["mqttEnabled"].is<bool>();
+    const bool hasMqttHost = doc["mqttHost"].is<const char*>();
+    const bool hasMqttPort = doc["mqttPort"].is<int>();
+    const bool hasMqttUser = doc["mqttUser"].is<const char*>();
+    const bool hasMqttPass = doc["mqttPass"].is<const char*>();
+    if (hasMqttEnabled || hasMqttHost || hasMqttPort || hasMqttUser || hasMqttPass) {
+        const bool enabled = hasMqttEnabled ? doc["mqttEnabled"].as<bool>() : modeManager->getMqttEnabled();
+        const int port = hasMqttPort ? doc["mqttPort"].as<int>() : 0;
+        mqttChanged = modeManager->setMqttConfig(
+            enabled,
+            hasMqttHost ? doc["mqttHost"].as<const char*>() : nullptr,
+            (port > 0 && port <= 65535) ? static_cast<uint16_t>(port) : 0,
+            hasMqttUser ? doc["mqttUser"].as<const char*>() : nullptr,
+            hasMqttPass ? doc["mqttPass"].as<const char*>() : nullptr,
+            hasMqttPass);
     }
 
-    JsonDocument resp;
+    PooledJsonDocument resp;
     resp["ok"] = true;
-    resp["rebootRequired"] = wifiChanged;
-    String out;
-    serializeJson(resp, out);
-    request->send(200, "application/json", out);
+    resp["rebootRequired"] = apChanged || mqttChanged;
+    sendJson(request, resp);
 }
 
 void WebServer::handleApiInfo(AsyncWebServerRequest *request) {
-    JsonDocument doc;
+    PooledJsonDocument doc;
 
     doc["firmwareVersion"] = FIRMWARE_VERSION;
     doc["webVersion"] = WEB_VERSION;
@@ -225,16 +542,40 @@ void WebServer::handleApiInfo(AsyncWebServerRequest *request) {
 
     doc["uptime"] = static_cast<uint32_t>(millis() / 1000);
 
-    String ip;
-    if (WiFi.status() == WL_CONNECTED) {
-        ip = WiFi.localIP().toString();
-    } else {
-        ip = WiFi.softAPIP().toString();
-    }
+    const IPAddress addr = (WiFi.status() == WL_CONNECTED) ? WiFi.localIP() : WiFi.softAPIP();
+    char ip[16];
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
     doc["ip"] = ip;
 
+    if (wifiManager) {
+        doc["wifiStaState"] = WifiManager::getStaStateName(wifiManager->getStaState());
+        doc["rssi"] = wifiManager->getRssi();
+        doc["linkQuality"] = wifiManager->getLinkQualityPercent();
+        doc["wifiReconnects"] = wifiManager->getReconnectCount();
+    }
+
+    if (mqttManager) {
+        JsonObject mqtt = doc["mqtt"].to<JsonObject>();
+        mqtt["state"] = MqttManager::getStateName(mqttManager->getState());
+        mqtt["published"] = mqttManager->getPublishCount();
+        mqtt["droppedEvents"] = mqttManager->getDroppedEvents();
+        mqtt["connects"] = mqttManager->getReconnectCount();
+    }
+
     doc["maintenanceMode"] = MaintenanceMode::getInstance().isActive();
 
+    const OtaRollback& rollback = OtaRollback::getInstance();
+    JsonObject ota = doc["ota"].to<JsonObject>();
+    ota["partition"] = rollback.getRunningPartition();
+    ota["pendingVerify"] = rollback.isPendingVerify();
+    ota["rollbacks"] = rollback.getRollbackCount();
+    if (rollback.getBootToValidMs()) {
+        ota["bootToValidMs"] = rollback.getBootToValidMs();
+    }
+    doc["eventClients"] = eventStream.clientCount();
+    doc["logDropped"] = Log::getDropped();
+    doc["resetReason"] = PersistentLog::getResetReason();
+
     if (fsMounted) {
         const size_t total = LittleFS.totalBytes();
         const size_t used = LittleFS.usedBytes();
@@ -243,72 +584,368 @@ void WebServer::handleApiInfo(AsyncWebServerRequest *request) {
         doc["littlefsFree"] = 0;
     }
 
-    String out;
-    serializeJson(doc, out);
-    
-    AsyncWebServerResponse *response = request->beginResponse(200, "application/json", out);
+    JsonObject cache = doc["hotCache"].to<JsonObject>();
+    cache["hits"] = hotCache.getHits();
+    cache["misses"] = hotCache.getMisses();
+    cache["bytes"] = static_cast<uint32_t>(hotCache.getBytes());
+
+    sendJson(request, doc);
+}
+
+void WebServer::handleApiMetrics(AsyncWebServerRequest *request) {
+    s_uptime.set(static_cast<int32_t>(millis() / 1000));
+    HeapMonitor::sample();
+    s_rssi.set(wifiManager ? wifiManager->getRssi() : 0);
+
+    AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+    response->addHeader("Cache-Control", "no-store");
+    Metrics::writePrometheus(*response);
+    request->send(response);
+}
+
+void WebServer::handleApiProfile(AsyncWebServerRequest *request) {
+    PooledJsonDocument doc;
+    doc["compiled"] = LOOP_PROFILER != 0;
+    doc["enabled"] = LoopProfiler::isEnabled();
+    doc["slowFrameMs"] = LoopProfiler::getSlowFrameUs() / 1000;
+    doc["slowFrames"] = LoopProfiler::getSlowFrameCount();
+
+    JsonObject stages = doc["stages"].to<JsonObject>();
+    for (size_t i = 0; i <= LoopProfiler::kFrame; i++) {
+        LoopProfiler::Stats stats;
+        if (!LoopProfiler::getStats(i, stats)) {
+            continue;
+        }
+        JsonObject s = stages[LoopProfiler::stageName(i)].to<JsonObject>();
+        s["count"] = stats.count;
+        s["p50Us"] = stats.p50Us;
+        s["p99Us"] = stats.p99Us;
+        s["maxUs"] = stats.maxUs;
+    }
+
+    LoopProfiler::SlowFrame frames[LoopProfiler::kSlowFrames];
+    const size_t n = LoopProfiler::getSlowFrames(frames, LoopProfiler::kSlowFrames);
+    JsonArray recent = doc["recentSlow"].to<JsonArray>();
+    for (size_t f = 0; f < n; f++) {
+        JsonObject frame = recent.add<JsonObject>();
+        frame["atMs"] = frames[f].atMs;
+        frame["busyUs"] = frames[f].busyUs;
+        JsonObject breakdown = frame["stagesUs"].to<JsonObject>();
+        for (size_t i = 0; i < LoopProfiler::StageCount; i++) {
+            if (frames[f].stageUs[i]) {
+                breakdown[LoopProfiler::stageName(i)] = frames[f].stageUs[i];
+            }
+        }
+    }
+
+    sendJson(request, doc);
+}
+
+namespace {
+// "bytes=a-b", "bytes=a-" or "bytes=-n" (single range) -> inclusive [start, end] within total
+bool parseByteRange(const String& header, size_t total, size_t& start, size_t& end) {
+    if (!header.startsWith("bytes=") || header.indexOf(',') >= 0 || total == 0) {
+        return false;
+    }
+    const String spec = header.substring(6);
+    const int dash = spec.indexOf('-');
+    if (dash < 0) {
+        return false;
+    }
+    const String first = spec.substring(0, dash);
+    const String last = spec.substring(dash + 1);
+
+    if (first.isEmpty()) {
+        const long suffix = last.toInt();
+        if (suffix <= 0) {
+            return false;
+        }
+        start = total - min(static_cast<size_t>(suffix), total);
+        end = total - 1;
+        return true;
+    }
+
+    start = static_cast<size_t>(first.toInt());
+    end = last.isEmpty() ? total - 1 : min(static_cast<size_t>(last.toInt()), total - 1);
+    return start <= end && start < total;
+}
+} // namespace
+
+void WebServer::handleApiLogs(AsyncWebServerRequest *request) {
+    const size_t total = PersistentLog::size();
+    size_t start = 0;
+    size_t end = total ? total - 1 : 0;
+    bool partial = false;
+
+    if (request->hasHeader("Range")) {
+        if (!parseByteRange(request->header("Range"), total, start, end)) {
+            AsyncWebServerResponse* response = request->beginResponse(416, "text/plain", "");
+            response->addHeader("Content-Range", "bytes */" + String(static_cast<unsigned>(total)));
+            request->send(response);
+            return;
+        }
+        partial = true;
+    }
+
+    // Binary builds persist framed records: decode with scripts/log_decode.py
+    const char* contentType = LOG_BINARY ? "application/octet-stream" : "text/plain; charset=utf-8";
+    const size_t length = total ? (end - start + 1) : 0;
+
+    // Streamed from flash in response-sized pieces; nothing is buffered in RAM
+    AsyncWebServerResponse* response = request->beginResponse(
+        contentType, length, [start, length](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            const size_t want = min(maxLen, length - index);
+            size_t got = PersistentLog::read(start + index, buffer, want);
+            // The files rotated or were cleared mid-response: keep Content-Length honest
+            while (got < want) {
+                buffer[got++] = '\n';
+            }
+            return got;
+        });
+    response->addHeader("Accept-Ranges", "bytes");
+    response->addHeader("Cache-Control", "no-store");
+    if (partial) {
+        response->setCode(206);
+        char contentRange[48];
+        snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u", static_cast<unsigned>(start),
+                 static_cast<unsigned>(end), static_cast<unsigned>(total));
+        response->addHeader("Content-Range", contentRange);
+    }
     request->send(response);
 }
 
 void WebServer::handleApiFs(AsyncWebServerRequest *request) {
-    JsonDocument doc;
+    // Streamed with a chunked response: the listing is generated one entry at a time,
+    // so memory stays flat no matter how many files LittleFS holds.
+    auto state = std::make_shared<FsListStream>(fsMounted ? &LittleFS : nullptr);
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        "application/json",
+        [state](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            (void)index;
+            return state->fill(buffer, maxLen);
+        });
+    request->send(response);
+}
+
+void WebServer::handleApiHeap(AsyncWebServerRequest *request) {
+    HeapMonitor::sample();
 
-    doc["mounted"] = fsMounted;
+    PooledJsonDocument doc;
+    for (size_t c = 0; c < HeapMonitor::CapsCount; c++) {
+        HeapMonitor::Snapshot snap;
+        if (!HeapMonitor::get(c, snap)) {
+            continue;
+        }
+        JsonObject caps = doc[HeapMonitor::capsName(c)].to<JsonObject>();
+        caps["free"] = snap.freeBytes;
+        caps["largestBlock"] = snap.largestBlock;
+        caps["fragPercent"] = snap.fragPercent;
+        caps["minFree"] = snap.minFreeBytes;
+        caps["minLargestBlock"] = snap.minLargestBlock;
+        caps["maxFragPercent"] = snap.maxFragPercent;
+    }
 
-    JsonArray files = doc["files"].to<JsonArray>();
+    HeapMonitor::HistoryPoint history[HeapMonitor::kHistory];
+    const size_t points = HeapMonitor::getHistory(history, HeapMonitor::kHistory);
+    doc["historyIntervalS"] = HeapMonitor::kHistoryIntervalMs / 1000;
+    JsonArray hist = doc["history"].to<JsonArray>();
+    for (size_t i = 0; i < points; i++) {
+        JsonObject point = hist.add<JsonObject>();
+        point["atS"] = history[i].atS;
+        for (size_t c = 0; c < HeapMonitor::CapsCount; c++) {
+            JsonObject caps = point[HeapMonitor::capsName(c)].to<JsonObject>();
+            caps["minFree"] = history[i].minFreeBytes[c];
+            caps["minLargestBlock"] = history[i].minLargestBlock[c];
+        }
+    }
 
-    if (fsMounted) {
-        File root = LittleFS.open("/");
-        if (!root) {
-            doc["error"] = "Failed to open LittleFS root";
-        } else {
-            File file = root.openNextFile();
-            while (file) {
-                JsonObject f = files.add<JsonObject>();
-                f["name"] = file.name();
-                f["size"] = static_cast<uint32_t>(file.size());
-                file = root.openNextFile();
+    JsonObject tracker = doc["tracker"].to<JsonObject>();
+    tracker["compiled"] = AllocTracker::isCompiled();
+    if (AllocTracker::isCompiled()) {
+        constexpr size_t kTopSites = 16;
+        AllocTracker::Site sites[kTopSites];
+        const size_t n = AllocTracker::getTopSites(sites, kTopSites);
+        tracker["liveBlocks"] = AllocTracker::getLiveCount();
+        tracker["untracked"] = AllocTracker::getUntracked();
+        JsonArray top = tracker["sites"].to<JsonArray>();
+        for (size_t i = 0; i < n; i++) {
+            JsonObject site = top.add<JsonObject>();
+            JsonArray pcs = site["pcs"].to<JsonArray>();
+            for (size_t d = 0; d < AllocTracker::kSiteDepth && sites[i].pcs[d]; d++) {
+                char pc[11];
+                snprintf(pc, sizeof(pc), "0x%08lx", (unsigned long)sites[i].pcs[d]);
+                pcs.add(pc);
             }
+            site["liveBlocks"] = sites[i].liveCount;
+            site["liveBytes"] = sites[i].liveBytes;
+            site["allocs"] = sites[i].allocs;
         }
     }
 
-    String out;
-    serializeJson(doc, out);
-    request->send(200, "application/json", out);
+    sendJson(request, doc);
 }
+
+void WebServer::handleApiTrace(AsyncWebServerRequest *request) {
+    // Frozen while it downloads; a new POST ?enabled=1 during the download would clobber it
+    Trace::stop();
+    auto state = std::make_shared<TraceStream>();
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        "application/json",
+        [state](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            (void)index;
+            return state->fill(buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"vitrine-trace.json\"");
+    request->send(response);
+}
+
 void WebServer::handleNotFound(AsyncWebServerRequest *request) {
     const String path = request->url();
 
     // Step 4: SPA fallback routing
     // - Reserved paths (API/WS/OTA) never fall back
     // - Existing static files are served normally
-    // - Non-static GET requests fall back to index.html
+    // - Non-static GET requests fall back to index.html (from the hot cache, no FS lookup)
     if (isReservedNonSpaPath(path)) {
         request->send(404, "text/plain", "Not found");
         return;
     }
 
-    // Try to serve the requested file
-    if (fsMounted && LittleFS.exists(path)) {
-        request->send(LittleFS, path, getContentType(path));
-        return;
-    }
-
-    // If it looks like a static asset, return 404
+    // Static assets: serve the file or 404. serveStaticFile() tries the hot cache first and
+    // only needs LittleFS for the rest, so cached files still work while it is unmounted.
     if (isStaticAssetPath(path)) {
+        if (serveStaticFile(request, path)) {
+            return;
+        }
         request->send(404, "text/plain", "Not found");
         return;
     }
 
     // SPA fallback: serve index.html for non-static GET requests
-    if (request->method() == HTTP_GET && fsMounted && LittleFS.exists("/index.html")) {
-        request->send(LittleFS, "/index.html", "text/html");
+    if (request->method() == HTTP_GET && serveStaticFile(request, "/index.html")) {
         return;
     }
 
     request->send(500, "text/plain", fsMounted ? "index.html missing in LittleFS" : "LittleFS not mounted");
 }
 
+namespace {
+uint32_t fnv1a(const char* s) {
+    uint32_t h = 2166136261u;
+    while (s && *s) {
+        h ^= static_cast<uint8_t>(*s++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void addCacheHeaders(AsyncWebServerResponse* response, const char* etag, const char* cacheControl) {
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cacheControl);
+    response->addHeader("Vary", "Accept-Encoding");
+}
+
+bool etagMatches(AsyncWebServerRequest* request, const char* etag) {
+    return request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag;
+}
+
+void sendNotModified(AsyncWebServerRequest* request, const char* etag, const char* cacheControl) {
+    AsyncWebServerResponse* notModified = request->beginResponse(304);
+    addCacheHeaders(notModified, etag, cacheControl);
+    request->send(notModified);
+}
+} // namespace
+
+bool WebServer::serveStaticFile(AsyncWebServerRequest *request, const String &path) {
+    if (path.isEmpty() || path.endsWith("/")) {
+        return false;
+    }
+
+    const bool immutable = isImmutableAssetPath(path);
+    const char* cacheControl = immutable ? "public, max-age=31536000, immutable" : "no-cache";
+
+    // Hot files (SPA shell, OTA page) are served from RAM: no flash I/O
+    if (const HotFileCache::Entry* hot = hotCache.find(path)) {
+        const bool gzip = hot->gzData && acceptsGzip(request);
+        const char* etag = gzip ? hot->gzEtag : hot->etag;
+        if (etagMatches(request, etag)) {
+            sendNotModified(request, etag, cacheControl);
+            return true;
+        }
+        // Sent straight from the cache buffer: hold it until the connection is done, a
+        // filesystem OTA may reload the cache meanwhile
+        const uint8_t* body = gzip ? hot->gzData : hot->data;
+        HotFileCache::retain(body);
+        request->onDisconnect([body]() {
+            HotFileCache::release(body);
+        });
+        AsyncWebServerResponse* response =
+            request->beginResponse_P(200, getContentType(path), body, gzip ? hot->gzLen : hot->len);
+        if (gzip) {
+            response->addHeader("Content-Encoding", "gzip");
+        }
+        addCacheHeaders(response, etag, cacheControl);
+        request->send(response);
+        return true;
+    }
+
+    if (!fsMounted) {
+        return false;
+    }
+
+    // Prefer the build-time .gz variant when the client accepts it
+    bool gzip = false;
+    File file;
+    if (acceptsGzip(request)) {
+        file = LittleFS.open(path + ".gz", "r");
+        gzip = static_cast<bool>(file);
+    }
+    if (!file) {
+        file = LittleFS.open(path, "r");
+    }
+    if (!file || file.isDirectory()) {
+        return false;
+    }
+
+    // Hashed assets never change under the same name: path + size is enough.
+    // Other files also include the mtime so a re-uploaded file revalidates.
+    char etag[40];
+    if (immutable) {
+        snprintf(etag, sizeof(etag), "\"%08x-%x%s\"",
+                 static_cast<unsigned>(fnv1a(path.c_str())), static_cast<unsigned>(file.size()), gzip ? "g" : "");
+    } else {
+        snprintf(etag, sizeof(etag), "\"%08x-%x-%x%s\"",
+                 static_cast<unsigned>(fnv1a(path.c_str())), static_cast<unsigned>(file.size()),
+                 static_cast<unsigned>(file.getLastWrite()), gzip ? "g" : "");
+    }
+
+    if (etagMatches(request, etag)) {
+        file.close();
+        sendNotModified(request, etag, cacheControl);
+        return true;
+    }
+
+    // Pass the real file name (".gz" suffix included) so the library doesn't add its own
+    // Content-Encoding; the content type comes from the original path.
+    const String filePath = gzip ? (path + ".gz") : path;
+    AsyncWebServerResponse* response = request->beginResponse(file, filePath, getContentType(path));
+    if (gzip) {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    addCacheHeaders(response, etag, cacheControl);
+    request->send(response);
+    return true;
+}
+
+bool WebServer::acceptsGzip(AsyncWebServerRequest *request) {
+    if (!request->hasHeader("Accept-Encoding")) {
+        return false;
+    }
+    return request->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0;
+}
+
 const char* WebServer::getContentType(const String &path) {
     if (path.endsWith(".html")) return "text/html";
     if (path.endsWith(".css")) return "text/css";
@@ -329,6 +966,11 @@ bool WebServer::isReservedNonSpaPath(const String &path) {
     return false;
 }
 
+bool WebServer::isImmutableAssetPath(const String &path) {
+    // Vite emits content-hashed file names under /assets/
+    return path.startsWith("/assets/");
+}
+
 bool WebServer::isStaticAssetPath(const String &path) {
     // Treat common asset routes or any URL with a file extension as "static".
     if (path.startsWith("/assets/")) return true;
@@ -4,34 +4,60 @@
 #include <LittleFS.h>
 #include "WsServer.h"
 #include "OtaFirmware.h"
+#include "HotFileCache.h"
+#include "EventStream.h"
 
 class ModeManager;
+class WifiManager;
+class MqttManager;
 
 class WebServer {
 public:
     WebServer();
     
-    void begin(ModeManager* modeManager = nullptr);
+    void begin(ModeManager* modeManager = nullptr, WifiManager* wifiManager = nullptr, MqttManager* mqttManager = nullptr);
     
     bool isFsMounted() const { return fsMounted; }
     WsServer* getWsServer() { return &wsServer; }
+    HotFileCache* getHotFileCache() { return &hotCache; }
+    EventStream* getEventStream() { return &eventStream; }
 
 private:
     AsyncWebServer server;
     WsServer wsServer;
     OtaFirmware otaFirmware;
+    HotFileCache hotCache;
+    EventStream eventStream;
     bool fsMounted;
     ModeManager* modeManager;
+    WifiManager* wifiManager;
+    MqttManager* mqttManager;
     
+    struct TraceStream;
+
     void setupRoutes();
     void handleApiInfo(AsyncWebServerRequest *request);
     void handleApiFs(AsyncWebServerRequest *request);
+    void handleApiMetrics(AsyncWebServerRequest *request);
+    void handleApiProfile(AsyncWebServerRequest *request);
+    void handleApiTrace(AsyncWebServerRequest *request);
+    void handleApiHeap(AsyncWebServerRequest *request);
+    // Persistent WARN+ log; supports "Range: bytes=..." (206/416)
+    void handleApiLogs(AsyncWebServerRequest *request);
     void handleApiSettingsGet(AsyncWebServerRequest *request);
     void handleApiSettingsPost(AsyncWebServerRequest *request, uint8_t* data, size_t len, size_t index, size_t total);
-    void handleStaticFile(AsyncWebServerRequest *request);
+    // Serves a LittleFS file with gzip negotiation, ETag/304 and cache headers.
+    // Returns false if the file does not exist.
+    bool serveStaticFile(AsyncWebServerRequest *request, const String &path);
     void handleNotFound(AsyncWebServerRequest *request);
     
+    // Filesystem OTA hooks (see OtaFirmware::setFilesystemHooks)
+    static void unmountFs(void* ctx);
+    static bool remountFs(void* ctx);
+
     static const char* getContentType(const String &path);
     static bool isReservedNonSpaPath(const String &path);
     static bool isStaticAssetPath(const String &path);
+    static bool isImmutableAssetPath(const String &path);
+    static bool acceptsGzip(AsyncWebServerRequest *request);
 };
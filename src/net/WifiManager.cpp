@@ -1,6 +1,9 @@
 #include "WifiManager.h"
 #include "../util/Log.h"
 
+#include <esp_attr.h>
+#include <esp_wifi.h>
+
 #if __has_include("secrets.h")
 #include "secrets.h"
 #define HAS_WIFI_SECRETS 1
@@ -16,20 +19,74 @@
 #define AP_PASS "vitrine1234"
 #endif
 
+namespace {
+constexpr uint32_t kConnectTimeoutMs = 12000;
+constexpr uint32_t kBackoffMinMs = 1000;
+constexpr uint32_t kBackoffMaxMs = 60000;
+constexpr uint32_t kRssiSampleIntervalMs = 2000;
+
+// Last AP we associated with. RTC_NOINIT keeps it across soft resets (OTA reboot),
+// so the first connect after a restart can skip the channel scan.
+constexpr uint32_t kFastReconnectMagic = 0x57464331; // "WFC1"
+struct FastReconnectCache {
+    uint32_t magic;
+    uint32_t ssidHash;
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+RTC_NOINIT_ATTR FastReconnectCache s_fastCache;
+
+uint32_t hashSsid(const char* s) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    while (s && *s) {
+        h ^= static_cast<uint8_t>(*s++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool fastCacheValidFor(const char* ssid) {
+    return s_fastCache.magic == kFastReconnectMagic &&
+           s_fastCache.ssidHash == hashSsid(ssid) &&
+           s_fastCache.channel >= 1 && s_fastCache.channel <= 14;
+}
+
+void invalidateFastCache() {
+    s_fastCache.magic = 0;
+}
+
+void copyCStr(char* dst, size_t dstSize, const char* src) {
+    strncpy(dst, src ? src : "", dstSize - 1);
+    dst[dstSize - 1] = '\0';
+}
+} // namespace
+
 void WifiManager::begin() {
     DeviceSettings defaults;
     begin(defaults);
 }
 
 void WifiManager::begin(const DeviceSettings& settings) {
-    const bool staEnabled = settings.wifiStaEnabled;
+    // We own reconnects (backoff + fast path); the driver must not retry on its own.
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+        onWifiEvent(event, info);
+    });
+
+    staEnabled = settings.wifiStaEnabled;
     WiFi.mode(staEnabled ? WIFI_MODE_APSTA : WIFI_MODE_AP);
 
+    startAccessPoint(&settings);
+
     if (staEnabled) {
         connectStation(&settings);
+    } else {
+        LOGI("wifi", "STA disabled; AP only");
     }
 
-    startAccessPoint(&settings);
+    started = true;
 }
 
 static bool hasNonEmpty(const char* s) {
@@ -52,26 +109,19 @@ bool WifiManager::connectStation(const DeviceSettings* settings) {
     }
 #endif
 
-    if (!ssid || ssid[0] == '\0') {
+    copyCStr(staSsid, sizeof(staSsid), ssid);
+    copyCStr(staPass, sizeof(staPass), pass);
+
+    if (staSsid[0] == '\0') {
         LOGW("wifi", "STA disabled/no credentials; AP only");
+        staState = StaState::Disabled;
         return false;
     }
 
-    LOGI("wifi", "Connecting to SSID: %s", ssid);
-    WiFi.begin(ssid, pass ? pass : "");
-    
-    const uint32_t startMs = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - startMs) < 15000) {
-        delay(250);
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        LOGI("wifi", "Connected, IP: %s", WiFi.localIP().toString().c_str());
-        return true;
-    } else {
-        LOGW("wifi", "STA connect timeout; falling back to AP only");
-        return false;
-    }
+    // Non-blocking: the result arrives as a Wi-Fi event and is handled in tick()
+    backoffMs = kBackoffMinMs;
+    startAttempt(millis());
+    return true;
 }
 
 void WifiManager::startAccessPoint(const DeviceSettings* settings) {
@@ -92,6 +142,194 @@ void WifiManager::startAccessPoint(const DeviceSettings* settings) {
     }
 }
 
+void WifiManager::onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    // Runs on the Wi-Fi event task: record only, tick() does the work.
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+            s_fastCache.ssidHash = hashSsid(reinterpret_cast<const char*>(info.wifi_sta_connected.ssid));
+            memcpy(s_fastCache.bssid, info.wifi_sta_connected.bssid, sizeof(s_fastCache.bssid));
+            s_fastCache.channel = info.wifi_sta_connected.channel;
+            s_fastCache.magic = kFastReconnectMagic;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            eventGotIp = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            // ASSOC_LEAVE is our own WiFi.disconnect(); the state machine already knows.
+            if (info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_LEAVE) {
+                break;
+            }
+            lastDisconnectReason = info.wifi_sta_disconnected.reason;
+            eventDisconnected = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void WifiManager::startAttempt(uint32_t nowMs) {
+    fastPathAttempt = fastCacheValidFor(staSsid);
+    if (fastPathAttempt) {
+        LOGI("wifi", "Connecting to SSID: %s (cached ch %u)", staSsid, static_cast<unsigned>(s_fastCache.channel));
+        WiFi.begin(staSsid, staPass, s_fastCache.channel, s_fastCache.bssid, true);
+    } else {
+        LOGI("wifi", "Connecting to SSID: %s", staSsid);
+        WiFi.begin(staSsid, staPass);
+    }
+    attemptStartMs = nowMs;
+    staState = StaState::Connecting;
+}
+
+void WifiManager::scheduleRetry(uint32_t nowMs) {
+    if (fastPathAttempt) {
+        // The AP may have moved channel/BSSID: next attempt does a full scan.
+        invalidateFastCache();
+    }
+
+    // Up to +25% jitter so several devices don't hammer the router in lockstep
+    const uint32_t jitter = (backoffMs / 4) ? static_cast<uint32_t>(random(backoffMs / 4)) : 0;
+    nextAttemptMs = nowMs + backoffMs + jitter;
+    LOGI("wifi", "STA retry in %u ms (reason %u)", static_cast<unsigned>(backoffMs + jitter), static_cast<unsigned>(lastDisconnectReason));
+
+    backoffMs = (backoffMs >= kBackoffMaxMs / 2) ? kBackoffMaxMs : backoffMs * 2;
+    staState = StaState::Backoff;
+}
+
+void WifiManager::setStationConfig(bool enabled, const char* ssid, const char* pass) {
+    portENTER_CRITICAL(&configMux);
+    pendingEnabled = enabled;
+    pendingSsidSet = (ssid != nullptr);
+    if (ssid) {
+        copyCStr(pendingSsid, sizeof(pendingSsid), ssid);
+    }
+    pendingPassSet = (pass != nullptr);
+    if (pass) {
+        copyCStr(pendingPass, sizeof(pendingPass), pass);
+    }
+    pendingConfig = true;
+    portEXIT_CRITICAL(&configMux);
+}
+
+void WifiManager::applyPendingConfig() {
+    DeviceSettings next;
+    bool enabled = false;
+
+    portENTER_CRITICAL(&configMux);
+    if (!pendingConfig) {
+        portEXIT_CRITICAL(&configMux);
+        return;
+    }
+    pendingConfig = false;
+    enabled = pendingEnabled;
+    copyCStr(next.wifiStaSsid, sizeof(next.wifiStaSsid), pendingSsidSet ? pendingSsid : staSsid);
+    copyCStr(next.wifiStaPass, sizeof(next.wifiStaPass), pendingPassSet ? pendingPass : staPass);
+    portEXIT_CRITICAL(&configMux);
+
+    LOGI("wifi", "Applying new STA config (enabled=%d)", enabled ? 1 : 0);
+
+    if (staState == StaState::Connected || staState == StaState::Connecting) {
+        WiFi.disconnect(false);
+    }
+    eventGotIp = false;
+    eventDisconnected = false;
+    invalidateFastCache();
+
+    staEnabled = enabled;
+    if (!staEnabled) {
+        WiFi.mode(WIFI_MODE_AP);
+        staState = StaState::Disabled;
+        LOGI("wifi", "STA disabled; AP only");
+        return;
+    }
+
+    WiFi.mode(WIFI_MODE_APSTA);
+    connectStation(&next);
+}
+
+void WifiManager::tick() {
+    if (!started) {
+        return;
+    }
+
+    applyPendingConfig();
+
+    const uint32_t now = millis();
+
+    if (eventGotIp.exchange(false)) {
+        LOGI("wifi", "Connected, IP: %s (%u ms%s)",
+             WiFi.localIP().toString().c_str(),
+             static_cast<unsigned>(now - attemptStartMs),
+             fastPathAttempt ? ", fast path" : "");
+        staState = StaState::Connected;
+        backoffMs = kBackoffMinMs;
+        rssiAvgQ2 = static_cast<int16_t>(WiFi.RSSI() * 4);
+        lastRssiSampleMs = now;
+    }
+
+    if (eventDisconnected.exchange(false)) {
+        if (staState == StaState::Connected) {
+            reconnectCount++;
+            LOGW("wifi", "STA link lost (reason %u)", static_cast<unsigned>(lastDisconnectReason));
+            rssiAvgQ2 = 0;
+        }
+        if (staState == StaState::Connected || staState == StaState::Connecting) {
+            scheduleRetry(now);
+        }
+    }
+
+    switch (staState) {
+        case StaState::Connecting:
+            if ((now - attemptStartMs) > kConnectTimeoutMs) {
+                LOGW("wifi", "STA connect timeout");
+                WiFi.disconnect(false);
+                scheduleRetry(now);
+            }
+            break;
+        case StaState::Backoff:
+            if (static_cast<int32_t>(now - nextAttemptMs) >= 0) {
+                startAttempt(now);
+            }
+            break;
+        case StaState::Connected:
+            if ((now - lastRssiSampleMs) >= kRssiSampleIntervalMs) {
+                lastRssiSampleMs = now;
+                // EWMA, alpha = 1/4
+                rssiAvgQ2 = static_cast<int16_t>(rssiAvgQ2 + WiFi.RSSI() - rssiAvgQ2 / 4);
+            }
+            break;
+        case StaState::Disabled:
+            break;
+    }
+}
+
+const char* WifiManager::getStaStateName(StaState state) {
+    switch (state) {
+        case StaState::Disabled: return "disabled";
+        case StaState::Connecting: return "connecting";
+        case StaState::Connected: return "connected";
+        case StaState::Backoff: return "backoff";
+    }
+    return "?";
+}
+
+int8_t WifiManager::getRssi() const {
+    if (staState != StaState::Connected) {
+        return 0;
+    }
+    return static_cast<int8_t>(rssiAvgQ2 / 4);
+}
+
+uint8_t WifiManager::getLinkQualityPercent() const {
+    if (staState != StaState::Connected) {
+        return 0;
+    }
+    // Linear map: -90 dBm -> 0%, -50 dBm -> 100%
+    const int rssi = getRssi();
+    if (rssi <= -90) return 0;
+    if (rssi >= -50) return 100;
+    return static_cast<uint8_t>((rssi + 90) * 100 / 40);
+}
+
 const char* WifiManager::getActiveIP() const {
     static String ipStr;
     if (WiFi.status() == WL_CONNECTED) {
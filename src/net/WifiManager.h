@@ -1,18 +1,83 @@
 #pragma once
 
 #include <WiFi.h>
+#include <atomic>
 
 #include "util/DeviceSettings.h"
 
+// Event-driven Wi-Fi manager.
+// - The AP is always up; the station connects in the background (never blocks).
+// - Disconnects are retried with exponential backoff (tick() drives the state machine).
+// - The last BSSID/channel is cached (survives soft resets) for a scan-less reconnect.
 class WifiManager {
 public:
+    enum class StaState : uint8_t {
+        Disabled,    // STA off or no credentials (AP only)
+        Connecting,  // WiFi.begin() issued, waiting for an IP
+        Connected,   // got IP
+        Backoff,     // waiting before the next attempt
+    };
+
     void begin();
     void begin(const DeviceSettings& settings);
-    
+
+    // Call frequently from loop(): processes Wi-Fi events, retries and RSSI sampling
+    void tick();
+
+    // Apply new station settings live (safe to call from any task; applied on the next tick()).
+    // ssid/pass == nullptr keeps the current value.
+    void setStationConfig(bool enabled, const char* ssid, const char* pass);
+
     const char* getActiveIP() const;
     bool isStationConnected() const;
 
+    StaState getStaState() const { return staState; }
+    static const char* getStaStateName(StaState state);
+
+    // Smoothed RSSI in dBm (0 when not connected) and a 0..100 link quality estimate
+    int8_t getRssi() const;
+    uint8_t getLinkQualityPercent() const;
+
+    uint32_t getReconnectCount() const { return reconnectCount; }
+    uint8_t getLastDisconnectReason() const { return lastDisconnectReason; }
+
 private:
     bool connectStation(const DeviceSettings* settings);
     void startAccessPoint(const DeviceSettings* settings);
+
+    void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info);
+    void startAttempt(uint32_t nowMs);
+    void scheduleRetry(uint32_t nowMs);
+    void applyPendingConfig();
+
+    std::atomic<bool> started{false};
+    volatile StaState staState = StaState::Disabled;
+
+    bool staEnabled = false;
+    char staSsid[WIFI_SSID_MAX_LEN + 1] = {0};
+    char staPass[WIFI_PASS_MAX_LEN + 1] = {0};
+
+    // Live config handoff from other tasks (HTTP handlers)
+    portMUX_TYPE configMux = portMUX_INITIALIZER_UNLOCKED;
+    bool pendingConfig = false;
+    bool pendingEnabled = false;
+    bool pendingSsidSet = false;
+    bool pendingPassSet = false;
+    char pendingSsid[WIFI_SSID_MAX_LEN + 1] = {0};
+    char pendingPass[WIFI_PASS_MAX_LEN + 1] = {0};
+
+    // Set from the Wi-Fi event task, consumed by tick()
+    std::atomic<bool> eventGotIp{false};
+    std::atomic<bool> eventDisconnected{false};
+    volatile uint8_t lastDisconnectReason = 0;
+
+    uint32_t attemptStartMs = 0;
+    uint32_t nextAttemptMs = 0;
+    uint32_t backoffMs = 0;
+    bool fastPathAttempt = false;
+    uint32_t reconnectCount = 0;
+
+    // Link quality (EWMA of RSSI, dBm * 4)
+    int16_t rssiAvgQ2 = 0;
+    uint32_t lastRssiSampleMs = 0;
 };
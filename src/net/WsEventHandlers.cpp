@@ -2,17 +2,121 @@
 
 #include <ArduinoJson.h>
 
+#include "net/JsonPool.h"
 #include "net/MaintenanceMode.h"
 #include "util/Log.h"
 #include "hardware/ModeManager.h"
+#include "net/WsStateModel.h"
+#include "net/WsLogStream.h"
 
 struct WsLedContext {
     LedControl* ledControl;
     LedMovementControl* ledMovementControl;
     ModeManager* modeManager;
+    WsStateModel* stateModel;
+    WsLogStream* logStream;
 };
 
-static WsLedContext g_ctx = {nullptr, nullptr, nullptr};
+static WsLedContext g_ctx = {nullptr, nullptr, nullptr, nullptr, nullptr};
+
+static void sendWsJson(AsyncWebSocketClient* client, const JsonDocument& doc) {
+    PooledJsonBuffer out;
+    if (out.serialize(doc)) {
+        client->text(out.c_str(), out.length());
+    }
+}
+
+static void sendWsError(AsyncWebSocketClient* client, const char* error) {
+    PooledJsonDocument response;
+    response["type"] = "error";
+    response["error"] = error;
+    sendWsJson(client, response);
+}
+
+// {"type":"log","level":"debug","tag":"ota"} (tag optional) or {"type":"log","enabled":false}
+static void handleLogSubscription(WsLedContext* c, AsyncWebSocketClient* client, JsonDocument& doc) {
+    if (!c->logStream) {
+        sendWsError(client, "log_unavailable");
+        return;
+    }
+
+    PooledJsonDocument response;
+    response["type"] = "ok";
+    response["for"] = "log";
+
+    if (!(doc["enabled"] | true)) {
+        c->logStream->unsubscribe(client->id());
+        response["subscribed"] = false;
+    } else {
+        int level = static_cast<int>(LogLevel::Info);
+        const char* levelName = doc["level"];
+        if (levelName && (!LogTags::parseLevel(levelName, level) || level < 0)) {
+            sendWsError(client, "bad_level");
+            return;
+        }
+        const char* tag = doc["tag"];
+        if (!c->logStream->subscribe(client->id(), static_cast<LogLevel>(level), tag)) {
+            sendWsError(client, "log_subscribers");
+            return;
+        }
+        response["subscribed"] = true;
+        response["level"] = LogTags::levelName(level);
+        if (tag) {
+            response["tag"] = tag;
+        }
+    }
+
+    sendWsJson(client, response);
+}
+
+// {"type":"logLevel","tag":"ota"|"*","level":"error"|"warn"|"info"|"debug"|"off"|"default"}
+// Without tag/level it only lists the current levels.
+static void handleLogLevel(AsyncWebSocketClient* client, JsonDocument& doc) {
+    const char* tag = doc["tag"];
+    const char* levelName = doc["level"];
+    if (tag && levelName) {
+        int level;
+        if (strcmp(levelName, "default") == 0) {
+            LogTags::clearOverride(tag);
+        } else if (!LogTags::parseLevel(levelName, level)) {
+            sendWsError(client, "bad_level");
+            return;
+        } else if (!LogTags::setLevel(tag, level)) {
+            sendWsError(client, "log_tags_full");
+            return;
+        } else {
+            LOGI("log", "Level of '%s' set to %s", tag, levelName);
+        }
+    }
+
+    PooledJsonDocument response;
+    response["type"] = "logLevels";
+    response["default"] = LogTags::levelName(LogTags::getDefaultLevel());
+    response["max"] = LogTags::levelName(LOG_LEVEL);
+    JsonObject tags = response["tags"].to<JsonObject>();
+    JsonArray overrides = response["overrides"].to<JsonArray>();
+    const size_t count = LogTags::count();
+    for (size_t i = 0; i < count; i++) {
+        const char* name;
+        int level;
+        bool overridden;
+        if (LogTags::get(i, name, level, overridden) && name[0] != '\0') {
+            tags[name] = LogTags::levelName(level);
+            if (overridden) {
+                overrides.add(name);
+            }
+        }
+    }
+
+    sendWsJson(client, response);
+}
+
+static void handleWsConnect(void* ctx, AsyncWebSocketClient* client) {
+    auto* c = static_cast<WsLedContext*>(ctx);
+    if (c && c->stateModel) {
+        c->stateModel->sendSnapshot(client);
+    }
+}
 
 static void handleWsTextMessage(void* ctx, AsyncWebSocketClient* client, const char* message, size_t len) {
     (void)len;
@@ -23,28 +127,37 @@ static void handleWsTextMessage(void* ctx, AsyncWebSocketClient* client, const c
     }
 
     if (MaintenanceMode::getInstance().isActive()) {
-        JsonDocument response;
-        response["type"] = "error";
-        response["error"] = "maintenance";
-        String out;
-        serializeJson(response, out);
-        client->text(out);
+        sendWsError(client, "maintenance");
         return;
     }
 
-    JsonDocument doc;
+    PooledJsonDocument doc;
     DeserializationError err = deserializeJson(doc, message);
     if (err) {
-        JsonDocument response;
-        response["type"] = "error";
-        response["error"] = "bad_json";
-        String out;
-        serializeJson(response, out);
-        client->text(out);
+        sendWsError(client, "bad_json");
         return;
     }
 
     const char* type = doc["type"];
+
+    // {"type":"sync","epoch":E,"since":N} -> missed deltas (or a snapshot)
+    if (type && strcmp(type, "sync") == 0) {
+        if (c->stateModel) {
+            c->stateModel->handleSync(client, doc["epoch"] | 0u, doc["since"] | 0u);
+        }
+        return;
+    }
+
+    if (type && strcmp(type, "log") == 0) {
+        handleLogSubscription(c, client, doc);
+        return;
+    }
+
+    if (type && strcmp(type, "logLevel") == 0) {
+        handleLogLevel(client, doc);
+        return;
+    }
+
     if (!type || strcmp(type, "led") != 0) {
         return;
     }
@@ -102,21 +215,23 @@ static void handleWsTextMessage(void* ctx, AsyncWebSocketClient* client, const c
         LOGW("ws", "Unknown led cmd: %s", cmd);
     }
 
-    JsonDocument response;
+    PooledJsonDocument response;
     response["type"] = "ok";
     response["for"] = "led";
     response["cmd"] = cmd;
-    String out;
-    serializeJson(response, out);
-    client->text(out);
+    sendWsJson(client, response);
 }
 
-void attachWsEventHandlers(WsServer& wsServer, LedControl& ledControl, LedMovementControl& ledMovementControl, ModeManager* modeManager) {
+void attachWsEventHandlers(WsServer& wsServer, LedControl& ledControl, LedMovementControl& ledMovementControl,
+                           ModeManager* modeManager, WsStateModel* stateModel, WsLogStream* logStream) {
     g_ctx.ledControl = &ledControl;
     g_ctx.ledMovementControl = &ledMovementControl;
     g_ctx.modeManager = modeManager;
+    g_ctx.stateModel = stateModel;
+    g_ctx.logStream = logStream;
 
     wsServer.setTextMessageHandler(&g_ctx, handleWsTextMessage);
+    wsServer.setConnectHandler(&g_ctx, handleWsConnect);
 }
 
 static void wsBroadcastJson(WsServer& wsServer, const JsonDocument& doc) {
@@ -124,13 +239,14 @@ static void wsBroadcastJson(WsServer& wsServer, const JsonDocument& doc) {
         return;
     }
 
-    String out;
-    serializeJson(doc, out);
-    wsServer.broadcastMessage(out.c_str());
+    PooledJsonBuffer out;
+    if (out.serialize(doc)) {
+        wsServer.broadcastMessage(out.c_str());
+    }
 }
 
 void broadcastEncoderRotate(WsServer& wsServer, int index) {
-    JsonDocument doc;
+    PooledJsonDocument doc;
     doc["type"] = "encoder";
     doc["event"] = "rotate";
     doc["index"] = index;
@@ -139,7 +255,7 @@ void broadcastEncoderRotate(WsServer& wsServer, int index) {
 }
 
 void broadcastEncoderPress(WsServer& wsServer, int index) {
-    JsonDocument doc;
+    PooledJsonDocument doc;
     doc["type"] = "encoder";
     doc["event"] = "press";
     doc["index"] = index;
@@ -148,7 +264,7 @@ void broadcastEncoderPress(WsServer& wsServer, int index) {
 }
 
 void broadcastDisplayMiniature(WsServer& wsServer, int index) {
-    JsonDocument doc;
+    PooledJsonDocument doc;
     doc["type"] = "display";
     doc["event"] = "miniature";
     doc["index"] = index;
@@ -5,9 +5,15 @@
 #include "hardware/LedMovementControl.h"
 
 class ModeManager;
+class WsStateModel;
+class WsLogStream;
 
 // Attaches application-specific WS handlers (e.g., LED control) to the websocket server.
-void attachWsEventHandlers(WsServer& wsServer, LedControl& ledControl, LedMovementControl& ledMovementControl, ModeManager* modeManager = nullptr);
+// With a state model, new clients get a snapshot and {"type":"sync"} replays missed deltas.
+// With a log stream, {"type":"log"} subscribes to live log lines; {"type":"logLevel"} always works.
+void attachWsEventHandlers(WsServer& wsServer, LedControl& ledControl, LedMovementControl& ledMovementControl,
+                           ModeManager* modeManager = nullptr, WsStateModel* stateModel = nullptr,
+                           WsLogStream* logStream = nullptr);
 
 // Broadcasts encoder/display events over WebSocket.
 void broadcastEncoderRotate(WsServer& wsServer, int index);
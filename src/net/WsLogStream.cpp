@@ -0,0 +1,233 @@
+#include "WsLogStream.h"
+
+#include "WsServer.h"
+#include "../util/JsonEscape.h"
+
+namespace {
+constexpr size_t kMsgTailBytes = 32;  // ],"dropped":4294967295}
+constexpr uint32_t kMaxRefillMs = 10 * 1000;
+
+// "[ms][L][tag] message": offset/length of the tag, 0/0 when the line has none
+void findTag(const char* line, size_t len, size_t& off, size_t& n) {
+    off = 0;
+    n = 0;
+    const char* p = static_cast<const char*>(memchr(line, ']', len));
+    if (!p) {
+        return;
+    }
+    size_t i = static_cast<size_t>(p - line) + 1;
+    if (i + 3 >= len || line[i] != '[' || line[i + 2] != ']') {
+        return;
+    }
+    i += 3;
+    if (line[i] != '[') {
+        return;
+    }
+    const char* end = static_cast<const char*>(memchr(line + i + 1, ']', len - i - 1));
+    if (end) {
+        off = i + 1;
+        n = static_cast<size_t>(end - (line + off));
+    }
+}
+} // namespace
+
+void WsLogStream::begin(WsServer* wsServerIn) {
+    wsServer = wsServerIn;
+    lastRefillMs = millis();
+    Log::setLineSink(this, onLine);
+}
+
+bool WsLogStream::subscribe(uint32_t clientId, LogLevel level, const char* tag) {
+    Subscriber* slot = nullptr;
+    portENTER_CRITICAL(&mux);
+    for (Subscriber& sub : subscribers) {
+        if (sub.active && sub.clientId == clientId) {
+            slot = &sub;
+            break;
+        }
+    }
+    if (!slot) {
+        for (Subscriber& sub : subscribers) {
+            if (!sub.active) {
+                slot = &sub;
+                subscriberCount++;
+                break;
+            }
+        }
+    }
+    if (slot) {
+        slot->clientId = clientId;
+        slot->level = static_cast<uint8_t>(level);
+        strncpy(slot->tag, tag ? tag : "", sizeof(slot->tag) - 1);
+        slot->tag[sizeof(slot->tag) - 1] = '\0';
+        slot->dropped = 0;
+        slot->active = true;
+    }
+    portEXIT_CRITICAL(&mux);
+    return slot != nullptr;
+}
+
+void WsLogStream::unsubscribe(uint32_t clientId) {
+    portENTER_CRITICAL(&mux);
+    for (Subscriber& sub : subscribers) {
+        if (sub.active && sub.clientId == clientId) {
+            sub.active = false;
+            subscriberCount--;
+        }
+    }
+    if (subscriberCount == 0) {
+        pendingLen = 0;
+        dropped = 0;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+bool WsLogStream::wants(const Subscriber& sub, LogLevel level, const char* tag, size_t tagLen) {
+    if (static_cast<uint8_t>(level) > sub.level) {
+        return false;
+    }
+    if (sub.tag[0] == '\0') {
+        return true;
+    }
+    return strlen(sub.tag) == tagLen && strncmp(sub.tag, tag, tagLen) == 0;
+}
+
+void WsLogStream::onLine(void* ctx, const char* line, size_t len, LogLevel level) {
+    static_cast<WsLogStream*>(ctx)->handleLine(line, len, level);
+}
+
+// Log drain task: must not log (the line would come straight back here)
+void WsLogStream::handleLine(const char* line, size_t len, LogLevel level) {
+    if (subscriberCount.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        len--;
+    }
+    len = min(len, static_cast<size_t>(UINT8_MAX));
+    size_t tagOff;
+    size_t tagLen;
+    findTag(line, len, tagOff, tagLen);
+
+    portENTER_CRITICAL(&mux);
+    bool wanted = false;
+    for (const Subscriber& sub : subscribers) {
+        if (sub.active && wants(sub, level, line + tagOff, tagLen)) {
+            wanted = true;
+            break;
+        }
+    }
+    if (wanted) {
+        const uint32_t now = millis();
+        const uint32_t elapsed = min(now - lastRefillMs, kMaxRefillMs);
+        lastRefillMs = now;
+        tokensMilli = min(tokensMilli + elapsed * kLinesPerSec, kBurstLines * 1000);
+
+        if (tokensMilli < 1000 || pendingLen + kEntryHeaderBytes + len > sizeof(pending)) {
+            dropped++;
+        } else {
+            tokensMilli -= 1000;
+            uint8_t* e = pending + pendingLen;
+            e[0] = static_cast<uint8_t>(level);
+            e[1] = static_cast<uint8_t>(tagOff);
+            e[2] = static_cast<uint8_t>(tagLen);
+            e[3] = static_cast<uint8_t>(len);
+            memcpy(e + kEntryHeaderBytes, line, len);
+            pendingLen += kEntryHeaderBytes + len;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+void WsLogStream::tick() {
+    if (!wsServer || subscriberCount.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    const uint32_t now = millis();
+    if (now - lastSendMs < kSendIntervalMs) {
+        return;
+    }
+    lastSendMs = now;
+
+    // Take the pending lines and the subscriber list; format/send without the lock
+    Subscriber subs[kMaxSubscribers];
+    size_t entriesLen;
+    portENTER_CRITICAL(&mux);
+    entriesLen = pendingLen;
+    memcpy(entries, pending, pendingLen);
+    pendingLen = 0;
+    for (size_t i = 0; i < kMaxSubscribers; i++) {
+        if (subscribers[i].active) {
+            subscribers[i].dropped += dropped;
+        }
+        subs[i] = subscribers[i];
+        subscribers[i].dropped = 0;
+    }
+    dropped = 0;
+    portEXIT_CRITICAL(&mux);
+
+    for (Subscriber& sub : subs) {
+        if (sub.active) {
+            sendTo(sub, entries, entriesLen);
+        }
+    }
+}
+
+void WsLogStream::sendTo(Subscriber& sub, const uint8_t* entryData, size_t entriesLen) {
+    size_t len = static_cast<size_t>(snprintf(msg, sizeof(msg), "{\"type\":\"log\",\"lines\":["));
+    uint32_t lines = 0;
+    uint32_t missed = sub.dropped;
+
+    for (size_t pos = 0; pos + kEntryHeaderBytes <= entriesLen;) {
+        const uint8_t* e = entryData + pos;
+        const LogLevel level = static_cast<LogLevel>(e[0]);
+        const char* line = reinterpret_cast<const char*>(e + kEntryHeaderBytes);
+        pos += kEntryHeaderBytes + e[3];
+        if (!wants(sub, level, line + e[1], e[2])) {
+            continue;
+        }
+
+        const size_t start = len;
+        if (len + kMsgTailBytes + 3 > sizeof(msg)) {
+            missed++;
+            continue;
+        }
+        if (lines > 0) {
+            msg[len++] = ',';
+        }
+        msg[len++] = '"';
+        const size_t escaped = json_escape::escape(msg + len, sizeof(msg) - kMsgTailBytes - 1 - len, line, e[3]);
+        if (escaped == 0 && e[3] > 0) {
+            len = start;
+            missed++;
+            continue;
+        }
+        len += escaped;
+        msg[len++] = '"';
+        lines++;
+    }
+
+    if (lines == 0 && missed == 0) {
+        return;
+    }
+    snprintf(msg + len, sizeof(msg) - len, "],\"dropped\":%lu}", (unsigned long)missed);
+
+    if (wsServer->sendTo(sub.clientId, msg)) {
+        return;
+    }
+
+    // Not delivered: the client left (drop the subscription) or its queue is full (count the lines)
+    const bool gone = !wsServer->hasClient(sub.clientId);
+    if (gone) {
+        unsubscribe(sub.clientId);
+        return;
+    }
+    portENTER_CRITICAL(&mux);
+    for (Subscriber& live : subscribers) {
+        if (live.active && live.clientId == sub.clientId) {
+            live.dropped += missed + lines;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+}
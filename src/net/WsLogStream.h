@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "util/Log.h"
+
+class WsServer;
+
+// Live log lines for WebSocket clients that sent {"type":"log","level":"debug","tag":"ota"}.
+// - The log drain task hands every text line over (Log::setLineSink); lines no subscriber
+//   wants are skipped, the rest are copied into a small pending buffer.
+// - A token bucket caps the stream at kLinesPerSec (bursts of kBurstLines); lines over the
+//   budget, or that don't fit the buffer, are counted and reported as "dropped".
+// - tick() (loop) sends the pending lines every kSendIntervalMs as one
+//   {"type":"log","lines":[...],"dropped":N} message per subscriber, filtered by its level/tag.
+// Only lines that pass the runtime tag levels (LogTags) reach the stream; in binary log mode
+// (LOG_BINARY) that is just the direct Log::info() & co. calls.
+class WsLogStream {
+public:
+    static constexpr size_t kMaxSubscribers = 4;
+    static constexpr uint32_t kLinesPerSec = 20;
+    static constexpr uint32_t kBurstLines = 40;
+    static constexpr uint32_t kSendIntervalMs = 250;
+
+    void begin(WsServer* wsServer);
+
+    // Call from loop()
+    void tick();
+
+    // AsyncTCP task. level: highest level to stream; tag: nullptr/"" for all tags.
+    // Re-subscribing replaces the filter. False when all subscriber slots are taken.
+    bool subscribe(uint32_t clientId, LogLevel level, const char* tag);
+    void unsubscribe(uint32_t clientId);
+
+private:
+    static constexpr size_t kPendingBytes = 1536;
+    static constexpr size_t kMsgBytes = 2048;
+    static constexpr size_t kEntryHeaderBytes = 4;  // level, tag offset, tag length, line length
+
+    struct Subscriber {
+        uint32_t clientId;
+        uint8_t level;
+        char tag[LogTags::kMaxNameLen + 1];
+        uint32_t dropped;  // lines this client missed since its last message
+        bool active;
+    };
+
+    static void onLine(void* ctx, const char* line, size_t len, LogLevel level);
+    void handleLine(const char* line, size_t len, LogLevel level);
+    static bool wants(const Subscriber& sub, LogLevel level, const char* tag, size_t tagLen);
+    void sendTo(Subscriber& sub, const uint8_t* entryData, size_t entriesLen);
+
+    WsServer* wsServer = nullptr;
+    std::atomic<uint8_t> subscriberCount{0};
+    uint32_t lastSendMs = 0;
+
+    // Guarded by mux (drain task, AsyncTCP task, loop)
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    Subscriber subscribers[kMaxSubscribers] = {};
+    uint8_t pending[kPendingBytes];
+    size_t pendingLen = 0;
+    uint32_t dropped = 0;
+    uint32_t tokensMilli = kBurstLines * 1000;
+    uint32_t lastRefillMs = 0;
+
+    // loop() only
+    uint8_t entries[kPendingBytes];
+    char msg[kMsgBytes];
+};
@@ -1,8 +1,18 @@
 #include "WsServer.h"
 #include "../util/Log.h"
 #include "MaintenanceMode.h"
+#include "JsonPool.h"
+#include "../util/Metrics.h"
+#include "../util/Trace.h"
 #include <ArduinoJson.h>
 
+namespace {
+MetricCounter s_msgIn("vitrine_ws_messages", "WebSocket messages", "dir=\"in\"");
+MetricCounter s_msgOut("vitrine_ws_messages", "WebSocket messages", "dir=\"out\"");
+// Oversized incoming messages, and pushes to a client whose send queue was full
+MetricCounter s_msgDropped("vitrine_ws_messages_dropped", "WebSocket messages dropped");
+} // namespace
+
 WsServer::WsServer() : ws("/ws") {}
 
 void WsServer::setTextMessageHandler(void* ctx, TextMessageHandler handler) {
@@ -10,6 +20,11 @@ void WsServer::setTextMessageHandler(void* ctx, TextMessageHandler handler) {
     msgHandler = handler;
 }
 
+void WsServer::setConnectHandler(void* ctx, ConnectHandler handler) {
+    connectCtx = ctx;
+    connectHandler = handler;
+}
+
 void WsServer::begin(AsyncWebServer *server) {
     ws.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, 
                       AwsEventType type, void *arg, uint8_t *data, size_t len) {
@@ -24,9 +39,11 @@ void WsServer::handleEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
                            AwsEventType type, void *arg, uint8_t *data, size_t len) {
     switch (type) {
         case WS_EVT_CONNECT:
+            TRACE_INSTANT("ws.connect", static_cast<int32_t>(client->id()));
             handleConnect(client);
             break;
         case WS_EVT_DISCONNECT:
+            TRACE_INSTANT("ws.disconnect", static_cast<int32_t>(client->id()));
             handleDisconnect(client);
             break;
         case WS_EVT_DATA: {
@@ -52,14 +69,22 @@ void WsServer::handleConnect(AsyncWebSocketClient *client) {
     LOGI("ws", "Client #%u connected from %s", client->id(), client->remoteIP().toString().c_str());
     
     // Send welcome message
-    JsonDocument doc;
-    doc["type"] = "hello";
-    doc["message"] = "Connected to ESP32-S3 Smart Vitrine";
-    doc["clientId"] = client->id();
-    
-    String output;
-    serializeJson(doc, output);
-    client->text(output);
+    {
+        PooledJsonDocument doc;
+        doc["type"] = "hello";
+        doc["message"] = "Connected to ESP32-S3 Smart Vitrine";
+        doc["clientId"] = client->id();
+
+        PooledJsonBuffer output;
+        if (output.serialize(doc)) {
+            s_msgOut.inc();
+            client->text(output.c_str(), output.length());
+        }
+    }
+
+    if (connectHandler) {
+        connectHandler(connectCtx, client);
+    }
 }
 
 void WsServer::handleDisconnect(AsyncWebSocketClient *client) {
@@ -73,37 +98,43 @@ void WsServer::handleTextMessage(AsyncWebSocketClient *client, uint8_t *data, si
     }
 
     if (len > 1024) {
+        s_msgDropped.inc();
         LOGW("ws", "Dropping oversized message from #%u (%u bytes)", client->id(), static_cast<unsigned>(len));
         return;
     }
 
+    s_msgIn.inc();
+    TRACE_SCOPE("ws.message", static_cast<int32_t>(len));
     char buf[1025];
     memcpy(buf, data, len);
     buf[len] = '\0';
 
     LOGD("ws", "Received from #%u: %s", client->id(), buf);
     
-    // Parse incoming message
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, buf);
-    
-    if (error) {
-        LOGW("ws", "JSON parse error: %s", error.c_str());
-        return;
-    }
-    
-    const char* type = doc["type"];
-    
-    // Handle ping message
-    if (type && strcmp(type, "ping") == 0) {
-        JsonDocument response;
-        response["type"] = "pong";
-        response["timestamp"] = millis();
-        
-        String output;
-        serializeJson(response, output);
-        client->text(output);
-        return;
+    // Parse incoming message (the document goes back to the pool before the app parses its own)
+    {
+        PooledJsonDocument doc;
+        DeserializationError error = deserializeJson(doc, buf, len);
+
+        if (error) {
+            LOGW("ws", "JSON parse error: %s", error.c_str());
+            return;
+        }
+
+        const char* type = doc["type"];
+
+        // Handle ping message
+        if (type && strcmp(type, "ping") == 0) {
+            PooledJsonDocument response;
+            response["type"] = "pong";
+            response["timestamp"] = millis();
+
+            PooledJsonBuffer output;
+            if (output.serialize(response)) {
+                client->text(output.c_str(), output.length());
+            }
+            return;
+        }
     }
 
     // Delegate other messages to the application
@@ -113,9 +144,29 @@ void WsServer::handleTextMessage(AsyncWebSocketClient *client, uint8_t *data, si
 }
 
 void WsServer::broadcastMessage(const char *message) {
+    s_msgOut.inc(ws.count());
     ws.textAll(message);
 }
 
+bool WsServer::sendTo(uint32_t clientId, const char *message) {
+    AsyncWebSocketClient *client = ws.client(clientId);
+    if (!client || client->status() != WS_CONNECTED) {
+        return false;
+    }
+    if (!client->canSend()) {
+        s_msgDropped.inc();
+        return false;
+    }
+    s_msgOut.inc();
+    client->text(message);
+    return true;
+}
+
+bool WsServer::hasClient(uint32_t clientId) {
+    AsyncWebSocketClient *client = ws.client(clientId);
+    return client && client->status() == WS_CONNECTED;
+}
+
 void WsServer::closeAll() {
     ws.closeAll();
 }
@@ -5,16 +5,22 @@
 class WsServer {
 public:
     using TextMessageHandler = void (*)(void* ctx, AsyncWebSocketClient* client, const char* message, size_t len);
+    using ConnectHandler = void (*)(void* ctx, AsyncWebSocketClient* client);
 
     WsServer();
     
     void begin(AsyncWebServer *server);
     void setTextMessageHandler(void* ctx, TextMessageHandler handler);
+    // Called after the "hello" for every accepted client (e.g. to send a state snapshot)
+    void setConnectHandler(void* ctx, ConnectHandler handler);
 
     void handleEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
                      AwsEventType type, void *arg, uint8_t *data, size_t len);
     
     void broadcastMessage(const char *message);
+    // Any task: false when the client is gone or its send queue is full
+    bool sendTo(uint32_t clientId, const char *message);
+    bool hasClient(uint32_t clientId);
     void closeAll();
     bool hasClients() const;
 
@@ -23,6 +29,9 @@ private:
 
     void* msgCtx = nullptr;
     TextMessageHandler msgHandler = nullptr;
+
+    void* connectCtx = nullptr;
+    ConnectHandler connectHandler = nullptr;
     
     void handleConnect(AsyncWebSocketClient *client);
     void handleDisconnect(AsyncWebSocketClient *client);
@@ -0,0 +1,222 @@
+#include "WsStateModel.h"
+
+#include <esp_system.h>
+#include <stdarg.h>
+
+#include "WsServer.h"
+#include "hardware/LedMovementControl.h"
+#include "hardware/ModeManager.h"
+#include "util/Log.h"
+
+namespace {
+constexpr uint32_t kSampleIntervalMs = 50;
+constexpr size_t kMsgBufSize = 192;
+
+// Appends one member of "changes": fmtFirst right after the opening brace, fmtNext (with its
+// leading comma) otherwise. len becomes outSize once the output no longer fits.
+void appendChange(char* out, size_t outSize, size_t& len, const char* fmtFirst, const char* fmtNext, ...) {
+    if (len >= outSize) {
+        return;
+    }
+    const bool first = out[len - 1] == '{';
+    va_list args;
+    va_start(args, fmtNext);
+    const int n = vsnprintf(out + len, outSize - len, first ? fmtFirst : fmtNext, args);
+    va_end(args);
+    len = (n > 0) ? len + static_cast<size_t>(n) : outSize;
+}
+} // namespace
+
+void WsStateModel::begin(WsServer* wsServerIn, ModeManager* modeManagerIn, LedMovementControl* ledMovementControlIn) {
+    wsServer = wsServerIn;
+    modeManager = modeManagerIn;
+    ledMovementControl = ledMovementControlIn;
+
+    // Changes on every boot so clients never replay revisions from a previous run
+    epoch = esp_random();
+
+    State s;
+    sample(s);
+    portENTER_CRITICAL(&mux);
+    current = s;
+    rev = 1;
+    portEXIT_CRITICAL(&mux);
+
+    started = true;
+}
+
+const char* WsStateModel::ledModeName(LedMode mode) {
+    switch (mode) {
+        case LedMode::Focus: return "focus";
+        case LedMode::Standby: return "standby";
+        case LedMode::All: return "all";
+        case LedMode::Random: return "random";
+    }
+    return "focus";
+}
+
+void WsStateModel::sample(State& out) {
+    out.focus = modeManager ? modeManager->getLastMiniatureIndex() : 0;
+    out.brightness = modeManager ? modeManager->getLedBrightnessPercent() : 0;
+    out.sleep = modeManager ? modeManager->isSleeping() : false;
+
+    out.led = LedMode::Focus;
+    if (ledMovementControl) {
+        const char* ambient = ledMovementControl->getAmbientName();
+        if (strcmp(ambient, "all") == 0) {
+            out.led = LedMode::All;
+        } else if (strcmp(ambient, "random") == 0) {
+            out.led = LedMode::Random;
+        } else if (ledMovementControl->getIsStandbyLight()) {
+            out.led = LedMode::Standby;
+        }
+    }
+}
+
+void WsStateModel::tick() {
+    if (!started) {
+        return;
+    }
+
+    const uint32_t now = millis();
+    if (now - lastSampleMs < kSampleIntervalMs) {
+        return;
+    }
+    lastSampleMs = now;
+
+    State s;
+    sample(s);
+
+    uint8_t fields = 0;
+    if (s.focus != current.focus) fields |= FieldFocus;
+    if (s.led != current.led) fields |= FieldLed;
+    if (s.brightness != current.brightness) fields |= FieldBrightness;
+    if (s.sleep != current.sleep) fields |= FieldSleep;
+    if (fields == 0) {
+        return;
+    }
+
+    Delta d;
+    portENTER_CRITICAL(&mux);
+    current = s;
+    d.rev = ++rev;
+    d.fields = fields;
+    d.state = s;
+    ring[ringHead] = d;
+    ringHead = (ringHead + 1) % kRingLen;
+    if (ringCount < kRingLen) {
+        ringCount++;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    if (!wsServer || !wsServer->hasClients()) {
+        return;
+    }
+
+    char buf[kMsgBufSize];
+    if (formatDelta(buf, sizeof(buf), d) > 0) {
+        wsServer->broadcastMessage(buf);
+    }
+}
+
+size_t WsStateModel::formatSnapshot(char* out, size_t outSize, uint32_t atRev, const State& s) const {
+    const int n = snprintf(out, outSize,
+                           "{\"type\":\"snapshot\",\"epoch\":%lu,\"rev\":%lu,\"state\":"
+                           "{\"focus\":%d,\"led\":\"%s\",\"brightness\":%u,\"sleep\":%s}}",
+                           (unsigned long)epoch, (unsigned long)atRev,
+                           s.focus, ledModeName(s.led), s.brightness, s.sleep ? "true" : "false");
+    return (n > 0 && static_cast<size_t>(n) < outSize) ? static_cast<size_t>(n) : 0;
+}
+
+size_t WsStateModel::formatDelta(char* out, size_t outSize, const Delta& d) const {
+    const int n = snprintf(out, outSize, "{\"type\":\"delta\",\"epoch\":%lu,\"rev\":%lu,\"changes\":{",
+                           (unsigned long)epoch, (unsigned long)d.rev);
+    size_t len = (n > 0) ? static_cast<size_t>(n) : outSize;
+
+    if (d.fields & FieldFocus) {
+        appendChange(out, outSize, len, "\"focus\":%d", ",\"focus\":%d", static_cast<int>(d.state.focus));
+    }
+    if (d.fields & FieldLed) {
+        appendChange(out, outSize, len, "\"led\":\"%s\"", ",\"led\":\"%s\"", ledModeName(d.state.led));
+    }
+    if (d.fields & FieldBrightness) {
+        appendChange(out, outSize, len, "\"brightness\":%u", ",\"brightness\":%u",
+                     static_cast<unsigned>(d.state.brightness));
+    }
+    if (d.fields & FieldSleep) {
+        appendChange(out, outSize, len, "\"sleep\":%s", ",\"sleep\":%s", d.state.sleep ? "true" : "false");
+    }
+
+    if (len + 3 > outSize) {
+        return 0;
+    }
+    out[len++] = '}';
+    out[len++] = '}';
+    out[len] = '\0';
+    return len;
+}
+
+void WsStateModel::sendSnapshot(AsyncWebSocketClient* client) {
+    if (!started || !client) {
+        return;
+    }
+
+    State s;
+    uint32_t atRev;
+    portENTER_CRITICAL(&mux);
+    s = current;
+    atRev = rev;
+    portEXIT_CRITICAL(&mux);
+
+    char buf[kMsgBufSize];
+    if (formatSnapshot(buf, sizeof(buf), atRev, s) > 0) {
+        client->text(buf);
+    }
+}
+
+void WsStateModel::handleSync(AsyncWebSocketClient* client, uint32_t clientEpoch, uint32_t sinceRev) {
+    if (!started || !client) {
+        return;
+    }
+
+    // Copy the missed deltas out under the lock; format/send without it
+    Delta missed[kRingLen];
+    size_t missedCount = 0;
+    bool needSnapshot = false;
+    uint32_t atRev;
+
+    portENTER_CRITICAL(&mux);
+    atRev = rev;
+    if (clientEpoch != epoch || sinceRev > rev) {
+        needSnapshot = true;
+    } else if (sinceRev < rev) {
+        const uint32_t oldest = ringCount ? ring[(ringHead + kRingLen - ringCount) % kRingLen].rev : rev + 1;
+        if (sinceRev + 1 < oldest) {
+            needSnapshot = true; // gap: fell out of the ring
+        } else {
+            for (size_t i = 0; i < ringCount; i++) {
+                const Delta& d = ring[(ringHead + kRingLen - ringCount + i) % kRingLen];
+                if (d.rev > sinceRev) {
+                    missed[missedCount++] = d;
+                }
+            }
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+
+    if (needSnapshot) {
+        sendSnapshot(client);
+        return;
+    }
+
+    char buf[kMsgBufSize];
+    for (size_t i = 0; i < missedCount; i++) {
+        if (formatDelta(buf, sizeof(buf), missed[i]) > 0) {
+            client->text(buf);
+        }
+    }
+
+    snprintf(buf, sizeof(buf), "{\"type\":\"synced\",\"epoch\":%lu,\"rev\":%lu,\"replayed\":%u}",
+             (unsigned long)epoch, (unsigned long)atRev, static_cast<unsigned>(missedCount));
+    client->text(buf);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+
+class WsServer;
+class ModeManager;
+class LedMovementControl;
+
+// Versioned device state for WebSocket clients.
+// - Every change bumps a monotonically increasing revision and is kept in a small ring.
+// - New clients get one snapshot; afterwards only deltas (tagged with their rev) are broadcast.
+// - A reconnecting client sends {"type":"sync","epoch":E,"since":N} and gets just the missed
+//   deltas, or a fresh snapshot if N fell out of the ring or the device rebooted (epoch changed).
+class WsStateModel {
+public:
+    void begin(WsServer* wsServer, ModeManager* modeManager, LedMovementControl* ledMovementControl);
+
+    // Call from loop(): samples state and broadcasts a delta when something changed
+    void tick();
+
+    // AsyncTCP task
+    void sendSnapshot(AsyncWebSocketClient* client);
+    void handleSync(AsyncWebSocketClient* client, uint32_t epoch, uint32_t sinceRev);
+
+    uint32_t getRevision() const { return rev; }
+
+private:
+    enum class LedMode : uint8_t { Focus, Standby, All, Random };
+
+    enum Field : uint8_t {
+        FieldFocus = 1 << 0,
+        FieldLed = 1 << 1,
+        FieldBrightness = 1 << 2,
+        FieldSleep = 1 << 3,
+    };
+
+    struct State {
+        int16_t focus;
+        LedMode led;
+        uint8_t brightness;
+        bool sleep;
+    };
+
+    struct Delta {
+        uint32_t rev;
+        uint8_t fields;
+        State state;
+    };
+
+    static constexpr size_t kRingLen = 32;
+
+    void sample(State& out);
+    size_t formatSnapshot(char* out, size_t outSize, uint32_t atRev, const State& s) const;
+    size_t formatDelta(char* out, size_t outSize, const Delta& d) const;
+    static const char* ledModeName(LedMode mode);
+
+    WsServer* wsServer = nullptr;
+    ModeManager* modeManager = nullptr;
+    LedMovementControl* ledMovementControl = nullptr;
+    std::atomic<bool> started{false};
+
+    uint32_t epoch = 0;
+    uint32_t lastSampleMs = 0;
+
+    // Guarded by mux (written by loop(), read by the AsyncTCP task)
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t rev = 0;
+    State current = {};
+    Delta ring[kRingLen] = {};
+    uint8_t ringHead = 0;  // next write slot
+    uint8_t ringCount = 0;
+};
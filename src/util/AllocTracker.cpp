@@ -0,0 +1,230 @@
+#include "AllocTracker.h"
+
+#if HEAP_TRACKER
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+namespace {
+constexpr size_t kLiveMask = AllocTracker::kMaxLive - 1;
+static_assert((AllocTracker::kMaxLive & kLiveMask) == 0, "kMaxLive must be a power of two");
+static_assert(AllocTracker::kSiteDepth == 3, "CAPTURE_SITE records three callers");
+// Open addressing degrades badly when nearly full
+constexpr uint32_t kMaxLoad = AllocTracker::kMaxLive * 3 / 4;
+
+struct LiveBlock {
+    void* ptr;  // nullptr: empty slot
+    uint32_t size;
+    uint8_t site;
+};
+
+// Everything is zero-initialized before the first allocation: no constructors involved
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+AllocTracker::Site s_sites[AllocTracker::kMaxSites];
+size_t s_siteCount = 0;
+LiveBlock s_live[AllocTracker::kMaxLive];
+uint32_t s_liveCount = 0;
+uint32_t s_untracked = 0;
+
+// Return addresses carry the caller's window size in the top two bits (windowed ABI);
+// -3 points at the call instruction, which is what addr2line should resolve.
+inline uint32_t callPc(void* ra) {
+    const uint32_t a = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ra));
+    return a ? ((a & 0x3fffffff) | 0x40000000) - 3 : 0;
+}
+
+// Must expand inside the wrapper itself: level 0 is the code that called malloc()
+#define CAPTURE_SITE(PCS)                                   \
+    uint32_t PCS[AllocTracker::kSiteDepth];                 \
+    PCS[0] = callPc(__builtin_return_address(0));           \
+    PCS[1] = callPc(__builtin_return_address(1));           \
+    PCS[2] = callPc(__builtin_return_address(2))
+
+size_t homeSlot(const void* ptr) {
+    return ((static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ptr)) >> 3) * 2654435761u) & kLiveMask;
+}
+
+// Caller holds s_mux
+uint8_t siteFor(const uint32_t* pcs) {
+    for (size_t i = 0; i < s_siteCount; i++) {
+        if (memcmp(s_sites[i].pcs, pcs, sizeof(s_sites[i].pcs)) == 0) {
+            return static_cast<uint8_t>(i);
+        }
+    }
+    if (s_siteCount < AllocTracker::kMaxSites - 1) {
+        memcpy(s_sites[s_siteCount].pcs, pcs, sizeof(s_sites[s_siteCount].pcs));
+        return static_cast<uint8_t>(s_siteCount++);
+    }
+    // Out of sites: the rest share the last one (all-zero PCs)
+    s_siteCount = AllocTracker::kMaxSites;
+    return AllocTracker::kMaxSites - 1;
+}
+
+void track(void* ptr, size_t size, const uint32_t* pcs) {
+    portENTER_CRITICAL(&s_mux);
+    const uint8_t site = siteFor(pcs);
+    s_sites[site].allocs++;
+    if (s_liveCount >= kMaxLoad) {
+        s_untracked++;
+    } else {
+        size_t i = homeSlot(ptr);
+        while (s_live[i].ptr) {
+            i = (i + 1) & kLiveMask;
+        }
+        s_live[i].ptr = ptr;
+        s_live[i].size = static_cast<uint32_t>(size);
+        s_live[i].site = site;
+        s_liveCount++;
+        s_sites[site].liveCount++;
+        s_sites[site].liveBytes += static_cast<uint32_t>(size);
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void untrack(void* ptr) {
+    portENTER_CRITICAL(&s_mux);
+    size_t i = homeSlot(ptr);
+    while (s_live[i].ptr && s_live[i].ptr != ptr) {
+        i = (i + 1) & kLiveMask;
+    }
+    if (s_live[i].ptr) {
+        AllocTracker::Site& site = s_sites[s_live[i].site];
+        site.liveCount--;
+        site.liveBytes -= s_live[i].size;
+        s_liveCount--;
+
+        // Backward-shift deletion keeps every probe chain intact without tombstones
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & kLiveMask;
+            if (!s_live[j].ptr) {
+                break;
+            }
+            const size_t k = homeSlot(s_live[j].ptr);
+            const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!stays) {
+                s_live[i] = s_live[j];
+                i = j;
+            }
+        }
+        s_live[i].ptr = nullptr;
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+} // namespace
+
+extern "C" {
+void* __wrap_malloc(size_t size) {
+    void* p = __real_malloc(size);
+    if (p) {
+        CAPTURE_SITE(pcs);
+        track(p, size, pcs);
+    }
+    return p;
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    void* p = __real_calloc(n, size);
+    if (p) {
+        CAPTURE_SITE(pcs);
+        track(p, n * size, pcs);
+    }
+    return p;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    void* p = __real_realloc(ptr, size);
+    // realloc(ptr, 0) frees; a failed realloc leaves ptr allocated
+    if (ptr && (p || size == 0)) {
+        untrack(ptr);
+    }
+    if (p) {
+        CAPTURE_SITE(pcs);
+        track(p, size, pcs);
+    }
+    return p;
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr) {
+        untrack(ptr);
+    }
+    __real_free(ptr);
+}
+}
+
+size_t AllocTracker::getTopSites(Site* out, size_t maxSites) {
+    size_t n = 0;
+    portENTER_CRITICAL(&s_mux);
+    // Insertion into out[], largest live bytes first
+    for (size_t i = 0; i < s_siteCount; i++) {
+        const Site& site = s_sites[i];
+        if (site.liveCount == 0 && site.allocs == 0) {
+            continue;
+        }
+        size_t pos = n;
+        while (pos > 0 && out[pos - 1].liveBytes < site.liveBytes) {
+            pos--;
+        }
+        if (pos >= maxSites) {
+            continue;
+        }
+        const size_t last = (n < maxSites) ? n : maxSites - 1;
+        for (size_t k = last; k > pos; k--) {
+            out[k] = out[k - 1];
+        }
+        out[pos] = site;
+        if (n < maxSites) {
+            n++;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return n;
+}
+
+uint32_t AllocTracker::getLiveCount() {
+    portENTER_CRITICAL(&s_mux);
+    const uint32_t n = s_liveCount;
+    portEXIT_CRITICAL(&s_mux);
+    return n;
+}
+
+uint32_t AllocTracker::getUntracked() {
+    portENTER_CRITICAL(&s_mux);
+    const uint32_t n = s_untracked;
+    portEXIT_CRITICAL(&s_mux);
+    return n;
+}
+
+void AllocTracker::resetCounts() {
+    portENTER_CRITICAL(&s_mux);
+    for (size_t i = 0; i < s_siteCount; i++) {
+        s_sites[i].allocs = 0;
+    }
+    s_untracked = 0;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+#else
+
+size_t AllocTracker::getTopSites(Site* out, size_t maxSites) {
+    (void)out;
+    (void)maxSites;
+    return 0;
+}
+
+uint32_t AllocTracker::getLiveCount() {
+    return 0;
+}
+
+uint32_t AllocTracker::getUntracked() {
+    return 0;
+}
+
+void AllocTracker::resetCounts() {}
+
+#endif
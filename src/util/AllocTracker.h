@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Debug build only: -DHEAP_TRACKER=1 plus the linker wraps
+//   -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc -Wl,--wrap=free
+// (see the *_heaptrack environment in platformio.ini).
+#ifndef HEAP_TRACKER
+#define HEAP_TRACKER 0
+#endif
+
+// Live heap allocations aggregated by call site.
+// - Every malloc/calloc/realloc/free (C++ new, String, ArduinoJson included) goes through a
+//   wrapper that records the block in a fixed table, keyed by its caller's return addresses.
+// - A site is the last kSiteDepth callers above the allocator; decode the PCs with
+//   xtensa-esp32s3-elf-addr2line -pfiaC -e firmware.elf <pc>...
+// - Sites whose live bytes keep growing between two reads are the leaks.
+// - Blocks allocated while the table is full are counted as untracked; allocations made
+//   directly through heap_caps_malloc() are not seen.
+// The tables live in static RAM (~26 KB); nothing here allocates.
+class AllocTracker {
+public:
+    static constexpr size_t kSiteDepth = 3;
+    static constexpr size_t kMaxSites = 64;
+    static constexpr size_t kMaxLive = 2048;
+
+    struct Site {
+        uint32_t pcs[kSiteDepth];  // 0 past the top of the stack
+        uint32_t liveCount;
+        uint32_t liveBytes;
+        uint32_t allocs;  // since boot or the last resetCounts()
+    };
+
+    static bool isCompiled() { return HEAP_TRACKER != 0; }
+
+    // Sites by live bytes, largest first; returns how many were copied
+    static size_t getTopSites(Site* out, size_t maxSites);
+    static uint32_t getLiveCount();
+    static uint32_t getUntracked();
+    // Zeroes the per-site allocation counters (live blocks stay tracked)
+    static void resetCounts();
+};
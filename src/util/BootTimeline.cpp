@@ -0,0 +1,13 @@
+#include "BootTimeline.h"
+#include "Log.h"
+
+BootTimeline::Stage::Stage(const char* name) : name(name), startMs(millis()) {}
+
+BootTimeline::Stage::~Stage() {
+    const uint32_t now = millis();
+    LOGI("boot", "%s: %u ms (t=%u ms)", name, static_cast<unsigned>(now - startMs), static_cast<unsigned>(now));
+}
+
+void BootTimeline::milestone(const char* name) {
+    LOGI("boot", "== %s (t=%u ms)", name, static_cast<unsigned>(millis()));
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Boot timeline logging.
+// Stages are timed with a scoped object and logged as "<stage>: <n> ms (t=<ms since reset>)".
+// Safe to use from the setup() task and from background boot tasks.
+class BootTimeline {
+public:
+    class Stage {
+    public:
+        explicit Stage(const char* name);
+        ~Stage();
+
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+    private:
+        const char* name;
+        uint32_t startMs;
+    };
+
+    // Log a point-in-time milestone (e.g. "first miniature shown")
+    static void milestone(const char* name);
+};
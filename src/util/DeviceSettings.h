@@ -7,6 +7,11 @@
 static constexpr size_t WIFI_SSID_MAX_LEN = 32;
 static constexpr size_t WIFI_PASS_MAX_LEN = 64;
 
+// MQTT broker settings
+static constexpr size_t MQTT_HOST_MAX_LEN = 63;
+static constexpr size_t MQTT_USER_MAX_LEN = 32;
+static constexpr size_t MQTT_PASS_MAX_LEN = 64;
+
 struct DeviceSettings {
     // 0 == disabled
     uint16_t sleepTimeoutMinutes = 5;
@@ -42,6 +47,16 @@ struct DeviceSettings {
 
     char wifiApSsid[WIFI_SSID_MAX_LEN + 1] = "Vitrine-ESP32S3";
     char wifiApPass[WIFI_PASS_MAX_LEN + 1] = "vitrine1234";
+
+    // 1..20: max delta rate of the /api/events SSE stream
+    uint8_t eventsMaxRateHz = 4;
+
+    // MQTT / Home Assistant (disabled until a broker is configured)
+    bool mqttEnabled = false;
+    char mqttHost[MQTT_HOST_MAX_LEN + 1] = {0};
+    uint16_t mqttPort = 1883;
+    char mqttUser[MQTT_USER_MAX_LEN + 1] = {0};
+    char mqttPass[MQTT_PASS_MAX_LEN + 1] = {0};
 };
 
 #endif
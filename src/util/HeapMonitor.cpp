@@ -0,0 +1,166 @@
+#include "HeapMonitor.h"
+
+#include <esp_heap_caps.h>
+
+#include "Log.h"
+#include "Metrics.h"
+
+namespace {
+constexpr uint32_t kTaskStackBytes = 3072;
+constexpr UBaseType_t kTaskPriority = 1;
+
+const uint32_t kCapsFlags[HeapMonitor::CapsCount] = {MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM};
+const char* const kCapsNames[HeapMonitor::CapsCount] = {"internal", "psram"};
+
+MetricGauge s_free[HeapMonitor::CapsCount] = {
+    {"vitrine_heap_free_bytes", "Free heap", "caps=\"internal\""},
+    {"vitrine_heap_free_bytes", "Free heap", "caps=\"psram\""}};
+MetricGauge s_min[HeapMonitor::CapsCount] = {
+    {"vitrine_heap_min_free_bytes", "Lowest free heap since boot", "caps=\"internal\""},
+    {"vitrine_heap_min_free_bytes", "Lowest free heap since boot", "caps=\"psram\""}};
+MetricGauge s_largest[HeapMonitor::CapsCount] = {
+    {"vitrine_heap_largest_free_block_bytes", "Largest allocatable block", "caps=\"internal\""},
+    {"vitrine_heap_largest_free_block_bytes", "Largest allocatable block", "caps=\"psram\""}};
+MetricGauge s_minLargest[HeapMonitor::CapsCount] = {
+    {"vitrine_heap_min_largest_free_block_bytes", "Smallest largest-block sampled since boot", "caps=\"internal\""},
+    {"vitrine_heap_min_largest_free_block_bytes", "Smallest largest-block sampled since boot", "caps=\"psram\""}};
+MetricGauge s_frag[HeapMonitor::CapsCount] = {
+    {"vitrine_heap_fragmentation_percent", "100 * (1 - largest block / free)", "caps=\"internal\""},
+    {"vitrine_heap_fragmentation_percent", "100 * (1 - largest block / free)", "caps=\"psram\""}};
+
+portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+bool s_sampled = false;
+HeapMonitor::Snapshot s_snap[HeapMonitor::CapsCount];
+
+// Lows of the current history window, then the ring of finished windows
+HeapMonitor::HistoryPoint s_window;
+uint32_t s_windowStartMs = 0;
+HeapMonitor::HistoryPoint s_history[HeapMonitor::kHistory];
+size_t s_historyHead = 0;  // next write slot
+size_t s_historyCount = 0;
+
+uint32_t s_lastWarnMs = 0;
+bool s_warned = false;
+
+uint8_t fragPercent(uint32_t freeBytes, uint32_t largest) {
+    if (freeBytes == 0 || largest >= freeBytes) {
+        return 0;
+    }
+    return static_cast<uint8_t>(100 - static_cast<uint64_t>(largest) * 100 / freeBytes);
+}
+
+void startWindow(uint32_t now) {
+    s_windowStartMs = now;
+    for (size_t c = 0; c < HeapMonitor::CapsCount; c++) {
+        s_window.minFreeBytes[c] = UINT32_MAX;
+        s_window.minLargestBlock[c] = UINT32_MAX;
+    }
+}
+
+void monitorTask(void* arg) {
+    (void)arg;
+    for (;;) {
+        HeapMonitor::sample();
+        vTaskDelay(pdMS_TO_TICKS(HeapMonitor::kSampleIntervalMs));
+    }
+}
+} // namespace
+
+void HeapMonitor::begin() {
+    sample();
+    xTaskCreate(monitorTask, "heapMon", kTaskStackBytes, nullptr, kTaskPriority, nullptr);
+}
+
+void HeapMonitor::sample() {
+    // The heap calls walk the heap metadata: keep them outside the critical section
+    uint32_t freeBytes[CapsCount];
+    uint32_t largest[CapsCount];
+    uint32_t minFree[CapsCount];
+    for (size_t c = 0; c < CapsCount; c++) {
+        freeBytes[c] = heap_caps_get_free_size(kCapsFlags[c]);
+        largest[c] = heap_caps_get_largest_free_block(kCapsFlags[c]);
+        minFree[c] = heap_caps_get_minimum_free_size(kCapsFlags[c]);
+    }
+    const uint32_t now = millis();
+
+    portENTER_CRITICAL(&s_mux);
+    if (!s_sampled) {
+        s_sampled = true;
+        for (Snapshot& snap : s_snap) {
+            snap.minLargestBlock = UINT32_MAX;
+            snap.maxFragPercent = 0;
+        }
+        startWindow(now);
+    }
+    for (size_t c = 0; c < CapsCount; c++) {
+        Snapshot& snap = s_snap[c];
+        snap.freeBytes = freeBytes[c];
+        snap.largestBlock = largest[c];
+        snap.minFreeBytes = minFree[c];
+        snap.minLargestBlock = min(snap.minLargestBlock, largest[c]);
+        snap.fragPercent = fragPercent(freeBytes[c], largest[c]);
+        snap.maxFragPercent = max(snap.maxFragPercent, snap.fragPercent);
+
+        s_window.minFreeBytes[c] = min(s_window.minFreeBytes[c], freeBytes[c]);
+        s_window.minLargestBlock[c] = min(s_window.minLargestBlock[c], largest[c]);
+    }
+    if (now - s_windowStartMs >= kHistoryIntervalMs) {
+        s_window.atS = now / 1000;
+        s_history[s_historyHead] = s_window;
+        s_historyHead = (s_historyHead + 1) % kHistory;
+        if (s_historyCount < kHistory) {
+            s_historyCount++;
+        }
+        startWindow(now);
+    }
+    Snapshot snaps[CapsCount];
+    memcpy(snaps, s_snap, sizeof(snaps));
+    portEXIT_CRITICAL(&s_mux);
+
+    for (size_t c = 0; c < CapsCount; c++) {
+        const Snapshot& snap = snaps[c];
+        s_free[c].set(static_cast<int32_t>(snap.freeBytes));
+        s_min[c].set(static_cast<int32_t>(snap.minFreeBytes));
+        s_largest[c].set(static_cast<int32_t>(snap.largestBlock));
+        s_minLargest[c].set(static_cast<int32_t>(snap.minLargestBlock));
+        s_frag[c].set(snap.fragPercent);
+    }
+
+    // PSRAM only holds caches and large buffers: the internal heap is the one that hurts
+    const Snapshot& internal = snaps[Internal];
+    const bool fragmented = internal.fragPercent >= kFragWarnPercent;
+    const bool lowBlock = internal.largestBlock < kLowBlockBytes;
+    if ((fragmented || lowBlock) && (!s_warned || now - s_lastWarnMs >= kWarnIntervalMs)) {
+        s_warned = true;
+        s_lastWarnMs = now;
+        LOGW("heap", "Internal heap %s: free %lu, largest block %lu (%u%% fragmented), min free %lu",
+             lowBlock ? "low" : "fragmented", (unsigned long)internal.freeBytes, (unsigned long)internal.largestBlock,
+             static_cast<unsigned>(internal.fragPercent), (unsigned long)internal.minFreeBytes);
+    }
+}
+
+const char* HeapMonitor::capsName(size_t caps) {
+    return caps < CapsCount ? kCapsNames[caps] : "?";
+}
+
+bool HeapMonitor::get(size_t caps, Snapshot& out) {
+    if (caps >= CapsCount) {
+        return false;
+    }
+    portENTER_CRITICAL(&s_mux);
+    const bool sampled = s_sampled;
+    out = s_snap[caps];
+    portEXIT_CRITICAL(&s_mux);
+    return sampled;
+}
+
+size_t HeapMonitor::getHistory(HistoryPoint* out, size_t maxPoints) {
+    portENTER_CRITICAL(&s_mux);
+    const size_t n = (s_historyCount < maxPoints) ? s_historyCount : maxPoints;
+    // The newest n, oldest first
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_history[(s_historyHead + kHistory - n + i) % kHistory];
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return n;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Heap telemetry for internal RAM and PSRAM.
+// - A low-priority task samples free bytes, the largest free block and the fragmentation
+//   ratio (1 - largest/free) every kSampleIntervalMs and publishes them as metrics.
+// - Every kHistoryIntervalMs the lowest values seen in that window go into a ring
+//   (kHistory entries, ~24 h): a slow leak shows up as a falling minimum long before an OOM.
+// - Fragmentation over kFragWarnPercent or an internal largest block under kLowBlockBytes
+//   logs a WARN (kept in the persistent log), at most every kWarnIntervalMs.
+class HeapMonitor {
+public:
+    static constexpr uint32_t kSampleIntervalMs = 10 * 1000;
+    static constexpr uint32_t kHistoryIntervalMs = 30 * 60 * 1000;
+    static constexpr size_t kHistory = 48;
+    static constexpr uint8_t kFragWarnPercent = 60;
+    static constexpr uint32_t kLowBlockBytes = 8 * 1024;
+    static constexpr uint32_t kWarnIntervalMs = 10 * 60 * 1000;
+
+    enum Caps : uint8_t { Internal, Psram, CapsCount };
+
+    struct Snapshot {
+        uint32_t freeBytes;
+        uint32_t largestBlock;
+        uint32_t minFreeBytes;     // heap low-water mark since boot
+        uint32_t minLargestBlock;  // smallest "largest block" sampled since boot
+        uint8_t fragPercent;
+        uint8_t maxFragPercent;    // highest sampled since boot
+    };
+
+    struct HistoryPoint {
+        uint32_t atS;  // seconds since boot at the end of the window
+        uint32_t minFreeBytes[CapsCount];
+        uint32_t minLargestBlock[CapsCount];
+    };
+
+    // Starts the sampling task
+    static void begin();
+    // Takes a sample now (also called when /api/metrics is scraped)
+    static void sample();
+
+    static const char* capsName(size_t caps);
+    static bool get(size_t caps, Snapshot& out);
+    // Oldest first; returns how many were copied
+    static size_t getHistory(HistoryPoint* out, size_t maxPoints);
+};
@@ -0,0 +1,63 @@
+#include "JsonEscape.h"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace json_escape {
+
+namespace {
+// Escapes s into out until it runs out of input or space; returns bytes written and sets
+// complete when all of s went in. Always leaves room for the NUL.
+size_t write(char* out, size_t outSize, const char* s, size_t n, bool& complete) {
+    size_t pos = 0;
+    complete = false;
+    if (outSize == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t c = static_cast<uint8_t>(s[i]);
+        if (c == '"' || c == '\\') {
+            if (pos + 2 >= outSize) {
+                out[pos] = '\0';
+                return pos;
+            }
+            out[pos++] = '\\';
+            out[pos++] = static_cast<char>(c);
+        } else if (c < 0x20) {
+            if (pos + 6 >= outSize) {
+                out[pos] = '\0';
+                return pos;
+            }
+            pos += snprintf(out + pos, outSize - pos, "\\u%04x", c);
+        } else {
+            if (pos + 1 >= outSize) {
+                out[pos] = '\0';
+                return pos;
+            }
+            out[pos++] = static_cast<char>(c);
+        }
+    }
+    out[pos] = '\0';
+    complete = true;
+    return pos;
+}
+} // namespace
+
+size_t escape(char* out, size_t outSize, const char* s, size_t n) {
+    bool complete;
+    const size_t len = write(out, outSize, s, n, complete);
+    if (!complete) {
+        if (outSize > 0) {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    return len;
+}
+
+size_t escapeTruncated(char* out, size_t outSize, const char* s, size_t n) {
+    bool complete;
+    return write(out, outSize, s, n, complete);
+}
+
+} // namespace json_escape
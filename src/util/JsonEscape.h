@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// Bounded JSON string escaping for text built into fixed buffers (log lines, file names,
+// error strings). " and \ are backslash-escaped and control characters become \u00XX;
+// everything else, UTF-8 included, is copied as is. No quotes are added.
+namespace json_escape {
+
+// Writes the n bytes at s, escaped, NUL-terminated (outSize > 0). Returns the bytes written
+// (without the NUL), or 0 when the escaped text plus NUL doesn't fit (out is then "").
+size_t escape(char* out, size_t outSize, const char* s, size_t n);
+
+// Same, but stops before the first character that doesn't fit instead of failing
+size_t escapeTruncated(char* out, size_t outSize, const char* s, size_t n);
+
+} // namespace json_escape
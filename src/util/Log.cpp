@@ -1,13 +1,297 @@
-#include "log.h"
+#include "Log.h"
+#include "LogRing.h"
+#include "PersistentLog.h"
+
+#include <atomic>
+#include <cstring>
+
+#if LOG_BINARY
+#include <esp_ota_ops.h>
+#endif
+
+namespace {
+// In binary mode only direct Log::info() & co. calls produce text
+constexpr size_t kRingSlots = LOG_BINARY ? 8 : 64;
+constexpr size_t kLineBytes = 200;   // whole line: prefix + message + CRLF
+constexpr uint32_t kDrainIdleMs = 10;
+constexpr uint32_t kDrainStackBytes = 4096;  // also writes the persistent log to LittleFS
+constexpr UBaseType_t kDrainPriority = 1;  // just above idle
+
+LogRing<kRingSlots, kLineBytes> s_ring;
+std::atomic<uint32_t> s_dropped{0};
+std::atomic<bool> s_async{false};
+
+void *s_sinkCtx = nullptr;
+std::atomic<Log::LineSink> s_sink{nullptr};
+
+// Tag registry. Entries are filled under the spinlock and published by bumping s_tagCount;
+// level bytes are written under the lock and read lock-free by the call sites.
+struct TagEntry {
+    char name[LogTags::kMaxNameLen + 1];
+    std::atomic<uint8_t> level;
+    bool overridden;
+};
+TagEntry s_tags[LogTags::kMaxTags];
+std::atomic<size_t> s_tagCount{0};
+uint8_t s_defaultLevel = LOG_DEFAULT_LEVEL + 1;
+std::atomic<uint8_t> s_overflowLevel{LOG_DEFAULT_LEVEL + 1};  // tags past kMaxTags
+portMUX_TYPE s_tagMux = portMUX_INITIALIZER_UNLOCKED;
+
+const char *const kLevelNames[] = {"error", "warn", "info", "debug"};
+
+uint8_t toLevelByte(int level) {
+    if (level > LOG_LEVEL) {
+        level = LOG_LEVEL;
+    }
+    return (level < 0) ? LogTags::kOff : static_cast<uint8_t>(level + 1);
+}
+
+// Caller holds s_tagMux
+TagEntry *findTag(const char *tag, bool create) {
+    const size_t n = s_tagCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+        if (strncmp(s_tags[i].name, tag, LogTags::kMaxNameLen) == 0) {
+            return &s_tags[i];
+        }
+    }
+    if (!create || n == LogTags::kMaxTags) {
+        return nullptr;
+    }
+    TagEntry &e = s_tags[n];
+    strncpy(e.name, tag, LogTags::kMaxNameLen);
+    e.name[LogTags::kMaxNameLen] = '\0';
+    e.level.store(s_defaultLevel, std::memory_order_relaxed);
+    e.overridden = false;
+    s_tagCount.store(n + 1, std::memory_order_release);
+    return &e;
+}
+
+#if LOG_BINARY
+constexpr size_t kBinarySlots = 256;
+constexpr size_t kRecordBytes = 56;
+constexpr size_t kRecordHeaderBytes = 13;
+constexpr uint8_t kLevelTruncated = 0x80;
+
+// On the UART each record is framed as A5 C3 <len> <record>; text lines pass through as-is
+constexpr uint8_t kFrameSync0 = 0xA5;
+constexpr uint8_t kFrameSync1 = 0xC3;
+
+using BinaryRing = LogRing<kBinarySlots, kRecordBytes>;
+BinaryRing s_binRing;
+#endif
+
+bool ringsEmpty() {
+#if LOG_BINARY
+    return s_ring.empty() && s_binRing.empty();
+#else
+    return s_ring.empty();
+#endif
+}
+} // namespace
 
 HardwareSerial *Log::s_serial = nullptr;
 
+std::atomic<uint8_t> *LogTags::levelFor(const char *tag) {
+    if (!tag) {
+        tag = "";
+    }
+    portENTER_CRITICAL(&s_tagMux);
+    TagEntry *e = findTag(tag, true);
+    portEXIT_CRITICAL(&s_tagMux);
+    return e ? &e->level : &s_overflowLevel;
+}
+
+bool LogTags::setLevel(const char *tag, int level) {
+    const uint8_t levelByte = toLevelByte(level);
+    bool ok = true;
+    portENTER_CRITICAL(&s_tagMux);
+    if (!tag || strcmp(tag, "*") == 0) {
+        s_defaultLevel = levelByte;
+        s_overflowLevel.store(levelByte, std::memory_order_relaxed);
+        const size_t n = s_tagCount.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++) {
+            if (!s_tags[i].overridden) {
+                s_tags[i].level.store(levelByte, std::memory_order_relaxed);
+            }
+        }
+    } else if (TagEntry *e = findTag(tag, true)) {
+        e->level.store(levelByte, std::memory_order_relaxed);
+        e->overridden = true;
+    } else {
+        ok = false;
+    }
+    portEXIT_CRITICAL(&s_tagMux);
+    return ok;
+}
+
+void LogTags::clearOverride(const char *tag) {
+    if (!tag) {
+        return;
+    }
+    portENTER_CRITICAL(&s_tagMux);
+    if (TagEntry *e = findTag(tag, false)) {
+        e->level.store(s_defaultLevel, std::memory_order_relaxed);
+        e->overridden = false;
+    }
+    portEXIT_CRITICAL(&s_tagMux);
+}
+
+int LogTags::getDefaultLevel() {
+    portENTER_CRITICAL(&s_tagMux);
+    const uint8_t levelByte = s_defaultLevel;
+    portEXIT_CRITICAL(&s_tagMux);
+    return static_cast<int>(levelByte) - 1;
+}
+
+size_t LogTags::count() {
+    return s_tagCount.load(std::memory_order_acquire);
+}
+
+bool LogTags::get(size_t index, const char *&name, int &level, bool &overridden) {
+    if (index >= count()) {
+        return false;
+    }
+    portENTER_CRITICAL(&s_tagMux);
+    name = s_tags[index].name;  // never changes once published
+    level = static_cast<int>(s_tags[index].level.load(std::memory_order_relaxed)) - 1;
+    overridden = s_tags[index].overridden;
+    portEXIT_CRITICAL(&s_tagMux);
+    return true;
+}
+
+bool LogTags::parseLevel(const char *name, int &level) {
+    if (!name) {
+        return false;
+    }
+    if (strcmp(name, "off") == 0 || strcmp(name, "none") == 0) {
+        level = -1;
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(kLevelNames) / sizeof(kLevelNames[0]); i++) {
+        if (strcmp(name, kLevelNames[i]) == 0) {
+            level = static_cast<int>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *LogTags::levelName(int level) {
+    if (level < 0) {
+        return "off";
+    }
+    return kLevelNames[min(level, 3)];
+}
+
 void Log::begin(HardwareSerial &serial, uint32_t baud) {
     s_serial = &serial;
     s_serial->begin(baud);
 
     // Small delay helps ensure the USB/serial monitor is ready.
     delay(50);
+
+    // Before the drain task exists: it appends WARN+ lines to the persistent batch
+    PersistentLog::begin();
+
+    if (xTaskCreate(drainTask, "logDrain", kDrainStackBytes, nullptr, kDrainPriority, nullptr) == pdPASS) {
+        s_async = true;
+    }
+}
+
+#if LOG_BINARY
+void Log::BinaryRecord::putBytes(const void *src, size_t n) {
+    if (len + n > cap) {
+        truncated = true;
+        len = cap;  // later arguments are dropped too, so the decoder never misparses
+        return;
+    }
+    memcpy(data + len, src, n);
+    len += n;
+}
+
+void Log::BinaryRecord::put(const char *s) {
+    const size_t strLen = s ? strnlen(s, 255) : 0;
+    if (len + 1 >= cap) {
+        // No room even for the length byte
+        truncated = true;
+        len = cap;
+        return;
+    }
+    // Strings may be shortened to fit; the length byte keeps the record parseable
+    const size_t n = min(strLen, cap - len - 1);
+    data[len++] = static_cast<uint8_t>(n);
+    memcpy(data + len, s, n);
+    len += n;
+    if (n < strLen) {
+        truncated = true;
+    }
+}
+
+bool Log::beginRecord(BinaryRecord &rec, LogLevel level, const char *tag, const char *fmt) {
+    if (!s_serial) {
+        return false;
+    }
+    uint32_t ticket;
+    BinaryRing::Slot *slot = s_binRing.claim(ticket);
+    if (!slot) {
+        s_dropped++;
+        return false;
+    }
+    rec.slot = slot;
+    rec.ticket = ticket;
+    rec.data = reinterpret_cast<uint8_t *>(slot->data);
+    rec.cap = sizeof(slot->data);
+    rec.len = kRecordHeaderBytes;
+
+    const uint32_t header[3] = {
+        static_cast<uint32_t>(millis()),
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(fmt)),
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(tag)),
+    };
+    memcpy(rec.data, header, sizeof(header));
+    rec.data[12] = static_cast<uint8_t>(level);
+    return true;
+}
+
+void Log::commitRecord(BinaryRecord &rec) {
+    if (rec.truncated) {
+        rec.data[12] |= kLevelTruncated;
+    }
+    // Records made before the drain task exists stay queued until it starts
+    s_binRing.commit(static_cast<BinaryRing::Slot *>(rec.slot), rec.ticket, rec.len);
+}
+#endif
+
+void Log::flush(uint32_t timeoutMs) {
+    const uint32_t start = millis();
+    while (s_async && !ringsEmpty() && (millis() - start) < timeoutMs) {
+        delay(1);
+    }
+    if (s_async) {
+        PersistentLog::requestFlush();
+        while (PersistentLog::isFlushPending() && (millis() - start) < timeoutMs) {
+            delay(1);
+        }
+    }
+    if (s_serial) {
+        s_serial->flush();
+    }
+}
+
+uint32_t Log::getDropped() {
+    return s_dropped.load();
+}
+
+void Log::setLineSink(void *ctx, LineSink sink) {
+    s_sinkCtx = ctx;
+    s_sink.store(sink);
+}
+
+void Log::log(LogLevel level, const char *tag, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    write(level, tag, fmt, args);
+    va_end(args);
 }
 
 void Log::error(const char *tag, const char *fmt, ...) {
@@ -38,6 +322,32 @@ void Log::debug(const char *tag, const char *fmt, ...) {
     va_end(args);
 }
 
+size_t Log::format(char *out, size_t outSize, LogLevel level, const char *tag, const char *fmt, va_list args) {
+    char levelChar = '?';
+    switch (level) {
+        case LogLevel::Error: levelChar = 'E'; break;
+        case LogLevel::Warn:  levelChar = 'W'; break;
+        case LogLevel::Info:  levelChar = 'I'; break;
+        case LogLevel::Debug: levelChar = 'D'; break;
+    }
+
+    // Leave room for the CRLF
+    const size_t room = outSize - 2;
+    int n = (tag && tag[0] != '\0')
+                ? snprintf(out, room, "[%lu][%c][%s] ", (unsigned long)millis(), levelChar, tag)
+                : snprintf(out, room, "[%lu][%c] ", (unsigned long)millis(), levelChar);
+    size_t len = (n > 0) ? min(static_cast<size_t>(n), room - 1) : 0;
+
+    n = vsnprintf(out + len, room - len, fmt, args);
+    if (n > 0) {
+        len += min(static_cast<size_t>(n), room - len - 1);
+    }
+
+    out[len++] = '\r';
+    out[len++] = '\n';
+    return len;
+}
+
 void Log::write(LogLevel level, const char *tag, const char *fmt, va_list args) {
     if (!s_serial) {
         return;
@@ -48,31 +358,85 @@ void Log::write(LogLevel level, const char *tag, const char *fmt, va_list args)
         return;
     }
 
-    char msg[256];
-    vsnprintf(msg, sizeof(msg), fmt, args);
-
-    char levelChar = '?';
-    switch (level) {
-        case LogLevel::Error: levelChar = 'E'; break;
-        case LogLevel::Warn:  levelChar = 'W'; break;
-        case LogLevel::Info:  levelChar = 'I'; break;
-        case LogLevel::Debug: levelChar = 'D'; break;
+    if (!s_async) {
+        char line[kLineBytes];
+        const size_t len = format(line, sizeof(line), level, tag, fmt, args);
+        s_serial->write(reinterpret_cast<const uint8_t *>(line), len);
+        return;
     }
 
-    const uint32_t ms = millis();
+    // Format straight into the claimed slot: no copy, no lock, no UART wait
+    uint32_t ticket;
+    auto *slot = s_ring.claim(ticket);
+    if (!slot) {
+        s_dropped++;
+        return;
+    }
+    const size_t len = format(slot->data, sizeof(slot->data), level, tag, fmt, args);
+    s_ring.commit(slot, ticket, len, compiledLevel);
+}
 
-    s_serial->print('[');
-    s_serial->print(ms);
-    s_serial->print("][");
-    s_serial->print(levelChar);
-    s_serial->print("]");
+void Log::drainTask(void *arg) {
+    (void)arg;
+    uint32_t reportedDropped = 0;
 
-    if (tag && tag[0] != '\0') {
-        s_serial->print('[');
-        s_serial->print(tag);
-        s_serial->print(']');
+#if LOG_BINARY
+    // Lets the decoder check it was given the matching ELF
+    char elfSha[17] = {0};
+    esp_ota_get_app_elf_sha256(elfSha, sizeof(elfSha));
+    char banner[96];
+    const int bannerLen = snprintf(banner, sizeof(banner), "[%lu][I][log] binary log v1 elf=%s\r\n",
+                                   (unsigned long)millis(), elfSha);
+    if (bannerLen > 0) {
+        s_serial->write(reinterpret_cast<const uint8_t *>(banner), min(static_cast<size_t>(bannerLen), sizeof(banner) - 1));
     }
+#endif
+
+    for (;;) {
+        const LineSink sink = s_sink.load();
+        while (auto *slot = s_ring.peek()) {
+            s_serial->write(reinterpret_cast<const uint8_t *>(slot->data), slot->len);
+            if (slot->kind <= static_cast<uint8_t>(LogLevel::Warn)) {
+                PersistentLog::append(slot->data, slot->len, slot->kind == static_cast<uint8_t>(LogLevel::Error));
+            }
+            if (sink) {
+                sink(s_sinkCtx, slot->data, slot->len, static_cast<LogLevel>(slot->kind));
+            }
+            s_ring.release(slot);
+        }
+
+#if LOG_BINARY
+        while (auto *slot = s_binRing.peek()) {
+            const uint8_t frame[3] = {kFrameSync0, kFrameSync1, static_cast<uint8_t>(slot->len)};
+            s_serial->write(frame, sizeof(frame));
+            s_serial->write(reinterpret_cast<const uint8_t *>(slot->data), slot->len);
+            // Persisted in the same framing, so the file decodes like a UART capture
+            const uint8_t level = static_cast<uint8_t>(slot->data[12]) & ~kLevelTruncated;
+            if (level <= static_cast<uint8_t>(LogLevel::Warn)) {
+                char framed[3 + kRecordBytes];
+                memcpy(framed, frame, sizeof(frame));
+                memcpy(framed + sizeof(frame), slot->data, slot->len);
+                PersistentLog::append(framed, sizeof(frame) + slot->len, level == static_cast<uint8_t>(LogLevel::Error));
+            }
+            s_binRing.release(slot);
+        }
+#endif
 
-    s_serial->print(' ');
-    s_serial->println(msg);
+        const uint32_t dropped = s_dropped.load();
+        if (dropped != reportedDropped) {
+            char line[64];
+            const int n = snprintf(line, sizeof(line), "[%lu][W][log] %lu lines dropped\r\n",
+                                   (unsigned long)millis(), (unsigned long)(dropped - reportedDropped));
+            if (n > 0) {
+                const size_t len = min(static_cast<size_t>(n), sizeof(line) - 1);
+                s_serial->write(reinterpret_cast<const uint8_t *>(line), len);
+                PersistentLog::append(line, len, false);
+            }
+            reportedDropped = dropped;
+        }
+
+        PersistentLog::service();
+
+        vTaskDelay(pdMS_TO_TICKS(kDrainIdleMs));
+    }
 }
@@ -1,11 +1,25 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 #include <cstdarg>
+#include <type_traits>
 
-// Compile-time log level (0=ERROR, 1=WARN, 2=INFO, 3=DEBUG)
+// Compile-time ceiling (0=ERROR, 1=WARN, 2=INFO, 3=DEBUG): calls above it are compiled out
 #ifndef LOG_LEVEL
-#define LOG_LEVEL 2
+#define LOG_LEVEL 3
+#endif
+
+// Level every tag starts at; raised/lowered per tag at runtime (see LogTags)
+#ifndef LOG_DEFAULT_LEVEL
+#define LOG_DEFAULT_LEVEL 2
+#endif
+
+// Binary (deferred-formatting) mode: -DLOG_BINARY=1. LOGx calls store the format/tag string
+// addresses, a timestamp and the raw arguments instead of text; scripts/log_decode.py rebuilds
+// the lines from the firmware ELF. No vsnprintf on the device, ~4x more history in the ring.
+#ifndef LOG_BINARY
+#define LOG_BINARY 0
 #endif
 
 enum class LogLevel : uint8_t {
@@ -15,41 +29,162 @@ enum class LogLevel : uint8_t {
     Debug = 3,
 };
 
+// Runtime level per tag. Each LOGx call site resolves its tag once (first call) to the tag's
+// level byte; afterwards the check is one relaxed atomic load, no string compare per call.
+// Tags follow the default level until overridden (e.g. {"type":"logLevel"} over WebSocket).
+// Overrides are not persisted: every boot starts at LOG_DEFAULT_LEVEL.
+class LogTags {
+public:
+    static constexpr size_t kMaxTags = 32;
+    static constexpr size_t kMaxNameLen = 15;
+    // Level byte value that silences a tag (the byte is "highest enabled level + 1")
+    static constexpr uint8_t kOff = 0;
+
+    // Level byte of a tag, registering it on first use (a shared byte once the table is full)
+    static std::atomic<uint8_t> *levelFor(const char *tag);
+
+    static bool isEnabled(const std::atomic<uint8_t> &levelByte, LogLevel level) {
+        return static_cast<uint8_t>(level) < levelByte.load(std::memory_order_relaxed);
+    }
+
+    // level: highest level to print, or -1 for none; clamped to LOG_LEVEL. Returns false when
+    // the table is full. tag "*" sets the default level (tags without an override follow it).
+    static bool setLevel(const char *tag, int level);
+    static void clearOverride(const char *tag);
+
+    // -1 when off
+    static int getDefaultLevel();
+    static size_t count();
+    static bool get(size_t index, const char *&name, int &level, bool &overridden);
+
+    // "error" | "warn" | "info" | "debug" | "off"
+    static bool parseLevel(const char *name, int &level);
+    static const char *levelName(int level);
+};
+
+// Log lines are formatted by the caller into a lock-free ring (see LogRing.h) and written to
+// the UART by a low-priority drain task, so logging from the loop, AsyncTCP handlers or OTA
+// callbacks never waits on the serial port. A full ring drops the line (counted, reported
+// by the drain task). Before begin() starts the task, lines are written synchronously.
 class Log {
 public:
     static void begin(HardwareSerial &serial, uint32_t baud = 115200);
 
+    // Wait (up to timeoutMs) until queued lines reached the UART, e.g. before a restart
+    static void flush(uint32_t timeoutMs = 200);
+
+    static uint32_t getDropped();
+
+    // Called on the drain task for every text line after it reached the UART (with CRLF).
+    // Must not block; set once (e.g. WebSocket log streaming).
+    using LineSink = void (*)(void *ctx, const char *line, size_t len, LogLevel level);
+    static void setLineSink(void *ctx, LineSink sink);
+
+    static void log(LogLevel level, const char *tag, const char *fmt, ...);
+
     static void error(const char *tag, const char *fmt, ...);
     static void warn(const char *tag, const char *fmt, ...);
     static void info(const char *tag, const char *fmt, ...);
     static void debug(const char *tag, const char *fmt, ...);
 
+#if LOG_BINARY
+    template <typename... Args>
+    static void record(LogLevel level, const char *tag, const char *fmt, Args... args) {
+        if (static_cast<uint8_t>(level) > static_cast<uint8_t>(LOG_LEVEL)) {
+            return;
+        }
+        BinaryRecord rec;
+        if (!beginRecord(rec, level, tag, fmt)) {
+            return;
+        }
+        int expand[] = {0, (rec.put(args), 0)...};
+        (void)expand;
+        commitRecord(rec);
+    }
+#endif
+
 private:
+#if LOG_BINARY
+    // Record: u32 ms, u32 fmt, u32 tag, u8 level (bit 7: arguments truncated), then the
+    // arguments in order: 4 bytes per int/char/pointer, 8 per double/64-bit int,
+    // strings inline as u8 length + bytes. Must stay in sync with scripts/log_decode.py.
+    class BinaryRecord {
+    public:
+        void put(const char *s);
+        void put(char *s) { put(static_cast<const char *>(s)); }
+        void put(double v) { putBytes(&v, sizeof(v)); }
+        void put(float v) { put(static_cast<double>(v)); }
+        void put(long long v) { putBytes(&v, sizeof(v)); }
+        void put(unsigned long long v) { putBytes(&v, sizeof(v)); }
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type put(T v) {
+            const uint32_t word = static_cast<uint32_t>(v);
+            putBytes(&word, sizeof(word));
+        }
+        template <typename T>
+        void put(T *p) {
+            const uint32_t word = reinterpret_cast<uintptr_t>(p);
+            putBytes(&word, sizeof(word));
+        }
+
+    private:
+        friend class Log;
+        void putBytes(const void *src, size_t n);
+
+        void *slot = nullptr;
+        uint8_t *data = nullptr;
+        size_t cap = 0;
+        size_t len = 0;
+        uint32_t ticket = 0;
+        bool truncated = false;
+    };
+
+    static bool beginRecord(BinaryRecord &rec, LogLevel level, const char *tag, const char *fmt);
+    static void commitRecord(BinaryRecord &rec);
+#endif
+
     static void write(LogLevel level, const char *tag, const char *fmt, va_list args);
+    static size_t format(char *out, size_t outSize, LogLevel level, const char *tag, const char *fmt, va_list args);
+    static void drainTask(void *arg);
 
     static HardwareSerial *s_serial;
 };
 
+#if LOG_BINARY
+#define LOG_EMIT(LEVEL, TAG, FMT, ...) Log::record((LEVEL), (TAG), (FMT), ##__VA_ARGS__)
+#else
+#define LOG_EMIT(LEVEL, TAG, FMT, ...) Log::log((LEVEL), (TAG), (FMT), ##__VA_ARGS__)
+#endif
+
+// The static is per call site: the tag lookup runs on the first call only
+#define LOG_AT(LEVEL, TAG, FMT, ...)                                                   \
+    do {                                                                               \
+        static std::atomic<uint8_t> *const logTagLevel_ = LogTags::levelFor(TAG);      \
+        if (LogTags::isEnabled(*logTagLevel_, (LEVEL))) {                              \
+            LOG_EMIT((LEVEL), (TAG), (FMT), ##__VA_ARGS__);                            \
+        }                                                                              \
+    } while (0)
+
 #if LOG_LEVEL >= 0
-#define LOGE(TAG, FMT, ...) Log::error((TAG), (FMT), ##__VA_ARGS__)
+#define LOGE(TAG, FMT, ...) LOG_AT(LogLevel::Error, TAG, FMT, ##__VA_ARGS__)
 #else
 #define LOGE(TAG, FMT, ...) do { } while (0)
 #endif
 
 #if LOG_LEVEL >= 1
-#define LOGW(TAG, FMT, ...) Log::warn((TAG), (FMT), ##__VA_ARGS__)
+#define LOGW(TAG, FMT, ...) LOG_AT(LogLevel::Warn, TAG, FMT, ##__VA_ARGS__)
 #else
 #define LOGW(TAG, FMT, ...) do { } while (0)
 #endif
 
 #if LOG_LEVEL >= 2
-#define LOGI(TAG, FMT, ...) Log::info((TAG), (FMT), ##__VA_ARGS__)
+#define LOGI(TAG, FMT, ...) LOG_AT(LogLevel::Info, TAG, FMT, ##__VA_ARGS__)
 #else
 #define LOGI(TAG, FMT, ...) do { } while (0)
 #endif
 
 #if LOG_LEVEL >= 3
-#define LOGD(TAG, FMT, ...) Log::debug((TAG), (FMT), ##__VA_ARGS__)
+#define LOGD(TAG, FMT, ...) LOG_AT(LogLevel::Debug, TAG, FMT, ##__VA_ARGS__)
 #else
 #define LOGD(TAG, FMT, ...) do { } while (0)
 #endif
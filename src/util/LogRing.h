@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer / single-consumer ring of fixed-size text slots
+// (sequence-numbered slots, Vyukov style). Producers claim a slot with one CAS, fill it in
+// place and publish it; a full ring fails the claim instead of blocking.
+// Header-only and free of Arduino/FreeRTOS so it can be exercised on the host.
+template <size_t Slots, size_t SlotBytes>
+class LogRing {
+    static_assert(Slots >= 2 && (Slots & (Slots - 1)) == 0, "Slots must be a power of two");
+
+public:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        uint16_t len;
+        uint8_t kind;  // caller-defined (the logger stores the level)
+        char data[SlotBytes];
+    };
+
+    LogRing() {
+        for (size_t i = 0; i < Slots; i++) {
+            slots[i].seq.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        }
+    }
+
+    // Producer: returns a slot to fill (then commit()), or nullptr when the ring is full
+    Slot* claim(uint32_t& ticket) {
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (Slots - 1)];
+            const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            const int32_t diff = static_cast<int32_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ticket = pos;
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void commit(Slot* slot, uint32_t ticket, size_t len, uint8_t kind = 0) {
+        slot->len = static_cast<uint16_t>(len < SlotBytes ? len : SlotBytes);
+        slot->kind = kind;
+        slot->seq.store(ticket + 1, std::memory_order_release);
+    }
+
+    // Consumer (single thread): next published slot in order, or nullptr. Call release() when done.
+    Slot* peek() {
+        const uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & (Slots - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;  // empty, or the next producer hasn't committed yet
+        }
+        return &slot;
+    }
+
+    void release(Slot* slot) {
+        const uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+        slot->seq.store(pos + Slots, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_release);
+    }
+
+    // Any thread: true once everything claimed so far has been consumed
+    bool empty() const {
+        return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire);
+    }
+
+private:
+    Slot slots[Slots];
+    std::atomic<uint32_t> enqueuePos{0};
+    std::atomic<uint32_t> dequeuePos{0};  // written by the consumer only
+};
@@ -0,0 +1,230 @@
+#include "LoopProfiler.h"
+
+#include "Log.h"
+
+namespace {
+// Values below 4 us get a bucket each; above, every power of two is split into 4
+constexpr size_t kSubBuckets = 4;
+constexpr size_t kBuckets = 96;  // up to ~16 s
+
+struct Histogram {
+    uint32_t buckets[kBuckets];
+    uint32_t maxUs;
+};
+
+Histogram s_hist[LoopProfiler::StageCount + 1];
+
+// Current frame (loop task only)
+uint32_t s_frameStartUs = 0;
+uint32_t s_stageCycles[LoopProfiler::StageCount];  // Menu/Idle hold microseconds
+uint16_t s_stageRan = 0;                              // bit per stage
+uint32_t s_cyclesPerUs = 240;
+
+std::atomic<bool> s_resetRequested{false};
+std::atomic<uint32_t> s_slowFrameUs{LoopProfiler::kDefaultSlowFrameUs};
+
+portMUX_TYPE s_slowMux = portMUX_INITIALIZER_UNLOCKED;
+LoopProfiler::SlowFrame s_slow[LoopProfiler::kSlowFrames];
+uint8_t s_slowHead = 0;  // next write slot
+uint32_t s_slowCount = 0;
+uint32_t s_lastSlowLogMs = 0;
+bool s_slowLogged = false;
+
+const char* const kStageNames[] = {"ota",     "modes", "wifi",    "mqtt",      "wsState", "wsLog", "events",
+                                   "leds",    "input", "display", "broadcast", "menu",    "idle",  "frame"};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == LoopProfiler::StageCount + 1, "stage names");
+
+size_t bucketOf(uint32_t us) {
+    if (us < kSubBuckets) {
+        return us;
+    }
+    const uint32_t e = 31 - __builtin_clz(us);  // >= 2
+    const uint32_t sub = (us >> (e - 2)) & (kSubBuckets - 1);
+    const size_t i = (e - 1) * kSubBuckets + sub;
+    return i < kBuckets ? i : kBuckets - 1;
+}
+
+// Largest value that lands in bucket i
+uint32_t bucketUpperUs(size_t i) {
+    if (i < kSubBuckets) {
+        return i;
+    }
+    const uint32_t e = i / kSubBuckets + 1;
+    const uint32_t sub = i % kSubBuckets;
+    return ((kSubBuckets + sub) << (e - 2)) + (1u << (e - 2)) - 1;
+}
+
+void record(Histogram& h, uint32_t us) {
+    h.buckets[bucketOf(us)]++;
+    if (us > h.maxUs) {
+        h.maxUs = us;
+    }
+}
+
+uint32_t percentile(const Histogram& h, uint32_t count, uint32_t pct) {
+    // Rank of the sample (1-based), rounded up
+    const uint32_t rank = static_cast<uint32_t>((static_cast<uint64_t>(count) * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        seen += h.buckets[i];
+        if (seen >= rank) {
+            return min(bucketUpperUs(i), h.maxUs);
+        }
+    }
+    return h.maxUs;
+}
+
+uint32_t stageUs(size_t stage) {
+    return (stage >= LoopProfiler::Menu) ? s_stageCycles[stage] : s_stageCycles[stage] / s_cyclesPerUs;
+}
+} // namespace
+
+std::atomic<bool> LoopProfiler::s_enabled{false};
+bool LoopProfiler::s_inFrame = false;
+
+void LoopProfiler::setEnabled(bool enabled) {
+    s_enabled = enabled;
+}
+
+void LoopProfiler::setSlowFrameUs(uint32_t us) {
+    s_slowFrameUs = us;
+}
+
+uint32_t LoopProfiler::getSlowFrameUs() {
+    return s_slowFrameUs.load();
+}
+
+void LoopProfiler::requestReset() {
+    s_resetRequested = true;
+}
+
+const char* LoopProfiler::stageName(size_t stage) {
+    return stage <= kFrame ? kStageNames[stage] : "?";
+}
+
+void LoopProfiler::beginFrame() {
+    if (s_resetRequested.exchange(false)) {
+        memset(s_hist, 0, sizeof(s_hist));
+        portENTER_CRITICAL(&s_slowMux);
+        s_slowHead = 0;
+        s_slowCount = 0;
+        portEXIT_CRITICAL(&s_slowMux);
+    }
+
+    s_inFrame = isEnabled();
+    if (!s_inFrame) {
+        return;
+    }
+    s_cyclesPerUs = max<uint32_t>(1, ESP.getCpuFreqMHz());
+    memset(s_stageCycles, 0, sizeof(s_stageCycles));
+    s_stageRan = 0;
+    s_frameStartUs = micros();
+}
+
+void LoopProfiler::endStage(Stage stage, uint32_t start) {
+    const uint32_t now = (stage >= Menu) ? micros() : ESP.getCycleCount();
+    s_stageCycles[stage] += now - start;
+    s_stageRan |= static_cast<uint16_t>(1u << stage);
+}
+
+void LoopProfiler::endFrame() {
+    if (!s_inFrame) {
+        return;
+    }
+    s_inFrame = false;
+
+    const uint32_t totalUs = micros() - s_frameStartUs;
+    const uint32_t waitUs = stageUs(Menu) + stageUs(Idle);
+    const uint32_t busyUs = totalUs > waitUs ? totalUs - waitUs : 0;
+
+    for (size_t i = 0; i < StageCount; i++) {
+        if (s_stageRan & (1u << i)) {
+            record(s_hist[i], stageUs(i));
+        }
+    }
+    record(s_hist[kFrame], busyUs);
+
+    if (busyUs <= s_slowFrameUs.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    SlowFrame frame;
+    frame.atMs = millis();
+    frame.busyUs = busyUs;
+    for (size_t i = 0; i < StageCount; i++) {
+        frame.stageUs[i] = (s_stageRan & (1u << i)) ? stageUs(i) : 0;
+    }
+    portENTER_CRITICAL(&s_slowMux);
+    s_slow[s_slowHead] = frame;
+    s_slowHead = (s_slowHead + 1) % kSlowFrames;
+    s_slowCount++;
+    portEXIT_CRITICAL(&s_slowMux);
+
+    if (s_slowLogged && frame.atMs - s_lastSlowLogMs < kSlowLogIntervalMs) {
+        return;
+    }
+    s_slowLogged = true;
+    s_lastSlowLogMs = frame.atMs;
+
+    // The three most expensive stages are enough to point at the culprit
+    size_t top[3] = {StageCount, StageCount, StageCount};
+    for (size_t i = 0; i < StageCount; i++) {
+        if (i == Menu || i == Idle || frame.stageUs[i] == 0) {
+            continue;
+        }
+        for (size_t k = 0; k < 3; k++) {
+            if (top[k] == StageCount || frame.stageUs[i] > frame.stageUs[top[k]]) {
+                for (size_t j = 2; j > k; j--) {
+                    top[j] = top[j - 1];
+                }
+                top[k] = i;
+                break;
+            }
+        }
+    }
+    char detail[96] = "";
+    size_t len = 0;
+    for (size_t k = 0; k < 3 && top[k] != StageCount && len < sizeof(detail); k++) {
+        const int n = snprintf(detail + len, sizeof(detail) - len, "%s%s %lu us", k ? ", " : "", kStageNames[top[k]],
+                               (unsigned long)frame.stageUs[top[k]]);
+        len = n > 0 ? len + static_cast<size_t>(n) : sizeof(detail);
+    }
+    LOGW("prof", "Slow frame: %lu us busy (%s)", (unsigned long)busyUs, detail);
+}
+
+bool LoopProfiler::getStats(size_t stage, Stats& out) {
+    if (stage > kFrame) {
+        return false;
+    }
+    const Histogram& h = s_hist[stage];
+    uint32_t count = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        count += h.buckets[i];
+    }
+    if (count == 0) {
+        return false;
+    }
+    out.count = count;
+    out.maxUs = h.maxUs;
+    out.p50Us = percentile(h, count, 50);
+    out.p99Us = percentile(h, count, 99);
+    return true;
+}
+
+size_t LoopProfiler::getSlowFrames(SlowFrame* out, size_t maxFrames) {
+    portENTER_CRITICAL(&s_slowMux);
+    const size_t kept = (s_slowCount < kSlowFrames) ? s_slowCount : kSlowFrames;
+    const size_t n = (kept < maxFrames) ? kept : maxFrames;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_slow[(s_slowHead + kSlowFrames - 1 - i) % kSlowFrames];
+    }
+    portEXIT_CRITICAL(&s_slowMux);
+    return n;
+}
+
+uint32_t LoopProfiler::getSlowFrameCount() {
+    portENTER_CRITICAL(&s_slowMux);
+    const uint32_t n = s_slowCount;
+    portEXIT_CRITICAL(&s_slowMux);
+    return n;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// -DLOOP_PROFILER=0 compiles every probe out (LOOP_FRAME/LOOP_STAGE expand to nothing)
+#ifndef LOOP_PROFILER
+#define LOOP_PROFILER 1
+#endif
+
+// Per-stage timing of loop().
+// - LOOP_FRAME() at the top of loop() and LOOP_STAGE(Stage) scopes around each stage read the
+//   CPU cycle counter and add up each stage's time for the frame.
+// - At the end of the frame every stage that ran feeds its histogram (4 sub-buckets per power
+//   of two, ~20% resolution) for p50/p99/max; the frame's busy time (everything except the
+//   Menu/Idle waits) has its own.
+// - A frame busier than the slow-frame threshold keeps its per-stage breakdown (last
+//   kSlowFrames) and logs one WARN line (at most every kSlowLogIntervalMs).
+// - Off by default and switchable at runtime (/api/profile); a disabled probe is one load.
+// Written by the loop() task only; readers (HTTP) get approximate snapshots.
+class LoopProfiler {
+public:
+    enum Stage : uint8_t {
+        Ota,
+        Modes,
+        Wifi,
+        Mqtt,
+        WsState,
+        WsLog,
+        Events,
+        Leds,
+        Input,
+        Display,
+        Broadcast,
+        Menu,  // blocking menu navigation (waits for the user)
+        Idle,  // delay() at the end of the frame
+        StageCount
+    };
+    // getStats() index of the whole frame's busy time
+    static constexpr size_t kFrame = StageCount;
+
+    static constexpr size_t kSlowFrames = 4;
+    static constexpr uint32_t kDefaultSlowFrameUs = 30 * 1000;
+    static constexpr uint32_t kSlowLogIntervalMs = 5000;
+
+    struct Stats {
+        uint32_t count;
+        uint32_t p50Us;
+        uint32_t p99Us;
+        uint32_t maxUs;
+    };
+
+    struct SlowFrame {
+        uint32_t atMs;
+        uint32_t busyUs;
+        uint32_t stageUs[StageCount];
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setSlowFrameUs(uint32_t us);
+    static uint32_t getSlowFrameUs();
+    // Applied by the loop task at the start of the next frame
+    static void requestReset();
+
+    static const char* stageName(size_t stage);
+    // stage: Stage or kFrame. False when the stage has no samples.
+    static bool getStats(size_t stage, Stats& out);
+    // Newest first; returns how many were copied
+    static size_t getSlowFrames(SlowFrame* out, size_t maxFrames);
+    static uint32_t getSlowFrameCount();
+
+    class Frame {
+    public:
+        Frame() { beginFrame(); }
+        ~Frame() { endFrame(); }
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(Stage stage) : stage(stage), active(s_inFrame) {
+            if (active) {
+                start = (stage >= Menu) ? micros() : ESP.getCycleCount();
+            }
+        }
+        ~Scope() {
+            if (active) {
+                endStage(stage, start);
+            }
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const Stage stage;
+        const bool active;
+        uint32_t start = 0;
+    };
+
+private:
+    static void beginFrame();
+    static void endFrame();
+    static void endStage(Stage stage, uint32_t start);
+
+    static std::atomic<bool> s_enabled;
+    static bool s_inFrame;  // loop task only: this frame is being profiled
+};
+
+#define LOOP_PROFILER_CONCAT2(A, B) A##B
+#define LOOP_PROFILER_CONCAT(A, B) LOOP_PROFILER_CONCAT2(A, B)
+
+#if LOOP_PROFILER
+#define LOOP_FRAME() LoopProfiler::Frame loopProfilerFrame_
+#define LOOP_STAGE(STAGE) LoopProfiler::Scope LOOP_PROFILER_CONCAT(loopProfilerStage_, __LINE__)(LoopProfiler::STAGE)
+#else
+#define LOOP_FRAME() do { } while (0)
+#define LOOP_STAGE(STAGE) do { } while (0)
+#endif
@@ -0,0 +1,105 @@
+#include "Metrics.h"
+
+namespace {
+// Registration happens from static constructors (before setup()), exporting afterwards;
+// plain pointers are zero-initialized before any constructor runs.
+Metric *s_head = nullptr;
+Metric *s_tail = nullptr;
+
+const char *typeName(Metric::Type type) {
+    switch (type) {
+        case Metric::Type::Counter: return "counter";
+        case Metric::Type::Gauge: return "gauge";
+        case Metric::Type::Histogram: return "histogram";
+    }
+    return "untyped";
+}
+} // namespace
+
+Metric::Metric(Type type, const char *name, const char *help, const char *labels)
+    : type(type), name(name), help(help), labels(labels) {
+    Metrics::add(this);
+}
+
+void Metrics::add(Metric *metric) {
+    // Appended, so the export follows declaration order within a file
+    if (s_tail) {
+        s_tail->next = metric;
+    } else {
+        s_head = metric;
+    }
+    s_tail = metric;
+}
+
+void Metrics::writeSample(Print &out, const Metric &m, const char *suffix, const char *extraLabel) {
+    out.print(m.name);
+    out.print(suffix);
+    const bool hasLabels = m.labels && m.labels[0] != '\0';
+    if (hasLabels || extraLabel) {
+        out.print('{');
+        if (hasLabels) {
+            out.print(m.labels);
+        }
+        if (extraLabel) {
+            if (hasLabels) {
+                out.print(',');
+            }
+            out.print(extraLabel);
+        }
+        out.print('}');
+    }
+    out.print(' ');
+}
+
+void Metrics::writePrometheus(Print &out) {
+    for (const Metric *m = s_head; m; m = m->next) {
+        // A family is written once, at its first member (members may live in different files)
+        bool seen = false;
+        for (const Metric *prev = s_head; prev != m; prev = prev->next) {
+            if (strcmp(prev->name, m->name) == 0) {
+                seen = true;
+                break;
+            }
+        }
+        if (seen) {
+            continue;
+        }
+
+        out.printf("# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, typeName(m->type));
+
+        for (const Metric *f = m; f; f = f->next) {
+            if (f != m && strcmp(f->name, m->name) != 0) {
+                continue;
+            }
+            switch (f->type) {
+                case Metric::Type::Counter:
+                    writeSample(out, *f, "_total", nullptr);
+                    out.println(static_cast<const MetricCounter *>(f)->value());
+                    break;
+                case Metric::Type::Gauge:
+                    writeSample(out, *f, "", nullptr);
+                    out.println(static_cast<const MetricGauge *>(f)->value());
+                    break;
+                case Metric::Type::Histogram: {
+                    const auto *h = static_cast<const MetricHistogram *>(f);
+                    uint32_t cumulative = 0;
+                    char le[24];
+                    for (size_t i = 0; i < MetricHistogram::kBuckets; i++) {
+                        cumulative += h->bucketCount(i);
+                        snprintf(le, sizeof(le), "le=\"%g\"", static_cast<double>(1UL << i) / 1e6);
+                        writeSample(out, *f, "_bucket", le);
+                        out.println(cumulative);
+                    }
+                    cumulative += h->bucketCount(MetricHistogram::kBuckets);
+                    writeSample(out, *f, "_bucket", "le=\"+Inf\"");
+                    out.println(cumulative);
+                    writeSample(out, *f, "_sum", nullptr);
+                    out.println(static_cast<double>(h->getSumUs()) / 1e6, 6);
+                    writeSample(out, *f, "_count", nullptr);
+                    out.println(cumulative);
+                    break;
+                }
+            }
+        }
+    }
+}
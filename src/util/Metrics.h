@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Fixed-footprint metrics, exported in Prometheus text format (GET /api/metrics).
+// - Metrics are static objects that register themselves when constructed (intrusive list,
+//   no heap); updates are relaxed atomic adds/stores and safe from any task.
+// - Counters and histogram sums are 32-bit and wrap; Prometheus treats that like a restart.
+// - Histograms use power-of-two buckets over microseconds (1 us .. ~0.5 s, then +Inf) and
+//   are exported in seconds.
+// - Metrics sharing a name but not labels form one family (labels: `dir="in"`).
+class Metric {
+public:
+    enum class Type : uint8_t { Counter, Gauge, Histogram };
+
+    Metric(Type type, const char *name, const char *help, const char *labels);
+
+    const char *getName() const { return name; }
+
+protected:
+    friend class Metrics;
+
+    const Type type;
+    const char *const name;
+    const char *const help;
+    const char *const labels;  // nullptr or `key="value",...`
+    Metric *next = nullptr;
+};
+
+class MetricCounter : public Metric {
+public:
+    MetricCounter(const char *name, const char *help, const char *labels = nullptr)
+        : Metric(Type::Counter, name, help, labels) {}
+
+    void inc(uint32_t n = 1) { count.fetch_add(n, std::memory_order_relaxed); }
+    uint32_t value() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> count{0};
+};
+
+class MetricGauge : public Metric {
+public:
+    MetricGauge(const char *name, const char *help, const char *labels = nullptr)
+        : Metric(Type::Gauge, name, help, labels) {}
+
+    void set(int32_t v) { current.store(v, std::memory_order_relaxed); }
+    void add(int32_t v) { current.fetch_add(v, std::memory_order_relaxed); }
+    int32_t value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int32_t> current{0};
+};
+
+class MetricHistogram : public Metric {
+public:
+    // Bucket i holds values <= 2^i us; one more for +Inf
+    static constexpr size_t kBuckets = 20;
+
+    MetricHistogram(const char *name, const char *help, const char *labels = nullptr)
+        : Metric(Type::Histogram, name, help, labels) {}
+
+    void observeUs(uint32_t us) {
+        const size_t i = (us <= 1) ? 0 : static_cast<size_t>(32 - __builtin_clz(us - 1));
+        buckets[i < kBuckets ? i : kBuckets].fetch_add(1, std::memory_order_relaxed);
+        sumUs.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    uint32_t bucketCount(size_t i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint32_t getSumUs() const { return sumUs.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> buckets[kBuckets + 1] = {};
+    std::atomic<uint32_t> sumUs{0};
+};
+
+// Scoped duration: MetricTimer t(s_drawTime); records the elapsed microseconds on exit
+class MetricTimer {
+public:
+    explicit MetricTimer(MetricHistogram &histogram) : histogram(histogram), startUs(micros()) {}
+    ~MetricTimer() { histogram.observeUs(micros() - startUs); }
+
+    MetricTimer(const MetricTimer &) = delete;
+    MetricTimer &operator=(const MetricTimer &) = delete;
+
+private:
+    MetricHistogram &histogram;
+    const uint32_t startUs;
+};
+
+class Metrics {
+public:
+    // Prometheus text exposition format 0.0.4
+    static void writePrometheus(Print &out);
+
+private:
+    friend class Metric;
+    static void add(Metric *metric);
+    static void writeSample(Print &out, const Metric &m, const char *suffix, const char *extraLabel);
+};
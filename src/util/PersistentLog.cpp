@@ -0,0 +1,245 @@
+#include "PersistentLog.h"
+
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <freertos/semphr.h>
+#include <atomic>
+
+#include "version.h"
+
+namespace {
+constexpr const char* kDir = "/logs";
+constexpr const char* kCurPath = "/logs/cur.log";
+constexpr const char* kPrevPath = "/logs/prev.log";
+constexpr uint32_t kBatchMagic = 0x4C4F4731;  // "LOG1"
+
+// Survives everything but power loss / brownout (RTC slow memory, not initialized at boot)
+struct RtcBatch {
+    uint32_t magic;
+    uint32_t len;
+    uint32_t check;
+    char data[PersistentLog::kBatchBytes];
+};
+RTC_NOINIT_ATTR RtcBatch s_batch;
+
+SemaphoreHandle_t s_mutex = nullptr;
+fs::FS* s_fs = nullptr;
+uint32_t s_firstPendingMs = 0;
+uint32_t s_urgentAtMs = 0;
+bool s_urgent = false;
+std::atomic<bool> s_flushRequested{false};
+const char* s_resetReason = "unknown";
+uint32_t s_recoveredBytes = 0;
+
+void sealBatch() {
+    s_batch.check = s_batch.magic ^ s_batch.len;
+}
+
+bool batchValid() {
+    return s_batch.magic == kBatchMagic && s_batch.len <= sizeof(s_batch.data) &&
+           s_batch.check == (s_batch.magic ^ s_batch.len);
+}
+
+const char* resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON: return "power-on";
+        case ESP_RST_EXT: return "external";
+        case ESP_RST_SW: return "software";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "interrupt watchdog";
+        case ESP_RST_TASK_WDT: return "task watchdog";
+        case ESP_RST_WDT: return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep sleep";
+        case ESP_RST_BROWNOUT: return "brownout";
+        case ESP_RST_SDIO: return "sdio";
+        default: return "unknown";
+    }
+}
+
+size_t fileSize(fs::FS& fs, const char* path) {
+    File f = fs.open(path, "r");
+    const size_t n = f ? f.size() : 0;
+    if (f) {
+        f.close();
+    }
+    return n;
+}
+
+class Lock {
+public:
+    Lock() { xSemaphoreTake(s_mutex, portMAX_DELAY); }
+    ~Lock() { xSemaphoreGive(s_mutex); }
+};
+} // namespace
+
+void PersistentLog::begin() {
+    s_mutex = xSemaphoreCreateMutex();
+
+    const esp_reset_reason_t reason = esp_reset_reason();
+    s_resetReason = resetReasonName(reason);
+
+    if (batchValid()) {
+        // Lines the previous boot had not written yet (crash, watchdog, OTA restart). They stay
+        // at the front of the batch, so the file reads in order: recovered lines, then this boot's line.
+        s_recoveredBytes = s_batch.len;
+    } else {
+        s_batch.magic = kBatchMagic;
+        s_batch.len = 0;
+    }
+    sealBatch();
+
+    char line[96];
+    const int n = snprintf(line, sizeof(line), "[0][W][boot] ---- boot: reset=%s fw=%s recovered=%u ----\r\n",
+                           s_resetReason, FIRMWARE_VERSION, static_cast<unsigned>(s_recoveredBytes));
+    if (n > 0) {
+        const bool abnormal = reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+                              reason == ESP_RST_WDT || reason == ESP_RST_BROWNOUT;
+        append(line, min(static_cast<size_t>(n), sizeof(line) - 1), abnormal);
+    }
+}
+
+void PersistentLog::attach(fs::FS& fs) {
+    Lock lock;
+    if (!fs.exists(kDir)) {
+        fs.mkdir(kDir);
+    }
+    s_fs = &fs;
+}
+
+void PersistentLog::detach() {
+    Lock lock;
+    // Pending lines stay in RTC memory until the next attach()
+    s_fs = nullptr;
+}
+
+void PersistentLog::append(const char* data, size_t len, bool urgent) {
+    if (len > sizeof(s_batch.data) - s_batch.len) {
+        // Batch full (filesystem not attached yet, or a burst): keep the oldest context
+        return;
+    }
+    if (s_batch.len == 0) {
+        s_firstPendingMs = millis();
+    }
+    memcpy(s_batch.data + s_batch.len, data, len);
+    s_batch.len += len;
+    sealBatch();
+
+    if (urgent && !s_urgent) {
+        s_urgent = true;
+        s_urgentAtMs = millis();
+    }
+}
+
+void PersistentLog::service() {
+    if (s_batch.len == 0) {
+        s_flushRequested = false;
+        return;
+    }
+    const uint32_t now = millis();
+    const bool due = s_flushRequested.load() || s_batch.len >= kFlushThresholdBytes ||
+                     (now - s_firstPendingMs) >= kFlushIntervalMs || (s_urgent && (now - s_urgentAtMs) >= kUrgentDelayMs);
+    if (!due) {
+        return;
+    }
+
+    Lock lock;
+    flushLocked();
+}
+
+void PersistentLog::flushLocked() {
+    if (!s_fs) {
+        return;  // keep batching (bounded) until a filesystem is attached
+    }
+
+    if (fileSize(*s_fs, kCurPath) + s_batch.len > kFileBytes) {
+        s_fs->remove(kPrevPath);
+        s_fs->rename(kCurPath, kPrevPath);
+    }
+
+    File f = s_fs->open(kCurPath, FILE_APPEND);
+    if (!f) {
+        return;
+    }
+    const size_t written = f.write(reinterpret_cast<const uint8_t*>(s_batch.data), s_batch.len);
+    f.close();
+    if (written != s_batch.len) {
+        return;  // retried on the next due flush
+    }
+
+    s_batch.len = 0;
+    sealBatch();
+    s_urgent = false;
+    s_flushRequested = false;
+}
+
+void PersistentLog::requestFlush() {
+    s_flushRequested = true;
+}
+
+bool PersistentLog::isFlushPending() {
+    // Nothing can be written while detached: don't make callers wait for it
+    return s_flushRequested.load() && s_fs != nullptr;
+}
+
+size_t PersistentLog::size() {
+    if (!s_mutex) {
+        return 0;
+    }
+    Lock lock;
+    if (!s_fs) {
+        return 0;
+    }
+    return fileSize(*s_fs, kPrevPath) + fileSize(*s_fs, kCurPath);
+}
+
+size_t PersistentLog::read(size_t offset, uint8_t* out, size_t len) {
+    if (!s_mutex) {
+        return 0;
+    }
+    Lock lock;
+    if (!s_fs) {
+        return 0;
+    }
+
+    size_t done = 0;
+    const char* paths[] = {kPrevPath, kCurPath};
+    for (const char* path : paths) {
+        if (done == len) {
+            break;
+        }
+        File f = s_fs->open(path, "r");
+        if (!f) {
+            continue;
+        }
+        const size_t fsize = f.size();
+        if (offset >= fsize) {
+            offset -= fsize;
+            f.close();
+            continue;
+        }
+        f.seek(offset);
+        done += f.read(out + done, min(len - done, fsize - offset));
+        offset = 0;
+        f.close();
+    }
+    return done;
+}
+
+void PersistentLog::clear() {
+    if (!s_mutex) {
+        return;
+    }
+    Lock lock;
+    if (s_fs) {
+        s_fs->remove(kPrevPath);
+        s_fs->remove(kCurPath);
+    }
+}
+
+const char* PersistentLog::getResetReason() {
+    return s_resetReason;
+}
+
+uint32_t PersistentLog::getRecoveredBytes() {
+    return s_recoveredBytes;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// WARN+ log lines kept across resets, for field diagnosis without a serial console.
+// - Lines are batched in RTC memory that survives panic/watchdog/software resets, so what
+//   was not yet written when the device crashed is recovered on the next boot.
+// - Batches go to LittleFS every kFlushIntervalMs, when kFlushThresholdBytes are pending,
+//   kUrgentDelayMs after an ERROR, or on Log::flush(); this bounds flash writes.
+// - Two files of kFileBytes rotate (/logs/prev.log, /logs/cur.log): bounded size.
+// - Every boot records the reset reason.
+// append()/service() run on the log drain task only; read()/attach()/detach() are
+// serialized against it with a mutex.
+class PersistentLog {
+public:
+    static constexpr size_t kBatchBytes = 2048;
+    static constexpr size_t kFlushThresholdBytes = 1536;
+    static constexpr uint32_t kFlushIntervalMs = 30 * 1000;
+    static constexpr uint32_t kUrgentDelayMs = 2000;
+    static constexpr size_t kFileBytes = 32 * 1024;
+
+    // Early boot (from Log::begin): recover the RTC batch, record the reset reason
+    static void begin();
+    // Start/stop writing to the filesystem (after mount / before unmount)
+    static void attach(fs::FS& fs);
+    static void detach();
+
+    // Drain task
+    static void append(const char* data, size_t len, bool urgent);
+    static void service();
+
+    // Any task: write the pending batch on the drain task's next pass
+    static void requestFlush();
+    static bool isFlushPending();
+
+    // Concatenated prev + cur files
+    static size_t size();
+    static size_t read(size_t offset, uint8_t* out, size_t len);
+    static void clear();
+
+    static const char* getResetReason();
+    static uint32_t getRecoveredBytes();
+
+private:
+    static void flushLocked();
+};
@@ -2,6 +2,9 @@
 
 #include <Preferences.h>
 
+#include "Metrics.h"
+#include "Trace.h"
+
 namespace {
 constexpr const char* kNamespace = "vitrine";
 constexpr uint16_t kVersion = 1;
@@ -22,12 +25,23 @@ constexpr const char* kKeyWifiStaPass = "wStaP";
 constexpr const char* kKeyWifiApSsid = "wApS";
 constexpr const char* kKeyWifiApPass = "wApP";
 
+constexpr const char* kKeyEventsRateHz = "evHz";
+
+constexpr const char* kKeyMqttEnabled = "mqEn";
+constexpr const char* kKeyMqttHost = "mqHost";
+constexpr const char* kKeyMqttPort = "mqPort";
+constexpr const char* kKeyMqttUser = "mqUser";
+constexpr const char* kKeyMqttPass = "mqPass";
+
 constexpr const char* kKeyAmbientAllPct = "ambAll";
 constexpr const char* kKeyAmbientRndMaxPct = "ambRMax";
 constexpr const char* kKeyAmbientRndDensity = "ambRDen";
 constexpr const char* kKeyAmbientRndFrameMs = "ambRFms";
 constexpr const char* kKeyAmbientRndStep = "ambRStep";
 
+// One per save()/reset(); each Preferences put is its own NVS commit
+MetricCounter s_nvsWrites("vitrine_nvs_writes", "Settings writes to NVS (save/reset)");
+
 uint8_t clampPercent(int value) {
     if (value < 0) return 0;
     if (value > 100) return 100;
@@ -80,15 +94,26 @@ bool SettingsStore::load(DeviceSettings& out) {
     loadString(prefs, kKeyWifiApSsid, out.wifiApSsid, sizeof(out.wifiApSsid), out.wifiApSsid);
     loadString(prefs, kKeyWifiApPass, out.wifiApPass, sizeof(out.wifiApPass), out.wifiApPass);
 
+    const uint8_t eventsHz = prefs.getUChar(kKeyEventsRateHz, out.eventsMaxRateHz);
+    out.eventsMaxRateHz = (eventsHz == 0 || eventsHz > 20) ? out.eventsMaxRateHz : eventsHz;
+
+    out.mqttEnabled = prefs.getUChar(kKeyMqttEnabled, out.mqttEnabled ? 1 : 0) != 0;
+    loadString(prefs, kKeyMqttHost, out.mqttHost, sizeof(out.mqttHost), out.mqttHost);
+    out.mqttPort = prefs.getUShort(kKeyMqttPort, out.mqttPort);
+    loadString(prefs, kKeyMqttUser, out.mqttUser, sizeof(out.mqttUser), out.mqttUser);
+    loadString(prefs, kKeyMqttPass, out.mqttPass, sizeof(out.mqttPass), out.mqttPass);
+
     prefs.end();
     return true;
 }
 
 bool SettingsStore::save(const DeviceSettings& settings) {
+    TRACE_SCOPE("nvs.save");
     Preferences prefs;
     if (!prefs.begin(kNamespace, false)) {
         return false;
     }
+    s_nvsWrites.inc();
 
     prefs.putUShort(kKeyVersion, kVersion);
     prefs.putUShort(kKeySleepTimeoutMinutes, settings.sleepTimeoutMinutes);
@@ -112,15 +137,25 @@ bool SettingsStore::save(const DeviceSettings& settings) {
     prefs.putString(kKeyWifiApSsid, settings.wifiApSsid);
     prefs.putString(kKeyWifiApPass, settings.wifiApPass);
 
+    prefs.putUChar(kKeyEventsRateHz, settings.eventsMaxRateHz);
+
+    prefs.putUChar(kKeyMqttEnabled, settings.mqttEnabled ? 1 : 0);
+    prefs.putString(kKeyMqttHost, settings.mqttHost);
+    prefs.putUShort(kKeyMqttPort, settings.mqttPort);
+    prefs.putString(kKeyMqttUser, settings.mqttUser);
+    prefs.putString(kKeyMqttPass, settings.mqttPass);
+
     prefs.end();
     return true;
 }
 
 bool SettingsStore::reset() {
+    TRACE_SCOPE("nvs.reset");
     Preferences prefs;
     if (!prefs.begin(kNamespace, false)) {
         return false;
     }
+    s_nvsWrites.inc();
     const bool ok = prefs.clear();
     prefs.end();
     return ok;
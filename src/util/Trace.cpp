@@ -0,0 +1,144 @@
+#include "Trace.h"
+
+#include <esp_heap_caps.h>
+
+#include "Log.h"
+
+namespace {
+struct TaskEntry {
+    TaskHandle_t handle;
+    char name[16];
+};
+
+Trace::Event* s_events = nullptr;
+size_t s_capacity = 0;
+std::atomic<uint32_t> s_head{0};  // events recorded since start()
+
+portMUX_TYPE s_taskMux = portMUX_INITIALIZER_UNLOCKED;
+TaskEntry s_tasks[Trace::kMaxTasks];
+std::atomic<uint8_t> s_taskCount{0};
+
+bool allocEvents() {
+    if (s_events) {
+        return true;
+    }
+    // Prefer PSRAM: a trace is big and only lives while someone is looking at it
+    void* p = heap_caps_malloc(Trace::kCapacity * sizeof(Trace::Event), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    size_t capacity = Trace::kCapacity;
+    if (!p) {
+        p = malloc(Trace::kInternalCapacity * sizeof(Trace::Event));
+        capacity = Trace::kInternalCapacity;
+    }
+    if (!p) {
+        return false;
+    }
+    s_events = static_cast<Trace::Event*>(p);
+    s_capacity = capacity;
+    return true;
+}
+
+uint8_t taskIndex() {
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    const uint8_t n = s_taskCount.load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < n; i++) {
+        if (s_tasks[i].handle == self) {
+            return i;
+        }
+    }
+
+    // First event from this task: copy its name now (the task may be gone by export time)
+    portENTER_CRITICAL(&s_taskMux);
+    const uint8_t count = s_taskCount.load(std::memory_order_relaxed);
+    uint8_t index = count;
+    for (uint8_t i = n; i < count; i++) {
+        if (s_tasks[i].handle == self) {
+            index = i;
+            break;
+        }
+    }
+    if (index == count) {
+        if (count < Trace::kMaxTasks - 1) {
+            s_tasks[index].handle = self;
+            strncpy(s_tasks[index].name, pcTaskGetName(nullptr), sizeof(s_tasks[index].name) - 1);
+            s_tasks[index].name[sizeof(s_tasks[index].name) - 1] = '\0';
+            s_taskCount.store(count + 1, std::memory_order_release);
+        } else {
+            // Table full: everything else shares the last slot
+            index = Trace::kMaxTasks - 1;
+            if (count < Trace::kMaxTasks) {
+                s_tasks[index].handle = nullptr;
+                strcpy(s_tasks[index].name, "other");
+                s_taskCount.store(count + 1, std::memory_order_release);
+            }
+        }
+    }
+    portEXIT_CRITICAL(&s_taskMux);
+    return index;
+}
+} // namespace
+
+std::atomic<bool> Trace::s_running{false};
+
+bool Trace::start() {
+    s_running = false;
+    if (!allocEvents()) {
+        LOGE("trace", "No memory for the trace buffer");
+        return false;
+    }
+    s_head = 0;
+    portENTER_CRITICAL(&s_taskMux);
+    s_taskCount.store(0, std::memory_order_relaxed);
+    portEXIT_CRITICAL(&s_taskMux);
+    s_running = true;
+    LOGI("trace", "Capture started (%u events)", static_cast<unsigned>(s_capacity));
+    return true;
+}
+
+void Trace::stop() {
+    if (s_running.exchange(false)) {
+        LOGI("trace", "Capture stopped (%lu events)", (unsigned long)s_head.load());
+    }
+}
+
+void Trace::record(Phase phase, const char* name, int32_t arg) {
+    if (!isRunning()) {
+        return;
+    }
+    Event e;
+    e.tsUs = micros();
+    e.name = name;
+    e.arg = arg;
+    e.task = taskIndex();
+    e.core = static_cast<uint8_t>(xPortGetCoreID());
+    e.phase = phase;
+    const uint32_t slot = s_head.fetch_add(1, std::memory_order_relaxed);
+    s_events[slot % s_capacity] = e;
+}
+
+size_t Trace::count() {
+    const uint32_t n = s_head.load();
+    return (n < s_capacity) ? n : s_capacity;
+}
+
+bool Trace::getEvent(size_t i, Event& out) {
+    const uint32_t n = s_head.load();
+    if (i >= count()) {
+        return false;
+    }
+    const size_t oldest = (n <= s_capacity) ? 0 : n % s_capacity;
+    out = s_events[(oldest + i) % s_capacity];
+    return true;
+}
+
+uint32_t Trace::getOverwritten() {
+    const uint32_t n = s_head.load();
+    return (n > s_capacity) ? n - s_capacity : 0;
+}
+
+size_t Trace::taskCount() {
+    return s_taskCount.load(std::memory_order_acquire);
+}
+
+const char* Trace::taskName(size_t i) {
+    return i < taskCount() ? s_tasks[i].name : "?";
+}
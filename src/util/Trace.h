@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// -DTRACE_ENABLED=0 compiles every probe out (TRACE_SCOPE/TRACE_INSTANT expand to nothing)
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// Event trace, exported as Chrome Trace Event JSON (GET /api/trace, opens in ui.perfetto.dev).
+// - TRACE_SCOPE("led.show") records a begin/end pair, TRACE_INSTANT("ws.connect") a point
+//   event; each carries a microsecond timestamp, the FreeRTOS task and the core it ran on.
+// - Events go into a fixed ring allocated on the first start() (PSRAM preferred); once it
+//   wraps, the oldest events are overwritten.
+// - Names are stored as pointers: pass string literals that need no JSON escaping.
+// - Off by default and switchable at runtime (POST /api/trace); a disabled probe is one load.
+// Safe from any task (not from ISRs).
+class Trace {
+public:
+    static constexpr size_t kCapacity = 4096;         // events, when PSRAM is available
+    static constexpr size_t kInternalCapacity = 512;  // events, internal RAM fallback
+    static constexpr size_t kMaxTasks = 16;           // later tasks share the last slot
+
+    enum class Phase : uint8_t { Begin = 'B', End = 'E', Instant = 'i' };
+
+    struct Event {
+        uint32_t tsUs;
+        const char* name;
+        int32_t arg;
+        uint8_t task;  // taskName() index
+        uint8_t core;
+        Phase phase;
+    };
+
+    // Clears the ring and starts recording; false if the ring can't be allocated
+    static bool start();
+    static void stop();
+    static bool isRunning() { return s_running.load(std::memory_order_relaxed); }
+
+    static void record(Phase phase, const char* name, int32_t arg = 0);
+
+    // Reading: stop() first, or writers keep overwriting the oldest events.
+    static size_t count();
+    // i = 0 is the oldest event kept
+    static bool getEvent(size_t i, Event& out);
+    // Events lost to the ring wrapping since start()
+    static uint32_t getOverwritten();
+    static size_t taskCount();
+    static const char* taskName(size_t i);
+
+    class Scope {
+    public:
+        explicit Scope(const char* name, int32_t arg = 0) : name(isRunning() ? name : nullptr) {
+            if (this->name) {
+                record(Phase::Begin, name, arg);
+            }
+        }
+        ~Scope() {
+            if (name) {
+                record(Phase::End, name);
+            }
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* const name;  // nullptr when the begin event wasn't recorded
+    };
+
+private:
+    static std::atomic<bool> s_running;
+};
+
+#define TRACE_CONCAT2(A, B) A##B
+#define TRACE_CONCAT(A, B) TRACE_CONCAT2(A, B)
+
+#if TRACE_ENABLED
+#define TRACE_SCOPE(...) Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(__VA_ARGS__)
+#define TRACE_INSTANT(...) \
+    do { \
+        if (Trace::isRunning()) { \
+            Trace::record(Trace::Phase::Instant, __VA_ARGS__); \
+        } \
+    } while (0)
+#else
+#define TRACE_SCOPE(...) do { } while (0)
+#define TRACE_INSTANT(...) do { } while (0)
+#endif
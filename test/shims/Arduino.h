@@ -0,0 +1,68 @@
+#ifndef TEST_SHIM_ARDUINO_H
+#define TEST_SHIM_ARDUINO_H
+
+// Host stand-in for the parts of Arduino.h the tested modules use (native env only)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using std::max;
+using std::min;
+
+typedef bool boolean;
+
+class HardwareSerial;
+class Print;
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return static_cast<unsigned long>(duration_cast<microseconds>(steady_clock::now() - start).count());
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+// Flash reads (PubSubClient's publish_P) are plain loads on the host
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+
+// FreeRTOS critical sections as a spinlock
+struct portMUX_TYPE {
+    std::atomic<bool> locked;
+};
+#define portMUX_INITIALIZER_UNLOCKED {{false}}
+
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) {
+    while (mux->locked.exchange(true, std::memory_order_acquire)) {
+    }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+    mux->locked.store(false, std::memory_order_release);
+}
+
+// FreeRTOS tasks as detached threads: vTaskDelete(nullptr) returns, ending the thread function
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+#define pdPASS 1
+
+inline BaseType_t xTaskCreate(void (*fn)(void*), const char*, uint32_t, void* arg, UBaseType_t, TaskHandle_t*) {
+    std::thread(fn, arg).detach();
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t) {}
+
+#endif // TEST_SHIM_ARDUINO_H
@@ -0,0 +1,71 @@
+#ifndef TEST_SHIM_FS_H
+#define TEST_SHIM_FS_H
+
+// Fake Arduino filesystem: one flat root directory listed from a fixed table the test fills.
+// Only the calls the tested modules make; opening and iterating allocate nothing.
+
+#include <cstddef>
+
+namespace fs {
+struct FakeEntry {
+    const char* name;
+    size_t size;
+};
+
+class File {
+public:
+    File() = default;
+
+    explicit operator bool() const { return entries != nullptr; }
+
+    File openNextFile(const char* mode = "r") {
+        (void)mode;
+        File file;
+        if (entries && isDir && next < count) {
+            file.entries = entries + next;
+            file.count = 1;
+            next++;
+        }
+        return file;
+    }
+    const char* name() const { return entries ? entries->name : ""; }
+    size_t size() const { return entries && !isDir ? entries->size : 0; }
+    void close() { entries = nullptr; }
+
+private:
+    friend class FS;
+    const FakeEntry* entries = nullptr;  // the directory's table, or the file's own entry
+    size_t count = 0;
+    size_t next = 0;
+    bool isDir = false;
+};
+
+class FS {
+public:
+    void setRoot(const FakeEntry* entries, size_t count) {
+        rootEntries = entries;
+        rootCount = count;
+    }
+    bool failOpen = false;
+
+    File open(const char* path, const char* mode = "r", bool create = false) {
+        (void)path;
+        (void)mode;
+        (void)create;
+        File dir;
+        if (!failOpen) {
+            static const FakeEntry kRoot = {"/", 0};
+            dir.entries = rootCount ? rootEntries : &kRoot;
+            dir.count = rootCount;
+            dir.isDir = true;
+        }
+        return dir;
+    }
+
+private:
+    const FakeEntry* rootEntries = nullptr;
+    size_t rootCount = 0;
+};
+} // namespace fs
+
+#endif // TEST_SHIM_FS_H
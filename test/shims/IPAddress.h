@@ -0,0 +1,26 @@
+#ifndef TEST_SHIM_IPADDRESS_H
+#define TEST_SHIM_IPADDRESS_H
+
+// Host stand-in for Arduino's IPAddress (IPv4)
+
+#include <cstdint>
+
+class IPAddress {
+public:
+    IPAddress() : bytes{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes{a, b, c, d} {}
+
+    uint8_t operator[](int index) const { return bytes[index]; }
+    uint8_t& operator[](int index) { return bytes[index]; }
+    bool operator==(const IPAddress& other) const {
+        return bytes[0] == other.bytes[0] && bytes[1] == other.bytes[1] && bytes[2] == other.bytes[2] &&
+               bytes[3] == other.bytes[3];
+    }
+
+    uint8_t* raw_address() { return bytes; }
+
+private:
+    uint8_t bytes[4];
+};
+
+#endif // TEST_SHIM_IPADDRESS_H
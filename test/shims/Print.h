@@ -0,0 +1,31 @@
+#ifndef TEST_SHIM_PRINT_H
+#define TEST_SHIM_PRINT_H
+
+// Host stand-in for Arduino's Print: only the byte-writing interface
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size-- && write(*buffer++)) {
+            n++;
+        }
+        return n;
+    }
+
+    size_t write(const char* str) {
+        return str ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0;
+    }
+
+    virtual void flush() {}
+};
+
+#endif // TEST_SHIM_PRINT_H
@@ -0,0 +1,21 @@
+#ifndef TEST_SHIM_STREAM_H
+#define TEST_SHIM_STREAM_H
+
+// Host stand-in for Arduino's Stream: the byte-reading interface, without the parsing helpers
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+    unsigned long getTimeout() const { return timeout; }
+
+protected:
+    unsigned long timeout = 1000;
+};
+
+#endif // TEST_SHIM_STREAM_H
@@ -0,0 +1,75 @@
+#ifndef TEST_SHIM_UPDATE_H
+#define TEST_SHIM_UPDATE_H
+
+// Fake Arduino Update backend: records what reaches flash and fails on request.
+// The test defines the instance (UpdateClass Update;) and resets it between cases.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+class UpdateClass {
+public:
+    // Test knobs
+    bool failBegin = false;
+    size_t failWriteAfter = SIZE_MAX;  // bytes accepted before write() comes up short
+    bool failEnd = false;
+
+    // What happened
+    bool begun = false;
+    bool committed = false;
+    bool aborted = false;
+    int command = -1;
+    size_t beginSize = 0;
+    std::vector<uint8_t> flash;
+
+    void reset() { *this = UpdateClass(); }
+
+    bool begin(size_t size, int cmd = U_FLASH) {
+        if (failBegin) {
+            error = "Bad Size Given";
+            return false;
+        }
+        begun = true;
+        command = cmd;
+        beginSize = size;
+        return true;
+    }
+
+    size_t write(uint8_t* data, size_t len) {
+        if (!begun || committed || aborted) {
+            return 0;
+        }
+        const size_t room = flash.size() < failWriteAfter ? failWriteAfter - flash.size() : 0;
+        const size_t n = len < room ? len : room;
+        flash.insert(flash.end(), data, data + n);
+        if (n < len) {
+            error = "Flash Write Failed";
+        }
+        return n;
+    }
+
+    bool end(bool evenIfRemaining = false) {
+        if (!begun || aborted || failEnd || !evenIfRemaining) {
+            error = "Magic Byte Failed";
+            return false;
+        }
+        committed = true;
+        return true;
+    }
+
+    void abort() { aborted = true; }
+
+    const char* errorString() const { return error; }
+
+private:
+    const char* error = "No Error";
+};
+
+extern UpdateClass Update;
+
+#endif // TEST_SHIM_UPDATE_H
@@ -0,0 +1,135 @@
+#ifndef TEST_SHIM_WIFICLIENT_H
+#define TEST_SHIM_WIFICLIENT_H
+
+// Host stand-in for the ESP32 WiFiClient: a blocking POSIX TCP socket behind Arduino's Client.
+// connect() resolves the host and gives up after the same 3 s default as the device.
+
+#include <Client.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class WiFiClient : public Client {
+public:
+    static constexpr int kConnectTimeoutMs = 3000;
+
+    ~WiFiClient() { stop(); }
+
+    int connect(IPAddress ip, uint16_t port) override {
+        char host[16];
+        snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        return connect(host, port);
+    }
+
+    int connect(const char* host, uint16_t port) override {
+        stop();
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        char service[8];
+        snprintf(service, sizeof(service), "%u", port);
+        if (getaddrinfo(host, service, &hints, &res) != 0 || !res) {
+            return 0;
+        }
+        const int s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if (s < 0) {
+            freeaddrinfo(res);
+            return 0;
+        }
+
+        // Non-blocking connect bounded by the timeout, then back to blocking
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+        int rc = ::connect(s, res->ai_addr, res->ai_addrlen);
+        freeaddrinfo(res);
+        if (rc != 0 && errno == EINPROGRESS) {
+            pollfd pfd = {s, POLLOUT, 0};
+            int err = 0;
+            socklen_t errLen = sizeof(err);
+            rc = (poll(&pfd, 1, kConnectTimeoutMs) == 1 &&
+                  getsockopt(s, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 && err == 0)
+                     ? 0
+                     : -1;
+        }
+        if (rc != 0) {
+            close(s);
+            return 0;
+        }
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL) & ~O_NONBLOCK);
+        const int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fd = s;
+        return 1;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        size_t sent = 0;
+        while (fd >= 0 && sent < size) {
+            const ssize_t n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return sent;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return sent;
+    }
+
+    int available() override {
+        int n = 0;
+        return (fd >= 0 && ioctl(fd, FIONREAD, &n) == 0) ? n : 0;
+    }
+
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    int read(uint8_t* buf, size_t size) override {
+        if (available() <= 0) {
+            return -1;
+        }
+        const ssize_t n = recv(fd, buf, size, 0);
+        return n > 0 ? static_cast<int>(n) : -1;
+    }
+
+    int peek() override {
+        uint8_t c;
+        return (fd >= 0 && recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1) ? c : -1;
+    }
+
+    void flush() override {}
+
+    // Closes without a goodbye: the broker sees the connection drop
+    void stop() override {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    uint8_t connected() override {
+        if (fd < 0) {
+            return 0;
+        }
+        uint8_t c;
+        const ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        return (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) ? 1 : 0;
+    }
+
+    operator bool() override { return connected(); }
+
+private:
+    int fd = -1;
+};
+
+#endif // TEST_SHIM_WIFICLIENT_H
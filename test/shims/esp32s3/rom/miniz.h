@@ -0,0 +1,72 @@
+#ifndef TEST_SHIM_ROM_MINIZ_H
+#define TEST_SHIM_ROM_MINIZ_H
+
+// Host stand-in for the ROM tinfl API, backed by zlib's raw inflate (link with -lz).
+// Same contract as tinfl with a TINFL_LZ_DICT_SIZE ring: output goes to next_out, at most
+// *out_size bytes, and HAS_MORE_OUTPUT is returned when that space ran out.
+// zlib's state lives in an arena inside the decompressor, so free() on it (as with tinfl)
+// releases everything.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+
+typedef enum {
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+struct tinfl_decompressor_tag {
+    z_stream stream;
+    size_t arenaUsed;
+    alignas(16) uint8_t arena[48 * 1024];  // inflate state + 32 KB window
+};
+typedef struct tinfl_decompressor_tag tinfl_decompressor;
+
+inline voidpf tinfl_shim_alloc(voidpf opaque, uInt items, uInt size) {
+    tinfl_decompressor* r = static_cast<tinfl_decompressor*>(opaque);
+    const size_t bytes = (static_cast<size_t>(items) * size + 15) & ~static_cast<size_t>(15);
+    if (bytes > sizeof(r->arena) - r->arenaUsed) {
+        return Z_NULL;
+    }
+    void* p = r->arena + r->arenaUsed;
+    r->arenaUsed += bytes;
+    return p;
+}
+
+inline void tinfl_shim_free(voidpf, voidpf) {}
+
+inline void tinfl_init(tinfl_decompressor* r) {
+    memset(&r->stream, 0, sizeof(r->stream));
+    r->arenaUsed = 0;
+    r->stream.zalloc = tinfl_shim_alloc;
+    r->stream.zfree = tinfl_shim_free;
+    r->stream.opaque = r;
+    inflateInit2(&r->stream, -15);
+}
+
+inline tinfl_status tinfl_decompress(tinfl_decompressor* r, const uint8_t* in, size_t* in_size, uint8_t*,
+                                     uint8_t* next_out, size_t* out_size, uint32_t) {
+    r->stream.next_in = const_cast<Bytef*>(in);
+    r->stream.avail_in = static_cast<uInt>(*in_size);
+    r->stream.next_out = next_out;
+    r->stream.avail_out = static_cast<uInt>(*out_size);
+    const int ret = inflate(&r->stream, Z_NO_FLUSH);
+    *in_size -= r->stream.avail_in;
+    *out_size -= r->stream.avail_out;
+    if (ret == Z_STREAM_END) {
+        return TINFL_STATUS_DONE;
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        return TINFL_STATUS_FAILED;
+    }
+    return r->stream.avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_NEEDS_MORE_INPUT;
+}
+
+#endif // TEST_SHIM_ROM_MINIZ_H
@@ -0,0 +1,16 @@
+#ifndef TEST_SHIM_ESP_HEAP_CAPS_H
+#define TEST_SHIM_ESP_HEAP_CAPS_H
+
+// Host stand-in: every capability maps to the regular heap
+
+#include <cstdlib>
+
+#define MALLOC_CAP_SPIRAM 0
+#define MALLOC_CAP_INTERNAL 0
+#define MALLOC_CAP_8BIT 0
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+#endif // TEST_SHIM_ESP_HEAP_CAPS_H
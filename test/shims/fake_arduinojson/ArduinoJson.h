@@ -0,0 +1,112 @@
+#ifndef TEST_SHIM_ARDUINOJSON_H
+#define TEST_SHIM_ARDUINOJSON_H
+
+// Fake ArduinoJson 7 for host tests of custom allocators (JsonArena/JsonPool): the real
+// Allocator interface and a JsonDocument that drives it the way ArduinoJson does. A slot
+// pool is allocated on first use, strings are built by growing reallocs and shrunk to fit,
+// shrinkToFit() reallocates the pool down, and clear() or destruction frees everything.
+// The JSON it "serializes" is filler of the right length.
+
+#include <cstddef>
+#include <cstring>
+
+namespace ArduinoJson {
+class Allocator {
+public:
+    virtual void* allocate(size_t size) = 0;
+    virtual void deallocate(void* ptr) = 0;
+    virtual void* reallocate(void* ptr, size_t new_size) = 0;
+
+protected:
+    ~Allocator() = default;
+};
+} // namespace ArduinoJson
+
+class JsonDocument {
+public:
+    static constexpr size_t kPoolBytes = 1024;
+    static constexpr size_t kMaxStrings = 16;
+
+    explicit JsonDocument(ArduinoJson::Allocator* alloc) : alloc(alloc) {}
+    ~JsonDocument() { clear(); }
+
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    // Adds a string value; false when out of memory
+    bool add(const char* value) {
+        if (!pool) {
+            pool = alloc->allocate(kPoolBytes);
+            if (!pool) {
+                return false;
+            }
+        }
+        if (stringCount == kMaxStrings) {
+            return false;
+        }
+        const size_t len = strlen(value);
+        size_t capacity = 31;
+        char* s = static_cast<char*>(alloc->allocate(capacity + 1));
+        for (size_t i = 0; s && i < len; i++) {
+            if (i == capacity) {
+                capacity = capacity * 2 + 1;
+                s = static_cast<char*>(alloc->reallocate(s, capacity + 1));
+                if (!s) {
+                    return false;
+                }
+            }
+            s[i] = value[i];
+        }
+        if (!s) {
+            return false;
+        }
+        s = static_cast<char*>(alloc->reallocate(s, len + 1));
+        s[len] = '\0';
+        strings[stringCount++] = s;
+        jsonLength += len + 3;  // quotes and separator
+        return true;
+    }
+
+    void shrinkToFit() {
+        if (pool) {
+            pool = alloc->reallocate(pool, 16 * (stringCount + 1));
+        }
+    }
+
+    void clear() {
+        for (size_t i = 0; i < stringCount; i++) {
+            alloc->deallocate(strings[i]);
+        }
+        stringCount = 0;
+        if (pool) {
+            alloc->deallocate(pool);
+            pool = nullptr;
+        }
+        jsonLength = 2;
+    }
+
+    size_t jsonSize() const { return jsonLength; }
+
+private:
+    ArduinoJson::Allocator* alloc;
+    void* pool = nullptr;
+    char* strings[kMaxStrings];
+    size_t stringCount = 0;
+    size_t jsonLength = 2;  // []
+};
+
+inline size_t measureJson(const JsonDocument& doc) {
+    return doc.jsonSize();
+}
+
+inline size_t serializeJson(const JsonDocument& doc, char* output, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    const size_t n = doc.jsonSize() < size - 1 ? doc.jsonSize() : size - 1;
+    memset(output, 'x', n);
+    output[n] = '\0';
+    return n;
+}
+
+#endif // TEST_SHIM_ARDUINOJSON_H
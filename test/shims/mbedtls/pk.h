@@ -0,0 +1,60 @@
+#ifndef TEST_SHIM_MBEDTLS_PK_H
+#define TEST_SHIM_MBEDTLS_PK_H
+
+// Host stand-in for mbedtls_pk signature checks. There is no real crypto: a "signature" is
+// valid when it is the digest with every byte XORed with kFakeSignatureMask, and the only
+// key that parses is the one in test/shims/ota_signing_key.h.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define MBEDTLS_ERR_PK_KEY_INVALID_FORMAT -0x3D00
+#define MBEDTLS_ERR_PK_BAD_INPUT_DATA -0x3E80
+#define MBEDTLS_ERR_ECP_VERIFY_FAILED -0x4E00
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+
+struct mbedtls_pk_context {
+    bool parsed;
+};
+
+namespace pk_shim {
+constexpr uint8_t kFakeSignatureMask = 0x5A;
+constexpr const char* kFakeKeyBody = "HOST-TEST-KEY";
+} // namespace pk_shim
+
+inline void mbedtls_pk_init(mbedtls_pk_context* ctx) {
+    ctx->parsed = false;
+}
+
+inline void mbedtls_pk_free(mbedtls_pk_context* ctx) {
+    ctx->parsed = false;
+}
+
+inline int mbedtls_pk_parse_public_key(mbedtls_pk_context* ctx, const unsigned char* key, size_t keylen) {
+    // Like mbedtls, PEM input must include the terminating NUL in keylen
+    if (keylen == 0 || key[keylen - 1] != '\0' || !strstr(reinterpret_cast<const char*>(key), pk_shim::kFakeKeyBody)) {
+        return MBEDTLS_ERR_PK_KEY_INVALID_FORMAT;
+    }
+    ctx->parsed = true;
+    return 0;
+}
+
+inline int mbedtls_pk_verify(mbedtls_pk_context* ctx, mbedtls_md_type_t md, const unsigned char* hash, size_t hashLen,
+                             const unsigned char* sig, size_t sigLen) {
+    if (!ctx->parsed || md != MBEDTLS_MD_SHA256) {
+        return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+    }
+    if (sigLen != hashLen) {
+        return MBEDTLS_ERR_ECP_VERIFY_FAILED;
+    }
+    for (size_t i = 0; i < hashLen; i++) {
+        if (sig[i] != (hash[i] ^ pk_shim::kFakeSignatureMask)) {
+            return MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        }
+    }
+    return 0;
+}
+
+#endif // TEST_SHIM_MBEDTLS_PK_H
@@ -0,0 +1,8 @@
+#pragma once
+
+// Host tests only: makes OtaWriter require signatures, checked by the mbedtls/pk.h shim
+
+#define OTA_SIGNING_PUBKEY_PEM \
+"-----BEGIN PUBLIC KEY-----\n" \
+"HOST-TEST-KEY\n" \
+"-----END PUBLIC KEY-----\n"
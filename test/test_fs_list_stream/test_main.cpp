@@ -0,0 +1,160 @@
+#include <unity.h>
+
+#include <cstdio>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "net/FsListStream.cpp"
+#include "util/JsonEscape.cpp"
+
+// FsListStream over the fake filesystem in test/shims/FS.h: exact output for small listings
+// and edge cases, and a large listing streamed with no allocation and a fixed-size state.
+
+namespace {
+size_t g_newCalls = 0;
+
+// Streams the whole document in maxLen pieces
+std::string streamAll(FsListStream& stream, size_t maxLen) {
+    std::string out;
+    std::vector<uint8_t> chunk(maxLen);
+    for (;;) {
+        const size_t n = stream.fill(chunk.data(), maxLen);
+        if (n == 0) {
+            break;
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(maxLen, n);
+        out.append(reinterpret_cast<const char*>(chunk.data()), n);
+    }
+    return out;
+}
+} // namespace
+
+void* operator new(size_t size) {
+    g_newCalls++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_unmounted() {
+    FsListStream stream(nullptr);
+    TEST_ASSERT_EQUAL_STRING("{\"mounted\":false,\"files\":[]}", streamAll(stream, 64).c_str());
+}
+
+void test_root_open_failure() {
+    fs::FS fs;
+    fs.failOpen = true;
+    FsListStream stream(&fs);
+    TEST_ASSERT_EQUAL_STRING("{\"mounted\":true,\"files\":[],\"error\":\"Failed to open LittleFS root\"}",
+                             streamAll(stream, 64).c_str());
+}
+
+void test_empty_root() {
+    fs::FS fs;
+    FsListStream stream(&fs);
+    TEST_ASSERT_EQUAL_STRING("{\"mounted\":true,\"files\":[]}", streamAll(stream, 64).c_str());
+}
+
+void test_names_are_escaped_and_oversized_entries_skipped() {
+    const std::string longName(200, 'n');
+    const fs::FakeEntry entries[] = {
+        {longName.c_str(), 1},
+        {"index.html.gz", 1234},
+        {"a\"b\\c.txt", 5},
+        {"ctl\x01.bin", 0},
+        {longName.c_str(), 2},
+        {"app.js", 4000000000u},
+    };
+    fs::FS fs;
+    fs.setRoot(entries, sizeof(entries) / sizeof(entries[0]));
+
+    const char* expected =
+        "{\"mounted\":true,\"files\":["
+        "{\"name\":\"index.html.gz\",\"size\":1234},"
+        "{\"name\":\"a\\\"b\\\\c.txt\",\"size\":5},"
+        "{\"name\":\"ctl\\u0001.bin\",\"size\":0},"
+        "{\"name\":\"app.js\",\"size\":4000000000}"
+        "]}";
+    // Any chunk size produces the same document
+    const size_t chunkSizes[] = {1, 7, 64, 1436, 8192};
+    for (size_t maxLen : chunkSizes) {
+        FsListStream stream(&fs);
+        TEST_ASSERT_EQUAL_STRING(expected, streamAll(stream, maxLen).c_str());
+    }
+}
+
+void test_large_listing_streams_in_flat_memory() {
+    const size_t kFiles = 20000;
+    static char names[kFiles][32];
+    static fs::FakeEntry entries[kFiles];
+    size_t expectedBytes = strlen("{\"mounted\":true,\"files\":[") + strlen("]}");
+    for (size_t i = 0; i < kFiles; i++) {
+        snprintf(names[i], sizeof(names[i]), "assets/chunk-%05u.js.gz", static_cast<unsigned>(i));
+        entries[i].name = names[i];
+        entries[i].size = 1000 + i;
+        char entry[96];
+        expectedBytes += snprintf(entry, sizeof(entry), "{\"name\":\"%s\",\"size\":%u}", names[i],
+                                  static_cast<unsigned>(entries[i].size)) +
+                         (i ? 1 : 0);
+    }
+    fs::FS fs;
+    fs.setRoot(entries, kFiles);
+
+    // The response callback's view: a fixed buffer per call, nothing kept between calls
+    static uint8_t chunk[1436];
+    FsListStream stream(&fs);
+    const size_t newCallsBefore = g_newCalls;
+    size_t total = 0;
+    size_t calls = 0;
+    size_t entryCount = 0;
+    uint8_t last = 0;
+    for (;;) {
+        const size_t n = stream.fill(chunk, sizeof(chunk));
+        if (n == 0) {
+            break;
+        }
+        if (calls == 0) {
+            TEST_ASSERT_EQUAL_STRING_LEN("{\"mounted\":true,\"files\":[", reinterpret_cast<const char*>(chunk), 25);
+        }
+        for (size_t i = 0; i < n; i++) {
+            entryCount += (chunk[i] == '{') ? 1 : 0;
+        }
+        last = chunk[n - 1];
+        total += n;
+        calls++;
+    }
+    TEST_ASSERT_EQUAL(newCallsBefore, g_newCalls);
+    TEST_ASSERT_EQUAL(expectedBytes, total);
+    TEST_ASSERT_EQUAL(kFiles + 1, entryCount);  // plus the outer object
+    TEST_ASSERT_EQUAL('}', last);
+    TEST_ASSERT_GREATER_THAN(kFiles / 30, calls);
+
+    // The whole working set is the stream object, whatever the listing size
+    TEST_ASSERT_LESS_OR_EQUAL(256, sizeof(FsListStream));
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u files: %u bytes in %u chunks, state %u bytes, 0 allocations",
+             static_cast<unsigned>(kFiles), static_cast<unsigned>(total), static_cast<unsigned>(calls),
+             static_cast<unsigned>(sizeof(FsListStream)));
+    TEST_MESSAGE(message);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unmounted);
+    RUN_TEST(test_root_open_failure);
+    RUN_TEST(test_empty_root);
+    RUN_TEST(test_names_are_escaped_and_oversized_entries_skipped);
+    RUN_TEST(test_large_listing_streams_in_flat_memory);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+#include <unity.h>
+
+#include <cstring>
+
+#include "util/JsonEscape.cpp"
+
+// The bounded escaper shared by OtaProgress, WsLogStream and FsListStream. Every outcome is
+// checked against a canary past outSize so an overrun shows up as a failed assertion.
+
+namespace {
+constexpr char kCanary = '#';
+
+struct Out {
+    char buf[64];
+    Out() { memset(buf, kCanary, sizeof(buf)); }
+    bool untouchedFrom(size_t from) const {
+        for (size_t i = from; i < sizeof(buf); i++) {
+            if (buf[i] != kCanary) return false;
+        }
+        return true;
+    }
+};
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_plain_text_is_copied() {
+    Out out;
+    TEST_ASSERT_EQUAL(5, json_escape::escape(out.buf, 16, "hello", 5));
+    TEST_ASSERT_EQUAL_STRING("hello", out.buf);
+    TEST_ASSERT_TRUE(out.untouchedFrom(16));
+}
+
+void test_quotes_backslashes_and_controls_are_escaped() {
+    Out out;
+    const char in[] = "a\"b\\c\n\x01";
+    const size_t len = json_escape::escape(out.buf, sizeof(out.buf), in, sizeof(in) - 1);
+    TEST_ASSERT_EQUAL_STRING("a\\\"b\\\\c\\u000a\\u0001", out.buf);
+    TEST_ASSERT_EQUAL(strlen(out.buf), len);
+}
+
+void test_length_bounds_the_input_not_nul() {
+    Out out;
+    const char in[] = {'a', '\0', 'b'};
+    TEST_ASSERT_EQUAL(8, json_escape::escape(out.buf, sizeof(out.buf), in, sizeof(in)));
+    TEST_ASSERT_EQUAL_MEMORY("a\\u0000b", out.buf, 9);
+}
+
+void test_escape_fails_whole_when_it_does_not_fit() {
+    // "ab\"" escapes to 4 bytes and needs 5 with the NUL
+    Out exact;
+    TEST_ASSERT_EQUAL(4, json_escape::escape(exact.buf, 5, "ab\"", 3));
+    TEST_ASSERT_EQUAL_STRING("ab\\\"", exact.buf);
+
+    Out tight;
+    TEST_ASSERT_EQUAL(0, json_escape::escape(tight.buf, 4, "ab\"", 3));
+    TEST_ASSERT_EQUAL_STRING("", tight.buf);
+    TEST_ASSERT_TRUE(tight.untouchedFrom(4));
+
+    // A control escape is six bytes and never split
+    Out control;
+    TEST_ASSERT_EQUAL(6, json_escape::escape(control.buf, 7, "\n", 1));
+    TEST_ASSERT_EQUAL(0, json_escape::escape(control.buf, 6, "\n", 1));
+    TEST_ASSERT_EQUAL_STRING("", control.buf);
+}
+
+void test_truncated_stops_before_the_first_escape_that_does_not_fit() {
+    Out out;
+    TEST_ASSERT_EQUAL(2, json_escape::escapeTruncated(out.buf, 4, "ab\"cd", 5));
+    TEST_ASSERT_EQUAL_STRING("ab", out.buf);
+    TEST_ASSERT_TRUE(out.untouchedFrom(4));
+
+    Out fits;
+    TEST_ASSERT_EQUAL(3, json_escape::escapeTruncated(fits.buf, 8, "abc", 3));
+    TEST_ASSERT_EQUAL_STRING("abc", fits.buf);
+}
+
+void test_empty_input_and_tiny_buffers() {
+    Out empty;
+    TEST_ASSERT_EQUAL(0, json_escape::escape(empty.buf, 8, "", 0));
+    TEST_ASSERT_EQUAL_STRING("", empty.buf);
+
+    Out one;
+    TEST_ASSERT_EQUAL(0, json_escape::escape(one.buf, 1, "a", 1));
+    TEST_ASSERT_EQUAL_STRING("", one.buf);
+    TEST_ASSERT_TRUE(one.untouchedFrom(1));
+
+    Out none;
+    TEST_ASSERT_EQUAL(0, json_escape::escape(none.buf, 0, "a", 1));
+    TEST_ASSERT_EQUAL(0, json_escape::escapeTruncated(none.buf, 0, "a", 1));
+    TEST_ASSERT_TRUE(none.untouchedFrom(0));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_plain_text_is_copied);
+    RUN_TEST(test_quotes_backslashes_and_controls_are_escaped);
+    RUN_TEST(test_length_bounds_the_input_not_nul);
+    RUN_TEST(test_escape_fails_whole_when_it_does_not_fit);
+    RUN_TEST(test_truncated_stops_before_the_first_escape_that_does_not_fit);
+    RUN_TEST(test_empty_input_and_tiny_buffers);
+    return UNITY_END();
+}
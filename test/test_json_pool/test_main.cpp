@@ -0,0 +1,263 @@
+#include <unity.h>
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <string>
+
+// JsonArena and JsonPool with the fake ArduinoJson in test/shims/fake_arduinojson. Every heap
+// call JsonPool.cpp makes (arena fallback, foreign reallocs, oversized output buffers) is counted
+// by routing its malloc/realloc through the counters below; document memory otherwise only comes
+// from the arenas. The pool's begin() allocations go through heap_caps_malloc and are not counted.
+
+namespace {
+size_t g_heapAllocs = 0;
+
+void* countedMalloc(size_t size) {
+    g_heapAllocs++;
+    return std::malloc(size);
+}
+
+void* countedRealloc(void* ptr, size_t size) {
+    g_heapAllocs++;
+    return std::realloc(ptr, size);
+}
+} // namespace
+
+#define malloc countedMalloc
+#define realloc countedRealloc
+#include "net/JsonPool.cpp"
+#undef malloc
+#undef realloc
+
+// Metrics registration is not under test
+void Metrics::add(Metric*) {}
+Metric::Metric(Type type, const char* name, const char* help, const char* labels)
+    : type(type), name(name), help(help), labels(labels) {}
+
+namespace {
+uint32_t totalMisses() {
+    return s_docMisses.value() + s_arenaMisses.value() + s_bufferMisses.value();
+}
+
+struct ArenaFixture {
+    alignas(8) uint8_t mem[512];
+    JsonArena arena;
+
+    ArenaFixture() { arena.attach(mem, sizeof(mem)); }
+    bool inArena(const void* p) const { return p >= mem && p < mem + sizeof(mem); }
+};
+} // namespace
+
+void setUp() {
+    g_heapAllocs = 0;
+}
+void tearDown() {}
+
+void test_arena_grows_the_top_block_in_place() {
+    ArenaFixture f;
+    void* a = f.arena.allocate(10);
+    TEST_ASSERT_TRUE(f.inArena(a));
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(a) % 8);
+    memset(a, 'a', 10);
+    const size_t used = f.arena.getUsed();
+
+    void* grown = f.arena.reallocate(a, 100);
+    TEST_ASSERT_TRUE(grown == a);
+    TEST_ASSERT_GREATER_THAN(used, f.arena.getUsed());
+    TEST_ASSERT_EQUAL('a', static_cast<char*>(grown)[9]);
+    const size_t grownUsed = f.arena.getUsed();
+
+    void* shrunk = f.arena.reallocate(grown, 4);
+    TEST_ASSERT_TRUE(shrunk == a);
+    TEST_ASSERT_TRUE(f.arena.getUsed() < used);
+    TEST_ASSERT_EQUAL(grownUsed, f.arena.getPeak());
+    TEST_ASSERT_EQUAL(0, g_heapAllocs);
+}
+
+void test_arena_keeps_lower_blocks_on_shrink_and_moves_them_on_grow() {
+    ArenaFixture f;
+    char* a = static_cast<char*>(f.arena.allocate(64));
+    void* b = f.arena.allocate(16);
+    memcpy(a, "lower block", 12);
+
+    TEST_ASSERT_TRUE(f.arena.reallocate(a, 32) == a);
+
+    char* moved = static_cast<char*>(f.arena.reallocate(a, 128));
+    TEST_ASSERT_TRUE(f.inArena(moved));
+    TEST_ASSERT_TRUE(moved > static_cast<char*>(b));
+    TEST_ASSERT_EQUAL_STRING("lower block", moved);
+    TEST_ASSERT_EQUAL(0, g_heapAllocs);
+}
+
+void test_arena_pops_freed_blocks_at_the_top() {
+    ArenaFixture f;
+    void* a = f.arena.allocate(24);
+    const size_t afterA = f.arena.getUsed();
+    void* b = f.arena.allocate(24);
+    const size_t afterB = f.arena.getUsed();
+    void* c = f.arena.allocate(24);
+
+    f.arena.deallocate(c);
+    TEST_ASSERT_EQUAL(afterB, f.arena.getUsed());
+
+    // A hole below the top stays until the blocks above it are gone
+    f.arena.deallocate(a);
+    TEST_ASSERT_EQUAL(afterB, f.arena.getUsed());
+    f.arena.deallocate(b);
+    TEST_ASSERT_EQUAL(0, f.arena.getUsed());
+
+    // Freed space is reused
+    TEST_ASSERT_TRUE(f.arena.allocate(24) == a);
+    TEST_ASSERT_EQUAL(afterA, f.arena.getUsed());
+    f.arena.deallocate(nullptr);
+    TEST_ASSERT_EQUAL(0, g_heapAllocs);
+}
+
+void test_arena_falls_back_to_the_heap_when_full() {
+    ArenaFixture f;
+    const uint32_t missesBefore = s_arenaMisses.value();
+    void* a = f.arena.allocate(400);
+    TEST_ASSERT_TRUE(f.inArena(a));
+
+    void* big = f.arena.allocate(200);
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_FALSE(f.inArena(big));
+    TEST_ASSERT_EQUAL(1, g_heapAllocs);
+    TEST_ASSERT_EQUAL(missesBefore + 1, s_arenaMisses.value());
+
+    // Growing the top block past the end moves it to the heap, contents intact
+    memset(a, 'z', 400);
+    char* moved = static_cast<char*>(f.arena.reallocate(a, 1000));
+    TEST_ASSERT_FALSE(f.inArena(moved));
+    TEST_ASSERT_EQUAL('z', moved[399]);
+    TEST_ASSERT_EQUAL(2, g_heapAllocs);
+
+    // Heap blocks are reallocated and freed on the heap
+    big = f.arena.reallocate(big, 300);
+    TEST_ASSERT_FALSE(f.inArena(big));
+    TEST_ASSERT_EQUAL(3, g_heapAllocs);
+    f.arena.deallocate(big);
+    f.arena.deallocate(moved);
+    TEST_ASSERT_EQUAL(0, f.arena.getUsed());
+}
+
+void test_unattached_arena_is_plain_heap() {
+    JsonArena arena;
+    const uint32_t missesBefore = s_arenaMisses.value();
+    void* p = arena.allocate(32);
+    TEST_ASSERT_NOT_NULL(p);
+    p = arena.reallocate(p, 64);
+    arena.deallocate(p);
+    TEST_ASSERT_EQUAL(2, g_heapAllocs);
+    TEST_ASSERT_EQUAL(missesBefore, s_arenaMisses.value());
+}
+
+void test_pool_leases_and_heap_fallback() {
+    TEST_ASSERT_TRUE(JsonPool::begin());
+    TEST_ASSERT_TRUE(JsonPool::begin());
+
+    JsonArena* leased[JsonPool::kDocs];
+    for (size_t i = 0; i < JsonPool::kDocs; i++) {
+        leased[i] = JsonPool::acquireArena();
+        TEST_ASSERT_NOT_NULL(leased[i]);
+    }
+    TEST_ASSERT_NULL(JsonPool::acquireArena());
+
+    // With every arena leased a document still works, on the heap, and is counted
+    const uint32_t docMisses = s_docMisses.value();
+    {
+        PooledJsonDocument doc;
+        TEST_ASSERT_TRUE(doc.add("fallback"));
+    }
+    TEST_ASSERT_EQUAL(docMisses + 1, s_docMisses.value());
+    TEST_ASSERT_GREATER_THAN(0, g_heapAllocs);
+
+    for (size_t i = 0; i < JsonPool::kDocs; i++) {
+        JsonPool::releaseArena(leased[i]);
+    }
+
+    char* buffers[JsonPool::kBuffers];
+    for (size_t i = 0; i < JsonPool::kBuffers; i++) {
+        buffers[i] = JsonPool::acquireBuffer();
+        TEST_ASSERT_NOT_NULL(buffers[i]);
+    }
+    TEST_ASSERT_NULL(JsonPool::acquireBuffer());
+    for (size_t i = 0; i < JsonPool::kBuffers; i++) {
+        JsonPool::releaseBuffer(buffers[i]);
+    }
+}
+
+void test_steady_state_makes_no_heap_allocations() {
+    TEST_ASSERT_TRUE(JsonPool::begin());
+    const uint32_t missesBefore = totalMisses();
+    const std::string longValue(300, 'v');
+
+    for (int round = 0; round < 10000; round++) {
+        // A WebSocket reply: request document, reply document, serialized reply
+        PooledJsonDocument request;
+        TEST_ASSERT_TRUE(request.add("setMode"));
+        TEST_ASSERT_TRUE(request.add(longValue.c_str()));
+        request.shrinkToFit();
+        {
+            PooledJsonDocument reply;
+            TEST_ASSERT_TRUE(reply.add("ok"));
+            TEST_ASSERT_TRUE(reply.add("ambient"));
+            PooledJsonBuffer out;
+            TEST_ASSERT_TRUE(out.serialize(reply));
+            TEST_ASSERT_EQUAL(reply.jsonSize(), out.length());
+            TEST_ASSERT_EQUAL(out.length(), strlen(out.c_str()));
+        }
+        // A broadcast built while the request is still in scope
+        PooledJsonDocument broadcast;
+        TEST_ASSERT_TRUE(broadcast.add("state"));
+        PooledJsonBuffer out;
+        TEST_ASSERT_TRUE(out.serialize(broadcast));
+    }
+
+    TEST_ASSERT_EQUAL(0, g_heapAllocs);
+    TEST_ASSERT_EQUAL(missesBefore, totalMisses());
+    TEST_ASSERT_GREATER_THAN(0, s_arenaPeak.value());
+    TEST_ASSERT_LESS_OR_EQUAL(static_cast<int32_t>(JsonPool::kDocArenaBytes), s_arenaPeak.value());
+}
+
+void test_oversized_documents_and_output_fall_back_to_the_heap() {
+    TEST_ASSERT_TRUE(JsonPool::begin());
+    const uint32_t arenaMisses = s_arenaMisses.value();
+    const uint32_t bufferMisses = s_bufferMisses.value();
+    const std::string big(3000, 'y');
+    {
+        PooledJsonDocument doc;
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(doc.add(big.c_str()));
+        }
+        PooledJsonBuffer out;
+        TEST_ASSERT_TRUE(out.serialize(doc));
+        TEST_ASSERT_EQUAL(doc.jsonSize(), out.length());
+    }
+    TEST_ASSERT_GREATER_THAN(arenaMisses, s_arenaMisses.value());
+    TEST_ASSERT_EQUAL(bufferMisses + 1, s_bufferMisses.value());
+
+    // Leases came back: the next document is allocation-free again
+    g_heapAllocs = 0;
+    {
+        PooledJsonDocument doc;
+        TEST_ASSERT_TRUE(doc.add("small"));
+        PooledJsonBuffer out;
+        TEST_ASSERT_TRUE(out.serialize(doc));
+    }
+    TEST_ASSERT_EQUAL(0, g_heapAllocs);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_arena_grows_the_top_block_in_place);
+    RUN_TEST(test_arena_keeps_lower_blocks_on_shrink_and_moves_them_on_grow);
+    RUN_TEST(test_arena_pops_freed_blocks_at_the_top);
+    RUN_TEST(test_arena_falls_back_to_the_heap_when_full);
+    RUN_TEST(test_unattached_arena_is_plain_heap);
+    RUN_TEST(test_pool_leases_and_heap_fallback);
+    RUN_TEST(test_steady_state_makes_no_heap_allocations);
+    RUN_TEST(test_oversized_documents_and_output_fall_back_to_the_heap);
+    return UNITY_END();
+}
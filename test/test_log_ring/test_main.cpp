@@ -0,0 +1,162 @@
+#include <unity.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "util/LogRing.h"
+
+// LogRing with concurrent producers and the single drain consumer, as Log.cpp uses it.
+// Producers write "<producer> <sequence>"; the consumer checks every line arrives intact and,
+// per producer, in order.
+
+namespace {
+constexpr int kProducers = 6;
+constexpr int kLinesPerProducer = 100000;
+constexpr size_t kSlotBytes = 32;
+
+using Ring = LogRing<64, kSlotBytes>;
+
+struct DrainResult {
+    uint64_t received = 0;
+    uint64_t malformed = 0;
+    uint64_t outOfOrder = 0;
+};
+
+// Runs the producers against one consumer. With retryWhenFull the producers spin on a full
+// ring (nothing may be lost); otherwise a full ring drops the line and counts it.
+DrainResult runProducers(Ring& ring, bool retryWhenFull, uint64_t& dropped) {
+    std::atomic<bool> producing{true};
+    std::atomic<uint64_t> drops{0};
+    DrainResult result;
+
+    std::thread consumer([&]() {
+        int last[kProducers];
+        for (int p = 0; p < kProducers; p++) {
+            last[p] = -1;
+        }
+        while (producing.load() || !ring.empty()) {
+            while (Ring::Slot* slot = ring.peek()) {
+                char line[kSlotBytes + 1];
+                memcpy(line, slot->data, slot->len);
+                line[slot->len] = '\0';
+                int producer = -1;
+                int seq = -1;
+                if (sscanf(line, "%d %d", &producer, &seq) != 2 || producer < 0 || producer >= kProducers ||
+                    slot->kind != producer) {
+                    result.malformed++;
+                } else if (seq <= last[producer]) {
+                    result.outOfOrder++;
+                } else {
+                    last[producer] = seq;
+                }
+                result.received++;
+                ring.release(slot);
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < kLinesPerProducer; i++) {
+                uint32_t ticket;
+                Ring::Slot* slot = ring.claim(ticket);
+                if (!slot) {
+                    if (retryWhenFull) {
+                        i--;
+                        std::this_thread::yield();
+                    } else {
+                        drops++;
+                    }
+                    continue;
+                }
+                const int len = snprintf(slot->data, kSlotBytes, "%d %d", p, i);
+                ring.commit(slot, ticket, static_cast<size_t>(len), static_cast<uint8_t>(p));
+            }
+        });
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    producing = false;
+    consumer.join();
+
+    dropped = drops.load();
+    return result;
+}
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_line_arrives_in_order_when_producers_wait() {
+    static Ring ring;
+    uint64_t dropped = 0;
+    const DrainResult result = runProducers(ring, true, dropped);
+
+    TEST_ASSERT_EQUAL_UINT64(0, dropped);
+    TEST_ASSERT_EQUAL_UINT64(static_cast<uint64_t>(kProducers) * kLinesPerProducer, result.received);
+    TEST_ASSERT_EQUAL_UINT64(0, result.malformed);
+    TEST_ASSERT_EQUAL_UINT64(0, result.outOfOrder);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+void test_full_ring_drops_are_accounted_for() {
+    static Ring ring;
+    uint64_t dropped = 0;
+    const DrainResult result = runProducers(ring, false, dropped);
+
+    // Drops are lines that were never claimed: nothing claimed is lost or torn
+    TEST_ASSERT_EQUAL_UINT64(static_cast<uint64_t>(kProducers) * kLinesPerProducer, result.received + dropped);
+    TEST_ASSERT_EQUAL_UINT64(0, result.malformed);
+    TEST_ASSERT_EQUAL_UINT64(0, result.outOfOrder);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+void test_claim_fails_when_full_and_recovers_after_release() {
+    static LogRing<4, 8> ring;
+    uint32_t tickets[4];
+    LogRing<4, 8>::Slot* slots[4];
+    for (int i = 0; i < 4; i++) {
+        slots[i] = ring.claim(tickets[i]);
+        TEST_ASSERT_NOT_NULL(slots[i]);
+    }
+    uint32_t ticket;
+    TEST_ASSERT_NULL(ring.claim(ticket));
+
+    // Committed out of order: the consumer still sees them in claim order
+    for (int i = 3; i >= 0; i--) {
+        slots[i]->data[0] = static_cast<char>('a' + i);
+        ring.commit(slots[i], tickets[i], 1);
+    }
+    for (int i = 0; i < 4; i++) {
+        LogRing<4, 8>::Slot* slot = ring.peek();
+        TEST_ASSERT_NOT_NULL(slot);
+        TEST_ASSERT_EQUAL('a' + i, slot->data[0]);
+        ring.release(slot);
+    }
+    TEST_ASSERT_NULL(ring.peek());
+    TEST_ASSERT_NOT_NULL(ring.claim(ticket));
+}
+
+void test_commit_clamps_length_to_slot() {
+    static LogRing<2, 8> ring;
+    uint32_t ticket;
+    LogRing<2, 8>::Slot* slot = ring.claim(ticket);
+    TEST_ASSERT_NOT_NULL(slot);
+    ring.commit(slot, ticket, 100);
+    TEST_ASSERT_EQUAL(8, ring.peek()->len);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_line_arrives_in_order_when_producers_wait);
+    RUN_TEST(test_full_ring_drops_are_accounted_for);
+    RUN_TEST(test_claim_fails_when_full_and_recovers_after_release);
+    RUN_TEST(test_commit_clamps_length_to_slot);
+    return UNITY_END();
+}
@@ -0,0 +1,346 @@
+#include <unity.h>
+
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+#include <WiFiClient.h>
+
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "net/MqttManager.cpp"
+
+// MqttManager against a real broker on localhost:1883 (mosquitto -p 1883), run with
+// pio test -e native_mqtt. A second PubSubClient (the observer) records what the manager
+// publishes and sends it commands. The manager's clock is the test's, so the per-topic
+// interval is exact; the network runs in real time. Every test gets a fresh node id, and
+// tearDown clears what it left retained. All tests are ignored when no broker is listening.
+
+namespace {
+constexpr const char* kBrokerHost = "127.0.0.1";
+constexpr uint16_t kBrokerPort = 1883;
+constexpr uint32_t kWaitMs = 5000;
+// Quiet period that shows nothing else is coming
+constexpr uint32_t kSettleMs = 300;
+
+struct Received {
+    std::string topic;
+    std::string payload;
+};
+
+struct Command {
+    std::string name;
+    std::string value;
+};
+
+bool brokerUp = false;
+bool wifiUp = true;
+uint32_t testNowMs = 100000;
+
+WiFiClient observerNet;
+PubSubClient observer(observerNet);
+std::vector<Received> received;
+
+void onObserved(char* topic, uint8_t* payload, unsigned int len) {
+    received.push_back({topic, std::string(reinterpret_cast<const char*>(payload), len)});
+}
+
+struct Harness {
+    WiFiClient net;
+    MqttManager mqtt{net, []() { return wifiUp; }, []() { return testNowMs; }};
+    uint8_t mac[6] = {0x24, 0x0a, 0xc4, 0, 0, 0};
+    char node[16];
+    char base[32];
+
+    std::vector<Command> commands;
+    bool acceptCommands = true;
+    int samples = 0;
+    int changedTicks = 0;
+
+    explicit Harness(uint8_t serial) {
+        const unsigned pid = static_cast<unsigned>(getpid());
+        mac[3] = static_cast<uint8_t>(pid >> 8);
+        mac[4] = static_cast<uint8_t>(pid);
+        mac[5] = serial;
+        snprintf(node, sizeof(node), "vitrine_%02x%02x%02x", mac[3], mac[4], mac[5]);
+        snprintf(base, sizeof(base), "vitrine/%s", node);
+
+        mqtt.setDevice([this]() { samples++; },
+                       [this](const char* name, const char* value) {
+                           commands.push_back({name, value});
+                           return acceptCommands;
+                       });
+        DeviceSettings settings;
+        settings.mqttEnabled = true;
+        strncpy(settings.mqttHost, kBrokerHost, sizeof(settings.mqttHost) - 1);
+        settings.mqttPort = kBrokerPort;
+        mqtt.begin(settings, mac);
+    }
+
+    std::string topic(const char* suffix) const { return std::string(base) + suffix; }
+};
+
+Harness* h = nullptr;
+uint8_t testSerial = 0;
+
+// Runs the manager (unless paused) and the observer until done() or timeoutMs of real time
+template <typename Done>
+bool pumpUntil(Done done, uint32_t timeoutMs, bool tickManager = true) {
+    const unsigned long start = millis();
+    while (!done()) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        if (tickManager && h->mqtt.tick()) {
+            h->changedTicks++;
+        }
+        observer.loop();
+        usleep(2000);
+    }
+    return true;
+}
+
+void settle(bool tickManager = true) {
+    pumpUntil([]() { return false; }, kSettleMs, tickManager);
+}
+
+bool connectManager() {
+    return pumpUntil([]() { return h->mqtt.getState() == MqttManager::State::Connected; }, kWaitMs);
+}
+
+std::vector<std::string> payloadsOn(const std::string& topic) {
+    std::vector<std::string> out;
+    for (const Received& r : received) {
+        if (r.topic == topic) {
+            out.push_back(r.payload);
+        }
+    }
+    return out;
+}
+
+void observe(const std::string& filter) {
+    TEST_ASSERT_TRUE(observer.subscribe(filter.c_str()));
+}
+
+void clearRetained(const std::string& topic) {
+    observer.publish(topic.c_str(), reinterpret_cast<const uint8_t*>(""), 0, true);
+}
+} // namespace
+
+void setUp() {
+    if (!brokerUp) {
+        TEST_IGNORE_MESSAGE("No MQTT broker on localhost:1883 (run mosquitto -p 1883)");
+    }
+    wifiUp = true;
+    h = new Harness(++testSerial);
+    received.clear();
+}
+
+void tearDown() {
+    if (!h) {
+        return;
+    }
+    // The connect task holds the manager until it reports back; then leave with DISCONNECT
+    // (no will) and drop everything the node left retained
+    pumpUntil([]() { return h->mqtt.getState() != MqttManager::State::Connecting; }, kWaitMs);
+    wifiUp = false;
+    h->mqtt.tick();
+    static const char* const kConfigs[] = {"light/%s/light", "number/%s/focus", "select/%s/ambient", "switch/%s/sleep"};
+    for (const char* config : kConfigs) {
+        char object[64];
+        snprintf(object, sizeof(object), config, h->node);
+        clearRetained(std::string("homeassistant/") + object + "/config");
+    }
+    for (const char* name : kStateNames) {
+        clearRetained(h->topic("/state/") + name);
+    }
+    clearRetained(h->topic("/availability"));
+    settle(false);
+    delete h;
+    h = nullptr;
+}
+
+void test_discovery_configs_are_retained_and_complete() {
+    TEST_ASSERT_TRUE(connectManager());
+    // Subscribing only now: the configs can only arrive as retained messages
+    observe(std::string("homeassistant/+/") + h->node + "/+/config");
+    std::vector<Received> configs;
+    auto collect = [&]() {
+        configs.clear();
+        for (const Received& r : received) {
+            if (r.topic.find(h->node) != std::string::npos) {
+                configs.push_back(r);
+            }
+        }
+        return configs.size() >= 4;
+    };
+    TEST_ASSERT_TRUE(pumpUntil(collect, kWaitMs));
+    settle();
+    collect();
+    TEST_ASSERT_EQUAL(4, configs.size());
+
+    for (const Received& r : configs) {
+        char component[16];
+        char object[16];
+        char fmt[64];
+        snprintf(fmt, sizeof(fmt), "homeassistant/%%15[^/]/%s/%%15[^/]/config", h->node);
+        TEST_ASSERT_EQUAL_MESSAGE(2, sscanf(r.topic.c_str(), fmt, component, object), r.topic.c_str());
+
+        JsonDocument doc;
+        TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, r.payload), r.topic.c_str());
+        const std::string uniqueId = std::string(h->node) + "_" + object;
+        TEST_ASSERT_EQUAL_STRING(h->base, doc["~"].as<const char*>());
+        TEST_ASSERT_EQUAL_STRING(uniqueId.c_str(), doc["unique_id"].as<const char*>());
+        TEST_ASSERT_EQUAL_STRING("~/availability", doc["availability_topic"].as<const char*>());
+        TEST_ASSERT_EQUAL_STRING((std::string("~/state/") + object).c_str(), doc["state_topic"].as<const char*>());
+        TEST_ASSERT_EQUAL_STRING((std::string("~/cmd/") + object).c_str(), doc["command_topic"].as<const char*>());
+        TEST_ASSERT_EQUAL_STRING(h->node, doc["device"]["identifiers"][0].as<const char*>());
+        TEST_ASSERT_EQUAL_STRING(FIRMWARE_VERSION, doc["device"]["sw_version"].as<const char*>());
+
+        if (strcmp(component, "light") == 0) {
+            TEST_ASSERT_EQUAL_STRING("light", object);
+            TEST_ASSERT_EQUAL_STRING("~/cmd/brightness", doc["brightness_command_topic"].as<const char*>());
+            TEST_ASSERT_EQUAL(100, doc["brightness_scale"].as<int>());
+        } else if (strcmp(component, "number") == 0) {
+            TEST_ASSERT_EQUAL_STRING("focus", object);
+            TEST_ASSERT_EQUAL(1, doc["min"].as<int>());
+            TEST_ASSERT_EQUAL(MAX_MINIATURES, doc["max"].as<int>());
+        } else if (strcmp(component, "select") == 0) {
+            TEST_ASSERT_EQUAL_STRING("ambient", object);
+            TEST_ASSERT_EQUAL(3, doc["options"].size());
+        } else {
+            TEST_ASSERT_EQUAL_STRING("switch", component);
+            TEST_ASSERT_EQUAL_STRING("sleep", object);
+        }
+    }
+}
+
+void test_state_topics_are_coalesced_per_topic() {
+    observe(h->topic("/state/+"));
+    TEST_ASSERT_TRUE(connectManager());
+    const std::string brightness = h->topic("/state/brightness");
+    const std::string focus = h->topic("/state/focus");
+
+    h->mqtt.setState(MqttManager::TopicBrightness, "10");
+    TEST_ASSERT_TRUE(pumpUntil([&]() { return payloadsOn(brightness).size() == 1; }, kWaitMs));
+
+    // Within 500 ms of that publish only the latest value is kept...
+    testNowMs += 100;
+    h->mqtt.setState(MqttManager::TopicBrightness, "20");
+    h->mqtt.tick();
+    testNowMs += 100;
+    h->mqtt.setState(MqttManager::TopicBrightness, "30");
+    // ...while another topic goes out at once
+    h->mqtt.setState(MqttManager::TopicFocus, "3");
+    testNowMs += 299;
+    settle();
+    TEST_ASSERT_EQUAL(1, payloadsOn(brightness).size());
+    TEST_ASSERT_EQUAL(1, payloadsOn(focus).size());
+
+    testNowMs += 1;
+    TEST_ASSERT_TRUE(pumpUntil([&]() { return payloadsOn(brightness).size() == 2; }, kWaitMs));
+    // Unchanged values are not republished
+    testNowMs += 1000;
+    h->mqtt.setState(MqttManager::TopicBrightness, "30");
+    settle();
+
+    const std::vector<std::string> values = payloadsOn(brightness);
+    TEST_ASSERT_EQUAL(2, values.size());
+    TEST_ASSERT_EQUAL_STRING("10", values[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("30", values[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("3", payloadsOn(focus)[0].c_str());
+}
+
+void test_lwt_marks_offline_and_reconnect_marks_online() {
+    observe(h->topic("/availability"));
+    TEST_ASSERT_TRUE(connectManager());
+    const std::string availability = h->topic("/availability");
+    TEST_ASSERT_TRUE(pumpUntil([&]() { return payloadsOn(availability).size() == 1; }, kWaitMs));
+    TEST_ASSERT_EQUAL_STRING("online", payloadsOn(availability)[0].c_str());
+
+    // Drop the socket without DISCONNECT; the manager stays paused until the broker sends the will
+    h->net.stop();
+    TEST_ASSERT_TRUE(pumpUntil([&]() { return payloadsOn(availability).size() == 2; }, kWaitMs, false));
+    TEST_ASSERT_EQUAL_STRING("offline", payloadsOn(availability)[1].c_str());
+
+    TEST_ASSERT_TRUE(pumpUntil([&]() { return payloadsOn(availability).size() == 3; }, kWaitMs));
+    TEST_ASSERT_EQUAL_STRING("online", payloadsOn(availability)[2].c_str());
+    TEST_ASSERT_EQUAL(MqttManager::State::Connected, h->mqtt.getState());
+    TEST_ASSERT_EQUAL(2, h->mqtt.getReconnectCount());
+}
+
+void test_event_queue_drops_oldest_while_offline() {
+    wifiUp = false;
+    for (int i = 1; i <= 20; i++) {
+        h->mqtt.publishEvent("press", i);
+        h->mqtt.tick();
+    }
+    TEST_ASSERT_EQUAL(MqttManager::State::WaitingForWifi, h->mqtt.getState());
+    TEST_ASSERT_EQUAL(4, h->mqtt.getDroppedEvents());
+
+    const std::string events = h->topic("/event");
+    observe(events);
+    wifiUp = true;
+    TEST_ASSERT_TRUE(connectManager());
+    TEST_ASSERT_TRUE(pumpUntil([&]() { return payloadsOn(events).size() >= 16; }, kWaitMs));
+    settle();
+
+    const std::vector<std::string> payloads = payloadsOn(events);
+    TEST_ASSERT_EQUAL(16, payloads.size());
+    for (int i = 0; i < 16; i++) {
+        char expected[48];
+        snprintf(expected, sizeof(expected), "{\"event\":\"press\",\"value\":%d}", i + 5);
+        TEST_ASSERT_EQUAL_STRING(expected, payloads[i].c_str());
+    }
+}
+
+void test_commands_reach_the_handler() {
+    TEST_ASSERT_TRUE(connectManager());
+    settle();
+    const int samplesBefore = h->samples;
+
+    // Accepted: the tick reports a UI change and the state is sampled again to echo it
+    observer.publish(h->topic("/cmd/brightness").c_str(), "55");
+    TEST_ASSERT_TRUE(pumpUntil([]() { return h->commands.size() == 1; }, kWaitMs));
+    TEST_ASSERT_EQUAL_STRING("brightness", h->commands[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("55", h->commands[0].value.c_str());
+    TEST_ASSERT_EQUAL(1, h->changedTicks);
+    TEST_ASSERT_EQUAL(samplesBefore + 1, h->samples);
+
+    // Rejected by the handler: no change reported, no echo. Deeper topics don't match cmd/+,
+    // and values are cut to 15 bytes
+    h->acceptCommands = false;
+    observer.publish(h->topic("/cmd/light/extra").c_str(), "ON");
+    observer.publish(h->topic("/cmd/bogus").c_str(), "12345678901234567890");
+    TEST_ASSERT_TRUE(pumpUntil([]() { return h->commands.size() == 2; }, kWaitMs));
+    settle();
+    TEST_ASSERT_EQUAL(2, h->commands.size());
+    TEST_ASSERT_EQUAL_STRING("bogus", h->commands[1].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("123456789012345", h->commands[1].value.c_str());
+    TEST_ASSERT_EQUAL(1, h->changedTicks);
+    TEST_ASSERT_EQUAL(samplesBefore + 1, h->samples);
+}
+
+int main(int, char**) {
+    WiFiClient probe;
+    brokerUp = probe.connect(kBrokerHost, kBrokerPort) == 1;
+    probe.stop();
+    if (brokerUp) {
+        char clientId[32];
+        snprintf(clientId, sizeof(clientId), "vitrine-test-%u", static_cast<unsigned>(getpid()));
+        observer.setServer(kBrokerHost, kBrokerPort);
+        observer.setBufferSize(1024);
+        observer.setCallback(onObserved);
+        brokerUp = observer.connect(clientId);
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_discovery_configs_are_retained_and_complete);
+    RUN_TEST(test_state_topics_are_coalesced_per_topic);
+    RUN_TEST(test_lwt_marks_offline_and_reconnect_marks_online);
+    RUN_TEST(test_event_queue_drops_oldest_while_offline);
+    RUN_TEST(test_commands_reach_the_handler);
+    const int failures = UNITY_END();
+    observer.disconnect();
+    return failures;
+}
@@ -0,0 +1,241 @@
+#include <unity.h>
+
+#include <random>
+#include <vector>
+#include <zlib.h>
+
+#include "net/OtaInflater.cpp"
+
+// OtaInflater on the host: zlib produces the gzip streams, and the ROM tinfl API is the zlib
+// shim in test/shims. Round trips use random chunk sizes (down to single bytes, as the upload
+// handler may see them); the fuzz cases must never crash and never report success with
+// data that differs from the original image.
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+std::mt19937 rng;
+
+struct GzipOptions {
+    bool name = false;
+    bool comment = false;
+    bool extra = false;
+    bool headerCrc = false;
+};
+
+Bytes gzip(const Bytes& in, const GzipOptions& options = GzipOptions()) {
+    z_stream s;
+    memset(&s, 0, sizeof(s));
+    deflateInit2(&s, 9, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY);
+
+    char name[] = "firmware.bin";
+    char comment[] = "vitrine";
+    Bytef extra[] = {'V', 'T', 2, 0, 0xAB, 0xCD};
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    header.name = options.name ? reinterpret_cast<Bytef*>(name) : Z_NULL;
+    header.comment = options.comment ? reinterpret_cast<Bytef*>(comment) : Z_NULL;
+    header.extra = options.extra ? extra : Z_NULL;
+    header.extra_len = options.extra ? sizeof(extra) : 0;
+    header.hcrc = options.headerCrc ? 1 : 0;
+    deflateSetHeader(&s, &header);
+
+    Bytes out(deflateBound(&s, in.size()) + 64);
+    s.next_in = const_cast<Bytef*>(in.data());
+    s.avail_in = static_cast<uInt>(in.size());
+    s.next_out = out.data();
+    s.avail_out = static_cast<uInt>(out.size());
+    deflate(&s, Z_FINISH);
+    out.resize(s.total_out);
+    deflateEnd(&s);
+    return out;
+}
+
+// Firmware-like content: long repeated runs mixed with noise
+Bytes makeImage(size_t size) {
+    static const char kText[] = "ESP32-S3 vitrine image ";
+    Bytes image(size);
+    for (size_t i = 0; i < size; i++) {
+        image[i] = (rng() % 4 == 0) ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>(kText[i % (sizeof(kText) - 1)]);
+    }
+    return image;
+}
+
+struct Result {
+    bool ok;
+    bool finished;
+    Bytes out;
+};
+
+Result inflateChunked(const Bytes& gz, size_t maxChunk) {
+    Result result = {true, false, Bytes()};
+    OtaInflater inflater;
+    TEST_ASSERT_TRUE(inflater.begin());
+    const OtaInflater::Sink sink = [&result](const uint8_t* data, size_t len) {
+        result.out.insert(result.out.end(), data, data + len);
+        return true;
+    };
+    size_t pos = 0;
+    while (pos < gz.size() && result.ok) {
+        size_t chunk = 1 + rng() % maxChunk;
+        chunk = min(chunk, gz.size() - pos);
+        result.ok = inflater.feed(gz.data() + pos, chunk, sink);
+        pos += chunk;
+    }
+    result.finished = inflater.isFinished();
+    if (result.ok && result.finished) {
+        TEST_ASSERT_EQUAL(gz.size(), inflater.getCompressedBytes());
+        TEST_ASSERT_EQUAL(result.out.size(), inflater.getInflatedBytes());
+    }
+    return result;
+}
+} // namespace
+
+void setUp() {
+    rng.seed(1);
+}
+void tearDown() {}
+
+void test_detects_gzip_magic() {
+    const Bytes gz = gzip(makeImage(100));
+    TEST_ASSERT_TRUE(OtaInflater::isGzip(gz.data(), gz.size()));
+    const uint8_t image[] = {0xE9, 0x05, 0x02, 0x20};  // ESP image header
+    TEST_ASSERT_FALSE(OtaInflater::isGzip(image, sizeof(image)));
+    TEST_ASSERT_FALSE(OtaInflater::isGzip(gz.data(), 2));
+}
+
+void test_round_trip_random_chunks() {
+    for (int i = 0; i < 60; i++) {
+        const Bytes image = makeImage(rng() % 300000);
+        const Result result = inflateChunked(gzip(image), (i % 3 == 0) ? 7 : 4096);
+        TEST_ASSERT_TRUE(result.ok);
+        TEST_ASSERT_TRUE(result.finished);
+        TEST_ASSERT_TRUE(result.out == image);
+    }
+}
+
+void test_round_trip_larger_than_window() {
+    // Several wraps of the 32 KB ring in one feed
+    const Bytes image = makeImage(1200 * 1024);
+    const Result result = inflateChunked(gzip(image), 64 * 1024);
+    TEST_ASSERT_TRUE(result.ok);
+    TEST_ASSERT_TRUE(result.finished);
+    TEST_ASSERT_TRUE(result.out == image);
+}
+
+void test_round_trip_optional_header_fields() {
+    for (int flags = 0; flags < 16; flags++) {
+        GzipOptions options;
+        options.name = flags & 1;
+        options.comment = flags & 2;
+        options.extra = flags & 4;
+        options.headerCrc = flags & 8;
+        const Bytes image = makeImage(5000);
+        const Result result = inflateChunked(gzip(image, options), 3);
+        TEST_ASSERT_TRUE(result.ok);
+        TEST_ASSERT_TRUE(result.finished);
+        TEST_ASSERT_TRUE(result.out == image);
+    }
+}
+
+void test_empty_image() {
+    const Result result = inflateChunked(gzip(Bytes()), 16);
+    TEST_ASSERT_TRUE(result.ok);
+    TEST_ASSERT_TRUE(result.finished);
+    TEST_ASSERT_EQUAL(0, result.out.size());
+}
+
+void test_trailing_bytes_are_ignored() {
+    const Bytes image = makeImage(20000);
+    Bytes gz = gzip(image);
+    gz.insert(gz.end(), 100, 0xFF);
+    const Result result = inflateChunked(gz, 512);
+    TEST_ASSERT_TRUE(result.ok);
+    TEST_ASSERT_TRUE(result.finished);
+    TEST_ASSERT_TRUE(result.out == image);
+}
+
+void test_rejects_non_gzip() {
+    Bytes data = makeImage(64);
+    data[0] = 0xE9;
+    OtaInflater inflater;
+    TEST_ASSERT_TRUE(inflater.begin());
+    TEST_ASSERT_FALSE(inflater.feed(data.data(), data.size(), [](const uint8_t*, size_t) { return true; }));
+    TEST_ASSERT_EQUAL_STRING("Not a gzip/deflate stream", inflater.getError());
+}
+
+void test_sink_failure_stops_the_stream() {
+    const Bytes gz = gzip(makeImage(100000));
+    OtaInflater inflater;
+    TEST_ASSERT_TRUE(inflater.begin());
+    size_t calls = 0;
+    const bool ok = inflater.feed(gz.data(), gz.size(), [&calls](const uint8_t*, size_t) { return ++calls < 2; });
+    TEST_ASSERT_FALSE(ok);
+    TEST_ASSERT_EQUAL(2, calls);
+    TEST_ASSERT_EQUAL_STRING("Write failed", inflater.getError());
+    TEST_ASSERT_FALSE(inflater.feed(gz.data(), 1, [](const uint8_t*, size_t) { return true; }));
+}
+
+void test_truncated_stream_never_finishes() {
+    const Bytes image = makeImage(50000);
+    const Bytes gz = gzip(image);
+    for (int i = 0; i < 200; i++) {
+        Bytes cut(gz.begin(), gz.begin() + rng() % gz.size());
+        const Result result = inflateChunked(cut, 1024);
+        TEST_ASSERT_FALSE(result.finished);
+        // Whatever came out so far is a prefix of the image
+        TEST_ASSERT_TRUE(result.out.size() <= image.size());
+        TEST_ASSERT_TRUE(std::equal(result.out.begin(), result.out.end(), image.begin()));
+    }
+}
+
+void test_corrupt_stream_is_rejected_or_identical() {
+    int rejected = 0;
+    for (int i = 0; i < 500; i++) {
+        const Bytes image = makeImage(rng() % 50000);
+        Bytes gz = gzip(image);
+        const int flips = 1 + rng() % 4;
+        for (int f = 0; f < flips; f++) {
+            gz[rng() % gz.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+        }
+        if (rng() % 4 == 0) {
+            gz.resize(rng() % gz.size());
+        }
+        const Result result = inflateChunked(gz, 2048);
+        if (!result.ok || !result.finished) {
+            rejected++;
+        } else {
+            // A flip in an ignored header field (MTIME, XFL, OS) is harmless
+            TEST_ASSERT_TRUE(result.out == image);
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(400, rejected);
+}
+
+void test_random_garbage_after_header() {
+    for (int i = 0; i < 300; i++) {
+        Bytes data = gzip(Bytes());
+        data.resize(10);
+        for (int n = 0; n < 2000; n++) {
+            data.push_back(static_cast<uint8_t>(rng()));
+        }
+        const Result result = inflateChunked(data, 300);
+        TEST_ASSERT_FALSE(result.ok && result.finished);
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_detects_gzip_magic);
+    RUN_TEST(test_round_trip_random_chunks);
+    RUN_TEST(test_round_trip_larger_than_window);
+    RUN_TEST(test_round_trip_optional_header_fields);
+    RUN_TEST(test_empty_image);
+    RUN_TEST(test_trailing_bytes_are_ignored);
+    RUN_TEST(test_rejects_non_gzip);
+    RUN_TEST(test_sink_failure_stops_the_stream);
+    RUN_TEST(test_truncated_stream_never_finishes);
+    RUN_TEST(test_corrupt_stream_is_rejected_or_identical);
+    RUN_TEST(test_random_garbage_after_header);
+    return UNITY_END();
+}
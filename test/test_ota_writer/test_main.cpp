@@ -0,0 +1,304 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "net/OtaWriter.cpp"
+
+// OtaWriter against the fake Update backend in test/shims/Update.h. The shims' signing key
+// makes signatures mandatory here, as on a device built with include/ota_signing_key.h;
+// a valid fake signature is the digest XORed with pk_shim::kFakeSignatureMask.
+
+UpdateClass Update;
+
+namespace {
+using Bytes = std::vector<uint8_t>;
+
+std::string toHex(const uint8_t* data, size_t len) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < len; i++) {
+        out += kHex[data[i] >> 4];
+        out += kHex[data[i] & 0x0F];
+    }
+    return out;
+}
+
+Bytes makeImage(size_t size) {
+    Bytes image(size);
+    uint32_t x = 12345;
+    for (size_t i = 0; i < size; i++) {
+        x = x * 1103515245u + 12345u;
+        image[i] = static_cast<uint8_t>(x >> 16);
+    }
+    return image;
+}
+
+void digestOf(const Bytes& image, uint8_t digest[32]) {
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, image.data(), image.size());
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+}
+
+std::string sha256Hex(const Bytes& image) {
+    uint8_t digest[32];
+    digestOf(image, digest);
+    return toHex(digest, sizeof(digest));
+}
+
+std::string signatureHex(const Bytes& image) {
+    uint8_t digest[32];
+    digestOf(image, digest);
+    for (uint8_t& b : digest) {
+        b ^= pk_shim::kFakeSignatureMask;
+    }
+    return toHex(digest, sizeof(digest));
+}
+
+bool writeChunked(OtaWriter& writer, const Bytes& image, size_t chunk) {
+    for (size_t pos = 0; pos < image.size(); pos += chunk) {
+        const size_t n = min(chunk, image.size() - pos);
+        if (!writer.write(image.data() + pos, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+void setUp() {
+    Update.reset();
+}
+void tearDown() {}
+
+void test_sha256_shim_matches_known_vectors() {
+    const char abc[] = "abc";
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+                             sha256Hex(Bytes(abc, abc + 3)).c_str());
+    TEST_ASSERT_EQUAL_STRING("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+                             sha256Hex(Bytes()).c_str());
+    const char two[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+                             sha256Hex(Bytes(two, two + sizeof(two) - 1)).c_str());
+}
+
+void test_signed_image_is_committed() {
+    const Bytes image = makeImage(200 * 1024 + 17);
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), sha256Hex(image).c_str(), signatureHex(image).c_str()));
+    TEST_ASSERT_TRUE(writer.isActive());
+    TEST_ASSERT_EQUAL(image.size(), Update.beginSize);
+    TEST_ASSERT_TRUE(writeChunked(writer, image, 1436));
+    TEST_ASSERT_TRUE(writer.end());
+
+    TEST_ASSERT_TRUE(Update.committed);
+    TEST_ASSERT_FALSE(Update.aborted);
+    TEST_ASSERT_TRUE(Update.flash == image);
+    TEST_ASSERT_FALSE(writer.isActive());
+    TEST_ASSERT_EQUAL(image.size(), writer.getWritten());
+    TEST_ASSERT_EQUAL_STRING(sha256Hex(image).c_str(), writer.getDigestHex());
+    TEST_ASSERT_TRUE(writer.isDigestVerified());
+    TEST_ASSERT_TRUE(writer.isSignatureVerified());
+}
+
+void test_signature_alone_is_enough() {
+    // No expected digest and unknown size: the signature still covers the whole image
+    const Bytes image = makeImage(4096);
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(U_SPIFFS, 0, nullptr, signatureHex(image).c_str()));
+    TEST_ASSERT_EQUAL(U_SPIFFS, Update.command);
+    TEST_ASSERT_EQUAL(UPDATE_SIZE_UNKNOWN, Update.beginSize);
+    TEST_ASSERT_TRUE(writeChunked(writer, image, 1000));
+    TEST_ASSERT_TRUE(writer.end());
+    TEST_ASSERT_TRUE(Update.committed);
+    TEST_ASSERT_FALSE(writer.isDigestVerified());
+    TEST_ASSERT_TRUE(writer.isSignatureVerified());
+}
+
+void test_uppercase_digest_is_accepted() {
+    const Bytes image = makeImage(1000);
+    std::string sha = sha256Hex(image);
+    for (char& c : sha) {
+        c = static_cast<char>(toupper(c));
+    }
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, 0, sha.c_str(), signatureHex(image).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, image, 333));
+    TEST_ASSERT_TRUE(writer.end());
+    TEST_ASSERT_TRUE(writer.isDigestVerified());
+}
+
+void test_unsigned_upload_is_refused() {
+    TEST_ASSERT_TRUE(OtaWriter::isSignatureRequired());
+    const Bytes image = makeImage(1000);
+    OtaWriter writer;
+    TEST_ASSERT_FALSE(writer.begin(U_FLASH, image.size(), sha256Hex(image).c_str(), ""));
+    TEST_ASSERT_EQUAL_STRING("Signed image required", writer.getError());
+    TEST_ASSERT_FALSE(Update.begun);
+    TEST_ASSERT_FALSE(writer.write(image.data(), image.size()));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_TRUE(Update.flash.empty());
+}
+
+void test_malformed_digest_and_signature_are_refused() {
+    const Bytes image = makeImage(100);
+    const std::string sig = signatureHex(image);
+    OtaWriter writer;
+
+    TEST_ASSERT_FALSE(writer.begin(U_FLASH, 0, "abcd", sig.c_str()));
+    TEST_ASSERT_EQUAL_STRING("Malformed sha256 (expected 64 hex chars)", writer.getError());
+    std::string badSha = sha256Hex(image);
+    badSha[10] = 'g';
+    TEST_ASSERT_FALSE(writer.begin(U_FLASH, 0, badSha.c_str(), sig.c_str()));
+    TEST_ASSERT_EQUAL_STRING("Malformed sha256 (expected 64 hex chars)", writer.getError());
+
+    TEST_ASSERT_FALSE(writer.begin(U_FLASH, 0, nullptr, "abc"));
+    TEST_ASSERT_EQUAL_STRING("Malformed signature (expected DER as hex)", writer.getError());
+    const std::string tooLong(2 * 300, 'a');
+    TEST_ASSERT_FALSE(writer.begin(U_FLASH, 0, nullptr, tooLong.c_str()));
+    TEST_ASSERT_EQUAL_STRING("Malformed signature (expected DER as hex)", writer.getError());
+
+    TEST_ASSERT_FALSE(Update.begun);
+}
+
+void test_bad_signature_aborts_before_commit() {
+    const Bytes image = makeImage(50000);
+    const Bytes other = makeImage(50001);
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), nullptr, signatureHex(other).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, image, 4096));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_EQUAL_STRING("Invalid image signature", writer.getError());
+    TEST_ASSERT_FALSE(writer.isSignatureVerified());
+    TEST_ASSERT_FALSE(Update.committed);
+    TEST_ASSERT_TRUE(Update.aborted);
+}
+
+void test_digest_mismatch_aborts_before_commit() {
+    const Bytes image = makeImage(50000);
+    Bytes tampered = image;
+    tampered[25000] ^= 0x01;
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), sha256Hex(image).c_str(), signatureHex(image).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, tampered, 4096));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_EQUAL_STRING("SHA-256 mismatch", writer.getError());
+    TEST_ASSERT_FALSE(writer.isDigestVerified());
+    TEST_ASSERT_FALSE(Update.committed);
+    TEST_ASSERT_TRUE(Update.aborted);
+    // The digest reported is that of what was actually written
+    TEST_ASSERT_EQUAL_STRING(sha256Hex(tampered).c_str(), writer.getDigestHex());
+}
+
+void test_size_mismatch_aborts_before_commit() {
+    const Bytes image = makeImage(10000);
+    const Bytes shortImage(image.begin(), image.end() - 1);
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), nullptr, signatureHex(shortImage).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, shortImage, 4096));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_EQUAL_STRING("Image size mismatch", writer.getError());
+    TEST_ASSERT_FALSE(Update.committed);
+    TEST_ASSERT_TRUE(Update.aborted);
+    // A write after the abort fails and keeps the reason
+    TEST_ASSERT_FALSE(writer.write(image.data(), 1));
+    TEST_ASSERT_EQUAL_STRING("Image size mismatch", writer.getError());
+
+    Update.reset();
+    Bytes longImage = image;
+    longImage.push_back(0);
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), nullptr, signatureHex(longImage).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, longImage, 4096));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_EQUAL_STRING("Image size mismatch", writer.getError());
+    TEST_ASSERT_FALSE(Update.committed);
+}
+
+void test_backend_failures_are_reported() {
+    const Bytes image = makeImage(10000);
+    const std::string sig = signatureHex(image);
+    OtaWriter writer;
+
+    Update.failBegin = true;
+    TEST_ASSERT_FALSE(writer.begin(U_FLASH, image.size(), nullptr, sig.c_str()));
+    TEST_ASSERT_EQUAL_STRING("Bad Size Given", writer.getError());
+    TEST_ASSERT_FALSE(writer.isActive());
+
+    Update.reset();
+    Update.failWriteAfter = 5000;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), nullptr, sig.c_str()));
+    TEST_ASSERT_FALSE(writeChunked(writer, image, 4096));
+    TEST_ASSERT_EQUAL_STRING("Flash Write Failed", writer.getError());
+    TEST_ASSERT_TRUE(Update.aborted);
+    TEST_ASSERT_FALSE(writer.isActive());
+    TEST_ASSERT_FALSE(writer.end());
+
+    Update.reset();
+    Update.failEnd = true;
+    TEST_ASSERT_TRUE(writer.begin(U_FLASH, image.size(), nullptr, sig.c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, image, 4096));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_EQUAL_STRING("Magic Byte Failed", writer.getError());
+    TEST_ASSERT_TRUE(Update.aborted);
+}
+
+void test_verify_only_never_touches_update() {
+    const Bytes image = makeImage(30000);
+    OtaWriter writer;
+    TEST_ASSERT_TRUE(writer.begin(OtaWriter::kVerifyOnly, image.size(), sha256Hex(image).c_str(),
+                                  signatureHex(image).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, image, 4096));
+    TEST_ASSERT_TRUE(writer.end());
+    TEST_ASSERT_TRUE(writer.isDigestVerified());
+    TEST_ASSERT_TRUE(writer.isSignatureVerified());
+    TEST_ASSERT_FALSE(Update.begun);
+    TEST_ASSERT_TRUE(Update.flash.empty());
+
+    Bytes tampered = image;
+    tampered[0] ^= 0x80;
+    TEST_ASSERT_TRUE(writer.begin(OtaWriter::kVerifyOnly, image.size(), sha256Hex(image).c_str(),
+                                  signatureHex(image).c_str()));
+    TEST_ASSERT_TRUE(writeChunked(writer, tampered, 4096));
+    TEST_ASSERT_FALSE(writer.end());
+    TEST_ASSERT_EQUAL_STRING("SHA-256 mismatch", writer.getError());
+    TEST_ASSERT_FALSE(Update.begun);
+    TEST_ASSERT_FALSE(Update.aborted);
+}
+
+void test_end_without_begin_and_abort_on_destruction() {
+    OtaWriter idle;
+    const uint8_t byte = 0;
+    TEST_ASSERT_FALSE(idle.write(&byte, 1));
+    TEST_ASSERT_EQUAL_STRING("Update was not started", idle.getError());
+    TEST_ASSERT_FALSE(idle.end());
+    TEST_ASSERT_EQUAL_STRING("Update was not started", idle.getError());
+
+    const Bytes image = makeImage(100);
+    {
+        OtaWriter writer;
+        TEST_ASSERT_TRUE(writer.begin(U_FLASH, 0, nullptr, signatureHex(image).c_str()));
+        TEST_ASSERT_TRUE(writer.write(image.data(), image.size()));
+    }
+    TEST_ASSERT_TRUE(Update.aborted);
+    TEST_ASSERT_FALSE(Update.committed);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_shim_matches_known_vectors);
+    RUN_TEST(test_signed_image_is_committed);
+    RUN_TEST(test_signature_alone_is_enough);
+    RUN_TEST(test_uppercase_digest_is_accepted);
+    RUN_TEST(test_unsigned_upload_is_refused);
+    RUN_TEST(test_malformed_digest_and_signature_are_refused);
+    RUN_TEST(test_bad_signature_aborts_before_commit);
+    RUN_TEST(test_digest_mismatch_aborts_before_commit);
+    RUN_TEST(test_size_mismatch_aborts_before_commit);
+    RUN_TEST(test_backend_failures_are_reported);
+    RUN_TEST(test_verify_only_never_touches_update);
+    RUN_TEST(test_end_without_begin_and_abort_on_destruction);
+    return UNITY_END();
+}
@@ -1,6 +1,11 @@
-import { mkdir, readdir, rm, copyFile } from "node:fs/promises";
+import { mkdir, readdir, rm, copyFile, readFile, writeFile } from "node:fs/promises";
 import path from "node:path";
 import process from "node:process";
+import { gzipSync, constants as zlibConstants } from "node:zlib";
+
+// Text assets worth pre-compressing. The firmware serves "<file>.gz" when the
+// browser sends Accept-Encoding: gzip, so the originals are kept as a fallback.
+const GZIP_EXTENSIONS = new Set([".html", ".js", ".css", ".svg", ".json", ".ico", ".txt"]);
 
 async function copyDir(srcDir, dstDir) {
 	await mkdir(dstDir, { recursive: true });
@@ -17,6 +22,39 @@ async function copyDir(srcDir, dstDir) {
 	}
 }
 
+async function gzipFile(filePath) {
+	const raw = await readFile(filePath);
+	const gz = gzipSync(raw, { level: zlibConstants.Z_BEST_COMPRESSION });
+	if (gz.length >= raw.length) {
+		return { raw: raw.length, out: raw.length };
+	}
+	await writeFile(`${filePath}.gz`, gz);
+	return { raw: raw.length, out: gz.length };
+}
+
+async function gzipDir(dir) {
+	const totals = { raw: 0, out: 0 };
+	let entries = [];
+	try {
+		entries = await readdir(dir, { withFileTypes: true });
+	} catch {
+		return totals;
+	}
+	for (const entry of entries) {
+		const entryPath = path.join(dir, entry.name);
+		if (entry.isDirectory()) {
+			const sub = await gzipDir(entryPath);
+			totals.raw += sub.raw;
+			totals.out += sub.out;
+		} else if (entry.isFile() && GZIP_EXTENSIONS.has(path.extname(entry.name))) {
+			const r = await gzipFile(entryPath);
+			totals.raw += r.raw;
+			totals.out += r.out;
+		}
+	}
+	return totals;
+}
+
 async function main() {
 	// web/dist -> ../data
 	const webRoot = process.cwd();
@@ -33,8 +71,9 @@ async function main() {
 
 	await mkdir(dataDir, { recursive: true });
 
-	// Clean old assets
+	// Clean old assets (and the stale pre-compressed index)
 	await rm(dstAssets, { recursive: true, force: true });
+	await rm(`${dstIndex}.gz`, { force: true });
 
 	// Copy index.html
 	await copyFile(srcIndex, dstIndex);
@@ -46,9 +85,17 @@ async function main() {
 		// If there are no assets, that's fine.
 	}
 
+	// Pre-compress text assets
+	const idx = await gzipFile(dstIndex);
+	const assets = await gzipDir(dstAssets);
+	const raw = idx.raw + assets.raw;
+	const out = idx.out + assets.out;
+	const saved = raw > 0 ? Math.round((1 - out / raw) * 100) : 0;
+
 	console.log(`Copied SPA build to ${dataDir}`);
 	console.log(`- ${path.relative(process.cwd(), dstIndex)}`);
 	console.log(`- ${path.relative(process.cwd(), dstAssets)}`);
+	console.log(`- gzip: ${raw} -> ${out} bytes (${saved}% smaller)`);
 	console.log("Note: data/update/ is preserved.");
 }
 